@@ -0,0 +1,153 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* This is a round-based variant of the Chandy-Misra-Bryant conservative approach:
+ * instead of exchanging null messages, every partition reports the time of its next
+ * event at the end of a round, and each partition may then run up to the earliest
+ * time that any event could possibly arrive from another partition. */
+
+struct _SchedulerLookahead {
+    guint nPartitions;
+
+    /* nPartitions x nPartitions matrix of the minimum latency of any path from the row
+     * partition to the column partition, SIMTIME_MAX if there is no path, or
+     * SIMTIME_INVALID if it is not known */
+    SimulationTime* latencies;
+    /* set whenever the latencies change so we know to recompute distances */
+    gboolean isDirty;
+
+    /* the shortest non-empty path between each pair of partitions through the
+     * latency matrix, cached until the latencies or the minimum change */
+    SimulationTime* distances;
+    SimulationTime distancesMinLookahead;
+
+    MAGIC_DECLARE;
+};
+
+SchedulerLookahead* schedulerlookahead_new(guint nPartitions) {
+    utility_assert(nPartitions > 0);
+
+    SchedulerLookahead* lookahead = g_new0(SchedulerLookahead, 1);
+    MAGIC_INIT(lookahead);
+
+    lookahead->nPartitions = nPartitions;
+    lookahead->latencies = g_new(SimulationTime, nPartitions * nPartitions);
+    lookahead->distances = g_new(SimulationTime, nPartitions * nPartitions);
+
+    schedulerlookahead_reset(lookahead);
+
+    return lookahead;
+}
+
+void schedulerlookahead_free(SchedulerLookahead* lookahead) {
+    MAGIC_ASSERT(lookahead);
+
+    g_free(lookahead->latencies);
+    g_free(lookahead->distances);
+
+    MAGIC_CLEAR(lookahead);
+    g_free(lookahead);
+}
+
+/* latencies is an nPartitions x nPartitions matrix like the one we keep */
+void schedulerlookahead_setLatencies(SchedulerLookahead* lookahead, const SimulationTime* latencies) {
+    MAGIC_ASSERT(lookahead);
+    utility_assert(latencies);
+
+    guint n = lookahead->nPartitions;
+    memcpy(lookahead->latencies, latencies, n * n * sizeof(SimulationTime));
+    lookahead->isDirty = TRUE;
+}
+
+/* forget all latencies, so that every partition may be as close as the minimum lookahead */
+void schedulerlookahead_reset(SchedulerLookahead* lookahead) {
+    MAGIC_ASSERT(lookahead);
+
+    for(guint i = 0; i < lookahead->nPartitions * lookahead->nPartitions; i++) {
+        lookahead->latencies[i] = SIMTIME_INVALID;
+    }
+
+    lookahead->isDirty = TRUE;
+}
+
+static void _schedulerlookahead_computeDistances(SchedulerLookahead* lookahead,
+        SimulationTime minLookahead) {
+    MAGIC_ASSERT(lookahead);
+
+    guint n = lookahead->nPartitions;
+    SimulationTime* d = lookahead->distances;
+
+    /* the direct latencies, never less than the global minimum so that we are never
+     * less efficient than the global window. the diagonal starts out unreachable
+     * so that it ends up holding the shortest cycle back into the partition. */
+    for(guint i = 0; i < n; i++) {
+        for(guint j = 0; j < n; j++) {
+            SimulationTime latency = lookahead->latencies[(i * n) + j];
+            if(i == j || latency == SIMTIME_MAX) {
+                d[(i * n) + j] = SIMTIME_INVALID;
+            } else if(latency == SIMTIME_INVALID) {
+                d[(i * n) + j] = minLookahead;
+            } else {
+                d[(i * n) + j] = MAX(latency, minLookahead);
+            }
+        }
+    }
+
+    /* Floyd-Warshall, an event can reach a partition by way of any other partition */
+    for(guint k = 0; k < n; k++) {
+        for(guint i = 0; i < n; i++) {
+            SimulationTime ik = d[(i * n) + k];
+            if(ik == SIMTIME_INVALID) {
+                continue;
+            }
+            for(guint j = 0; j < n; j++) {
+                SimulationTime kj = d[(k * n) + j];
+                if(kj != SIMTIME_INVALID && ik + kj < d[(i * n) + j]) {
+                    d[(i * n) + j] = ik + kj;
+                }
+            }
+        }
+    }
+
+    lookahead->distancesMinLookahead = minLookahead;
+}
+
+void schedulerlookahead_computeHorizons(SchedulerLookahead* lookahead,
+        const SimulationTime* nextEventTimes, SimulationTime minLookahead,
+        SimulationTime* horizons) {
+    MAGIC_ASSERT(lookahead);
+    utility_assert(nextEventTimes && horizons);
+
+    /* the distances only change rarely, so avoid the cubic update in most rounds */
+    if(lookahead->isDirty || minLookahead != lookahead->distancesMinLookahead) {
+        _schedulerlookahead_computeDistances(lookahead, minLookahead);
+        lookahead->isDirty = FALSE;
+    }
+
+    guint n = lookahead->nPartitions;
+
+    /* a partition may run until the earliest time that an event from any other partition
+     * could arrive there, which includes events it sends out that cause others to reply */
+    for(guint dst = 0; dst < n; dst++) {
+        SimulationTime horizon = SIMTIME_MAX;
+
+        for(guint src = 0; src < n; src++) {
+            SimulationTime next = nextEventTimes[src];
+            SimulationTime distance = lookahead->distances[(src * n) + dst];
+
+            if(next >= SIMTIME_MAX || distance == SIMTIME_INVALID) {
+                continue;
+            }
+
+            /* saturate instead of overflowing */
+            SimulationTime arrival = (next < SIMTIME_MAX - distance) ? next + distance : SIMTIME_MAX;
+            horizon = MIN(horizon, arrival);
+        }
+
+        horizons[dst] = horizon;
+    }
+}
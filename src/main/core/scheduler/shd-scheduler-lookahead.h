@@ -0,0 +1,24 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_SCHEDULER_LOOKAHEAD_H_
+#define SHD_SCHEDULER_LOOKAHEAD_H_
+
+/* Keeps the minimum path latency between each pair of host partitions (the
+ * set of hosts assigned to one worker), and uses it to compute how far ahead
+ * each partition may safely run in the next round. Latencies are set and
+ * horizons are computed between rounds. */
+typedef struct _SchedulerLookahead SchedulerLookahead;
+
+SchedulerLookahead* schedulerlookahead_new(guint nPartitions);
+void schedulerlookahead_free(SchedulerLookahead* lookahead);
+
+void schedulerlookahead_setLatencies(SchedulerLookahead* lookahead, const SimulationTime* latencies);
+void schedulerlookahead_reset(SchedulerLookahead* lookahead);
+void schedulerlookahead_computeHorizons(SchedulerLookahead* lookahead,
+        const SimulationTime* nextEventTimes, SimulationTime minLookahead,
+        SimulationTime* horizons);
+
+#endif /* SHD_SCHEDULER_LOOKAHEAD_H_ */
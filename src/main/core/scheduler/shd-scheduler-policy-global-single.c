@@ -7,7 +7,7 @@
 
 typedef struct _GlobalSinglePolicyData GlobalSinglePolicyData;
 struct _GlobalSinglePolicyData {
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -34,19 +34,15 @@ static void _schedulerpolicyglobalsingle_push(SchedulerPolicy* policy, Event* ev
     GlobalSinglePolicyData* data = policy->data;
 
     event_setSequence(event, ++(data->pushSequenceCounter));
-    priorityqueue_push(data->pq, event);
+    eventqueue_push(data->pq, event);
 }
 
 static Event* _schedulerpolicyglobalsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     GlobalSinglePolicyData* data = policy->data;
 
-    Event* nextEvent = priorityqueue_peek(data->pq);
-    if(!nextEvent) {
-        return NULL;
-    }
-
-    SimulationTime eventTime = event_getTime(nextEvent);
+    /* this is SIMTIME_INVALID, and thus never before the barrier, if the queue is empty */
+    SimulationTime eventTime = eventqueue_peekTime(data->pq);
     if(eventTime >= barrier) {
         return NULL;
     }
@@ -54,14 +50,25 @@ static Event* _schedulerpolicyglobalsingle_pop(SchedulerPolicy* policy, Simulati
     utility_assert(eventTime >= data->lastEventTime);
     data->lastEventTime = eventTime;
 
-    return priorityqueue_pop(data->pq);
+    return eventqueue_pop(data->pq);
+}
+
+static Event* _schedulerpolicyglobalsingle_popForHost(SchedulerPolicy* policy, Host* host, SimulationTime barrier) {
+    MAGIC_ASSERT(policy);
+    GlobalSinglePolicyData* data = policy->data;
+
+    Event* nextEvent = eventqueue_peek(data->pq);
+    if(nextEvent == NULL || event_getHost(nextEvent) != host) {
+        return NULL;
+    }
+
+    return _schedulerpolicyglobalsingle_pop(policy, barrier);
 }
 
 static SimulationTime _schedulerpolicyglobalsingle_getNextTime(SchedulerPolicy* policy) {
     MAGIC_ASSERT(policy);
     GlobalSinglePolicyData* data = policy->data;
-    Event* nextEvent = priorityqueue_peek(data->pq);
-    return (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_MAX;
+    return eventqueue_isEmpty(data->pq) ? SIMTIME_MAX : eventqueue_peekTime(data->pq);
 }
 
 static void _schedulerpolicyglobalsingle_free(SchedulerPolicy* policy) {
@@ -69,7 +76,7 @@ static void _schedulerpolicyglobalsingle_free(SchedulerPolicy* policy) {
     GlobalSinglePolicyData* data = policy->data;
 
     if(data->pq) {
-        priorityqueue_free(data->pq);
+        eventqueue_free(data->pq);
     }
     if(data->assignedHosts) {
         g_queue_free(data->assignedHosts);
@@ -82,7 +89,7 @@ static void _schedulerpolicyglobalsingle_free(SchedulerPolicy* policy) {
 
 SchedulerPolicy* schedulerpolicyglobalsingle_new() {
     GlobalSinglePolicyData* data = g_new0(GlobalSinglePolicyData, 1);
-    data->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    data->pq = eventqueue_new();
     data->assignedHosts = g_queue_new();
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
@@ -91,6 +98,7 @@ SchedulerPolicy* schedulerpolicyglobalsingle_new() {
     policy->getAssignedHosts = _schedulerpolicyglobalsingle_getHosts;
     policy->push = _schedulerpolicyglobalsingle_push;
     policy->pop = _schedulerpolicyglobalsingle_pop;
+    policy->popForHost = _schedulerpolicyglobalsingle_popForHost;
     policy->getNextTime = _schedulerpolicyglobalsingle_getNextTime;
     policy->free = _schedulerpolicyglobalsingle_free;
 
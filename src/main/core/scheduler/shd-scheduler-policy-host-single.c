@@ -7,9 +7,12 @@
 
 typedef struct _HostSingleQueueData HostSingleQueueData;
 struct _HostSingleQueueData {
-    GMutex lock;
-    PriorityQueue* pq;
-    SimulationTime pushSequenceCounter;
+    /* events pushed from other hosts, possibly by other threads. only the thread that
+     * runs this host drains them, so the mailbox is lock-free on both sides. */
+    MPSCQueue* mailbox;
+    /* events that are ready to be popped, only accessed by the thread running this host */
+    EventQueue* pq;
+    volatile SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
     gsize nPopped;
@@ -24,18 +27,44 @@ struct _HostSingleThreadData {
     /* during each round, hosts whose events have been processed are moved from unprocessedHosts to here */
     GQueue* processedHosts;
     SimulationTime currentBarrier;
-    GTimer* pushIdleTime;
-    GTimer* popIdleTime;
 };
 
 typedef struct _HostSinglePolicyData HostSinglePolicyData;
 struct _HostSinglePolicyData {
-    GHashTable* hostToQueueDataMap;
+    /* host index -> queue data */
+    GPtrArray* hostQueueData;
     GHashTable* threadToThreadDataMap;
-    GHashTable* hostToThreadMap;
+    /* host index -> pthread_t, or 0 if the host is not assigned */
+    GArray* hostThreads;
     MAGIC_DECLARE;
 };
 
+static HostSingleQueueData* _schedulerpolicyhostsingle_getQueueData(HostSinglePolicyData* data, Host* host) {
+    guint hostIndex = host_getIndex(host);
+    return hostIndex < data->hostQueueData->len ? g_ptr_array_index(data->hostQueueData, hostIndex) : NULL;
+}
+
+static void _schedulerpolicyhostsingle_setQueueData(HostSinglePolicyData* data, Host* host, HostSingleQueueData* qdata) {
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= data->hostQueueData->len) {
+        g_ptr_array_set_size(data->hostQueueData, (gint)hostIndex + 1);
+    }
+    g_ptr_array_index(data->hostQueueData, hostIndex) = qdata;
+}
+
+static pthread_t _schedulerpolicyhostsingle_getHostThread(HostSinglePolicyData* data, Host* host) {
+    guint hostIndex = host_getIndex(host);
+    return hostIndex < data->hostThreads->len ? g_array_index(data->hostThreads, pthread_t, hostIndex) : 0;
+}
+
+static void _schedulerpolicyhostsingle_setHostThread(HostSinglePolicyData* data, Host* host, pthread_t thread) {
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= data->hostThreads->len) {
+        g_array_set_size(data->hostThreads, hostIndex + 1);
+    }
+    g_array_index(data->hostThreads, pthread_t, hostIndex) = thread;
+}
+
 typedef struct _HostSingleSearchState HostSingleSearchState;
 struct _HostSingleSearchState {
     HostSinglePolicyData* data;
@@ -47,15 +76,6 @@ static HostSingleThreadData* _hostsinglethreaddata_new() {
 
     tdata->unprocessedHosts = g_queue_new();
     tdata->processedHosts = g_queue_new();
-
-    /* Create new timers to track thread idle times. The timers start in a 'started' state,
-     * so we want to stop them immediately so we can continue/stop later around blocking code
-     * to collect total elapsed idle time in the scheduling process throughout the entire
-     * runtime of the program. */
-    tdata->pushIdleTime = g_timer_new();
-    g_timer_stop(tdata->pushIdleTime);
-    tdata->popIdleTime = g_timer_new();
-    g_timer_stop(tdata->popIdleTime);
     return tdata;
 }
 
@@ -71,50 +91,51 @@ static void _hostsinglethreaddata_free(HostSingleThreadData* tdata) {
             g_queue_free(tdata->processedHosts);
         }
 
-        gdouble totalPushWaitTime = 0.0;
-        if(tdata->pushIdleTime) {
-            totalPushWaitTime = g_timer_elapsed(tdata->pushIdleTime, NULL);
-            g_timer_destroy(tdata->pushIdleTime);
-        }
-        gdouble totalPopWaitTime = 0.0;
-        if(tdata->popIdleTime) {
-            totalPopWaitTime = g_timer_elapsed(tdata->popIdleTime, NULL);
-            g_timer_destroy(tdata->popIdleTime);
-        }
-
         g_free(tdata);
-        message("scheduler thread data destroyed, total push wait time was %f seconds, "
-                "total pop wait time was %f seconds", totalPushWaitTime, totalPopWaitTime);
+        message("scheduler thread data destroyed");
     }
 }
 
 static HostSingleQueueData* _hostsinglequeuedata_new() {
     HostSingleQueueData* qdata = g_new0(HostSingleQueueData, 1);
 
-    g_mutex_init(&(qdata->lock));
-    qdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    qdata->mailbox = mpscqueue_new((GDestroyNotify)event_unref);
+    qdata->pq = eventqueue_new();
 
     return qdata;
 }
 
 static void _hostsinglequeuedata_free(HostSingleQueueData* qdata) {
     if(qdata) {
+        if(qdata->mailbox) {
+            mpscqueue_free(qdata->mailbox);
+        }
         if(qdata->pq) {
-            priorityqueue_free(qdata->pq);
+            eventqueue_free(qdata->pq);
         }
-        g_mutex_clear(&(qdata->lock));
         g_free(qdata);
     }
 }
 
+static void _hostsinglequeuedata_receive(Event* event, HostSingleQueueData* qdata) {
+    eventqueue_push(qdata->pq, event);
+    qdata->nPushed++;
+}
+
+/* move all events that were sent to this host into its priority queue.
+ * this must only be called by the thread that runs the host. */
+static void _hostsinglequeuedata_drainMailbox(HostSingleQueueData* qdata) {
+    mpscqueue_drain(qdata->mailbox, (GFunc)_hostsinglequeuedata_receive, qdata);
+}
+
 /* this must be run synchronously, or the call must be protected by locks */
 static void _schedulerpolicyhostsingle_addHost(SchedulerPolicy* policy, Host* host, pthread_t randomThread) {
     MAGIC_ASSERT(policy);
     HostSinglePolicyData* data = policy->data;
 
     /* each host has its own queue */
-    if(!g_hash_table_lookup(data->hostToQueueDataMap, host)) {
-        g_hash_table_replace(data->hostToQueueDataMap, host, _hostsinglequeuedata_new());
+    if(!_schedulerpolicyhostsingle_getQueueData(data, host)) {
+        _schedulerpolicyhostsingle_setQueueData(data, host, _hostsinglequeuedata_new());
     }
 
     /* each thread keeps track of the hosts it needs to run */
@@ -127,7 +148,36 @@ static void _schedulerpolicyhostsingle_addHost(SchedulerPolicy* policy, Host* ho
     g_queue_push_tail(tdata->unprocessedHosts, host);
 
     /* finally, store the host-to-thread mapping */
-    g_hash_table_replace(data->hostToThreadMap, host, GUINT_TO_POINTER(assignedThread));
+    _schedulerpolicyhostsingle_setHostThread(data, host, assignedThread);
+}
+
+/* this must only be called between rounds, while no worker is running events */
+static void _schedulerpolicyhostsingle_migrateHost(SchedulerPolicy* policy, Host* host, pthread_t newThread) {
+    MAGIC_ASSERT(policy);
+    HostSinglePolicyData* data = policy->data;
+
+    pthread_t oldThread = _schedulerpolicyhostsingle_getHostThread(data, host);
+    if(pthread_equal(oldThread, newThread)) {
+        return;
+    }
+
+    HostSingleThreadData* oldTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(oldThread));
+    utility_assert(oldTData);
+    if(!g_queue_remove(oldTData->processedHosts, host)) {
+        g_queue_remove(oldTData->unprocessedHosts, host);
+    }
+
+    HostSingleThreadData* newTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread));
+    if(!newTData) {
+        newTData = _hostsinglethreaddata_new();
+        g_hash_table_replace(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread), newTData);
+    }
+    /* the host will be moved into the unprocessed queue when the next round starts */
+    g_queue_push_tail(newTData->processedHosts, host);
+
+    /* the host keeps its own queue and sequence counter, so event order is unaffected */
+    _schedulerpolicyhostsingle_setHostThread(data, host, newThread);
+    host_migrate(host, &oldThread, &newThread);
 }
 
 static void concat_queue_iter(Host* hostItem, GQueue* userQueue) {
@@ -174,29 +224,39 @@ static void _schedulerpolicyhostsingle_push(SchedulerPolicy* policy, Event* even
                 "to ensure event causality", eventTime, barrier);
     }
 
-    /* we want to track how long this thread spends idle waiting to push the event */
-    HostSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-
     /* get the queue for the destination */
-    HostSingleQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, dstHost);
+    HostSingleQueueData* qdata = _schedulerpolicyhostsingle_getQueueData(data, dstHost);
     utility_assert(qdata);
 
-    /* tracking idle time spent waiting for the destination queue lock */
-    if(tdata) {
-        g_timer_continue(tdata->pushIdleTime);
-    }
-    g_mutex_lock(&(qdata->lock));
-    if(tdata) {
-        g_timer_stop(tdata->pushIdleTime);
+    /* 'deliver' the event to the destination queue. the sequence counter may be shared
+     * by several pushing threads, so it must be incremented atomically. */
+    event_setSequence(event, __atomic_add_fetch(&(qdata->pushSequenceCounter), 1, __ATOMIC_RELAXED));
+
+    if(srcHost == dstHost) {
+        /* we are running the destination host, so we are the only thread using its queue */
+        _hostsinglequeuedata_receive(event, qdata);
+    } else {
+        /* another thread may be running the destination host, hand the event off to it */
+        mpscqueue_push(qdata->mailbox, event);
     }
+}
 
-    /* 'deliver' the event to the destination queue */
-    event_setSequence(event, ++(qdata->pushSequenceCounter));
-    priorityqueue_push(qdata->pq, event);
-    qdata->nPushed++;
+static Event* _hostsinglequeuedata_pop(HostSingleQueueData* qdata, SimulationTime barrier) {
+    _hostsinglequeuedata_drainMailbox(qdata);
+
+    Event* nextEvent;
+    SimulationTime eventTime = eventqueue_peekTime(qdata->pq);
+
+    if(eventTime < barrier) {
+        utility_assert(eventTime >= qdata->lastEventTime);
+        qdata->lastEventTime = eventTime;
+        nextEvent = eventqueue_pop(qdata->pq);
+        qdata->nPopped++;
+    } else {
+        nextEvent = NULL;
+    }
 
-    /* release the destination queue lock */
-    g_mutex_unlock(&(qdata->lock));
+    return nextEvent;
 }
 
 static Event* _schedulerpolicyhostsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
@@ -228,28 +288,10 @@ static Event* _schedulerpolicyhostsingle_pop(SchedulerPolicy* policy, Simulation
 
     while(!g_queue_is_empty(tdata->unprocessedHosts)) {
         Host* host = g_queue_peek_head(tdata->unprocessedHosts);
-        HostSingleQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
+        HostSingleQueueData* qdata = _schedulerpolicyhostsingle_getQueueData(data, host);
         utility_assert(qdata);
 
-        /* tracking idle time spent waiting for the host queue lock */
-        g_timer_continue(tdata->popIdleTime);
-        g_mutex_lock(&(qdata->lock));
-        g_timer_stop(tdata->popIdleTime);
-
-        Event* nextEvent = priorityqueue_peek(qdata->pq);
-        SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
-
-        if(nextEvent != NULL && eventTime < barrier) {
-            utility_assert(eventTime >= qdata->lastEventTime);
-            qdata->lastEventTime = eventTime;
-            nextEvent = priorityqueue_pop(qdata->pq);
-            qdata->nPopped++;
-        } else {
-            nextEvent = NULL;
-        }
-
-        g_mutex_unlock(&(qdata->lock));
-
+        Event* nextEvent = _hostsinglequeuedata_pop(qdata, barrier);
         if(nextEvent != NULL) {
             return nextEvent;
         }
@@ -262,13 +304,32 @@ static Event* _schedulerpolicyhostsingle_pop(SchedulerPolicy* policy, Simulation
     return NULL;
 }
 
+static Event* _schedulerpolicyhostsingle_popForHost(SchedulerPolicy* policy, Host* host, SimulationTime barrier) {
+    MAGIC_ASSERT(policy);
+    HostSinglePolicyData* data = policy->data;
+
+    HostSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
+
+    /* pop always runs the host at the head until it has no more events, so
+     * if that is our host, we get the same event that pop would return */
+    if(!tdata || g_queue_peek_head(tdata->unprocessedHosts) != host) {
+        return NULL;
+    }
+
+    HostSingleQueueData* qdata = _schedulerpolicyhostsingle_getQueueData(data, host);
+    utility_assert(qdata);
+
+    /* if the host is done, the next pop will move it to the processed queue */
+    return _hostsinglequeuedata_pop(qdata, barrier);
+}
+
 static void _schedulerpolicyhostsingle_findMinTime(Host* host, HostSingleSearchState* state) {
-    HostSingleQueueData* qdata = g_hash_table_lookup(state->data->hostToQueueDataMap, host);
+    HostSingleQueueData* qdata = _schedulerpolicyhostsingle_getQueueData(state->data, host);
     utility_assert(qdata);
 
-    g_mutex_lock(&(qdata->lock));
-    Event* event = priorityqueue_peek(qdata->pq);
-    g_mutex_unlock(&(qdata->lock));
+    /* events that arrived during the last round may be earlier than the ones we already have */
+    _hostsinglequeuedata_drainMailbox(qdata);
+    Event* event = eventqueue_peek(qdata->pq);
 
     if(event != NULL) {
         state->nextEventTime = MIN(state->nextEventTime, event_getTime(event));
@@ -300,9 +361,9 @@ static void _schedulerpolicyhostsingle_free(SchedulerPolicy* policy) {
     MAGIC_ASSERT(policy);
     HostSinglePolicyData* data = policy->data;
 
-    g_hash_table_destroy(data->hostToQueueDataMap);
+    g_ptr_array_free(data->hostQueueData, TRUE);
     g_hash_table_destroy(data->threadToThreadDataMap);
-    g_hash_table_destroy(data->hostToThreadMap);
+    g_array_free(data->hostThreads, TRUE);
     g_free(data);
 
     MAGIC_CLEAR(policy);
@@ -311,9 +372,9 @@ static void _schedulerpolicyhostsingle_free(SchedulerPolicy* policy) {
 
 SchedulerPolicy* schedulerpolicyhostsingle_new() {
     HostSinglePolicyData* data = g_new0(HostSinglePolicyData, 1);
-    data->hostToQueueDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_hostsinglequeuedata_free);
+    data->hostQueueData = g_ptr_array_new_with_free_func((GDestroyNotify)_hostsinglequeuedata_free);
     data->threadToThreadDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_hostsinglethreaddata_free);
-    data->hostToThreadMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    data->hostThreads = g_array_new(FALSE, TRUE, sizeof(pthread_t));
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
     MAGIC_INIT(policy);
@@ -321,7 +382,9 @@ SchedulerPolicy* schedulerpolicyhostsingle_new() {
     policy->getAssignedHosts = _schedulerpolicyhostsingle_getHosts;
     policy->push = _schedulerpolicyhostsingle_push;
     policy->pop = _schedulerpolicyhostsingle_pop;
+    policy->popForHost = _schedulerpolicyhostsingle_popForHost;
     policy->getNextTime = _schedulerpolicyhostsingle_getNextTime;
+    policy->migrateHost = _schedulerpolicyhostsingle_migrateHost;
     policy->free = _schedulerpolicyhostsingle_free;
 
     policy->type = SP_PARALLEL_HOST_SINGLE;
@@ -7,45 +7,64 @@
 
 typedef struct _HostStealQueueData HostStealQueueData;
 struct _HostStealQueueData {
-    GMutex lock;
-    PriorityQueue* pq;
-    SimulationTime pushSequenceCounter;
+    /* events pushed from other hosts, possibly by other threads. only the thread that
+     * runs this host drains them, so the mailbox is lock-free on both sides. */
+    MPSCQueue* mailbox;
+    /* events that are ready to be popped, only accessed by the thread running this host */
+    EventQueue* pq;
+    volatile SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
     gsize nPopped;
+    /* the worker thread that currently holds this host's thread-local storage.
+     * only the thread that is running (or has last run) the host may access this. */
+    pthread_t ownerThread;
 };
 
 typedef struct _HostStealThreadData HostStealThreadData;
 struct _HostStealThreadData {
-    /* used to cache getHosts() result for memory management as needed*/
-    GQueue* allHosts;
-    /* All hosts that have been assigned to this worker for event processing that have not
-     * been started this round. Other than the first round, this is last round's processedHosts. */
-    GQueue* unprocessedHosts;
-    /* during each round, hosts whose events have been processed are moved from some thread's
-     * unprocessedHosts to here, via runningHost */
+    /* hosts that are available to run this round. only this worker pushes and pops from
+     * the bottom of the deque; all other workers may steal from the top without locking. */
+    WorkStealingDeque* runnableHosts;
+    /* during each round, hosts whose events have been processed are moved here, via
+     * runningHost. this queue is private to the worker, and its hosts become this worker's
+     * runnableHosts in the next round. */
     GQueue* processedHosts;
-    /* the host this worker is running; belongs to neither unprocessedHosts nor processedHosts */
+    /* the host this worker is running; belongs to neither runnableHosts nor processedHosts */
     Host* runningHost;
     SimulationTime currentBarrier;
-    GTimer* pushIdleTime;
-    GTimer* popIdleTime;
     /* which worker thread this is */
     guint tnumber;
-    GMutex lock;
+    /* how many hosts this worker took from other workers */
+    gsize nStolen;
 };
 
+/* all of the tables in this struct are only modified while hosts are being assigned,
+ * which happens synchronously before the workers start running events. after that
+ * they are read-only and can be accessed by all workers without locking. */
 typedef struct _HostStealPolicyData HostStealPolicyData;
 struct _HostStealPolicyData {
     GArray* threadList;
     guint threadCount;
-    GHashTable* hostToQueueDataMap;
+    /* host index -> queue data */
+    GPtrArray* hostQueueData;
     GHashTable* threadToThreadDataMap;
-    GHashTable* hostToThreadMap;
-    GRWLock lock;
     MAGIC_DECLARE;
 };
 
+static HostStealQueueData* _schedulerpolicyhoststeal_getQueueData(HostStealPolicyData* data, Host* host) {
+    guint hostIndex = host_getIndex(host);
+    return hostIndex < data->hostQueueData->len ? g_ptr_array_index(data->hostQueueData, hostIndex) : NULL;
+}
+
+static void _schedulerpolicyhoststeal_setQueueData(HostStealPolicyData* data, Host* host, HostStealQueueData* qdata) {
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= data->hostQueueData->len) {
+        g_ptr_array_set_size(data->hostQueueData, (gint)hostIndex + 1);
+    }
+    g_ptr_array_index(data->hostQueueData, hostIndex) = qdata;
+}
+
 typedef struct _HostStealSearchState HostStealSearchState;
 struct _HostStealSearchState {
     HostStealPolicyData* data;
@@ -55,162 +74,124 @@ struct _HostStealSearchState {
 static HostStealThreadData* _hoststealthreaddata_new() {
     HostStealThreadData* tdata = g_new0(HostStealThreadData, 1);
 
-    tdata->unprocessedHosts = g_queue_new();
+    tdata->runnableHosts = workstealingdeque_new(0);
     tdata->processedHosts = g_queue_new();
-
-    /* Create new timers to track thread idle times. The timers start in a 'started' state,
-     * so we want to stop them immediately so we can continue/stop later around blocking code
-     * to collect total elapsed idle time in the scheduling process throughout the entire
-     * runtime of the program. */
-    tdata->pushIdleTime = g_timer_new();
-    g_timer_stop(tdata->pushIdleTime);
-    tdata->popIdleTime = g_timer_new();
-    g_timer_stop(tdata->popIdleTime);
-    g_mutex_init(&(tdata->lock));
     tdata->runningHost = NULL;
     return tdata;
 }
 
 static void _hoststealthreaddata_free(HostStealThreadData* tdata) {
     if(tdata) {
-        if(tdata->allHosts) {
-            g_queue_free(tdata->allHosts);
-        }
-        if(tdata->unprocessedHosts) {
-            g_queue_free(tdata->unprocessedHosts);
+        if(tdata->runnableHosts) {
+            workstealingdeque_free(tdata->runnableHosts);
         }
         if(tdata->processedHosts) {
             g_queue_free(tdata->processedHosts);
         }
 
-        gdouble totalPushWaitTime = 0.0;
-        if(tdata->pushIdleTime) {
-            totalPushWaitTime = g_timer_elapsed(tdata->pushIdleTime, NULL);
-            g_timer_destroy(tdata->pushIdleTime);
-        }
-        gdouble totalPopWaitTime = 0.0;
-        if(tdata->popIdleTime) {
-            totalPopWaitTime = g_timer_elapsed(tdata->popIdleTime, NULL);
-            g_timer_destroy(tdata->popIdleTime);
-        }
-
+        message("scheduler thread data destroyed, stole %"G_GSIZE_FORMAT" hosts", tdata->nStolen);
         g_free(tdata);
-        message("scheduler thread data destroyed, total push wait time was %f seconds, "
-                "total pop wait time was %f seconds", totalPushWaitTime, totalPopWaitTime);
     }
 }
 
 static HostStealQueueData* _hoststealqueuedata_new() {
     HostStealQueueData* qdata = g_new0(HostStealQueueData, 1);
 
-    g_mutex_init(&(qdata->lock));
-    qdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    qdata->mailbox = mpscqueue_new((GDestroyNotify)event_unref);
+    qdata->pq = eventqueue_new();
 
     return qdata;
 }
 
 static void _hoststealqueuedata_free(HostStealQueueData* qdata) {
     if(qdata) {
+        if(qdata->mailbox) {
+            mpscqueue_free(qdata->mailbox);
+        }
         if(qdata->pq) {
-            priorityqueue_free(qdata->pq);
+            eventqueue_free(qdata->pq);
         }
-        g_mutex_clear(&(qdata->lock));
         g_free(qdata);
     }
 }
 
-/* this must be run synchronously, or the thread must be protected by locks */
+static void _hoststealqueuedata_receive(Event* event, HostStealQueueData* qdata) {
+    eventqueue_push(qdata->pq, event);
+    qdata->nPushed++;
+}
+
+/* move all events that were sent to this host into its priority queue.
+ * this must only be called by the thread that runs the host. */
+static void _hoststealqueuedata_drainMailbox(HostStealQueueData* qdata) {
+    mpscqueue_drain(qdata->mailbox, (GFunc)_hoststealqueuedata_receive, qdata);
+}
+
+/* this must be run synchronously, or the call must be protected by locks */
 static void _schedulerpolicyhoststeal_addHost(SchedulerPolicy* policy, Host* host, pthread_t randomThread) {
     MAGIC_ASSERT(policy);
     HostStealPolicyData* data = policy->data;
 
-    /* each host has its own queue
-     * we don't read lock data->lock because we only modify the table here anyway
-     */
-    if(!g_hash_table_lookup(data->hostToQueueDataMap, host)) {
-        g_rw_lock_writer_lock(&data->lock);
-        g_hash_table_replace(data->hostToQueueDataMap, host, _hoststealqueuedata_new());
-        g_rw_lock_writer_unlock(&data->lock);
-    }
-
     /* each thread keeps track of the hosts it needs to run */
     pthread_t assignedThread = (randomThread != 0) ? randomThread : pthread_self();
-    g_rw_lock_reader_lock(&data->lock);
+
+    /* each host has its own queue */
+    HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(data, host);
+    if(!qdata) {
+        qdata = _hoststealqueuedata_new();
+        _schedulerpolicyhoststeal_setQueueData(data, host, qdata);
+    }
+    qdata->ownerThread = assignedThread;
+
     HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(assignedThread));
-    g_rw_lock_reader_unlock(&data->lock);
     if(!tdata) {
         tdata = _hoststealthreaddata_new();
-        g_rw_lock_writer_lock(&data->lock);
         g_hash_table_replace(data->threadToThreadDataMap, GUINT_TO_POINTER(assignedThread), tdata);
         tdata->tnumber = data->threadCount;
         data->threadCount++;
         g_array_append_val(data->threadList, tdata);
-    } else {
-        g_rw_lock_writer_lock(&data->lock);
-    }
-    /* store the host-to-thread mapping */
-    g_hash_table_replace(data->hostToThreadMap, host, GUINT_TO_POINTER(assignedThread));
-    g_rw_lock_writer_unlock(&data->lock);
-    /* if the target thread is stealing the host, we don't want to add it twice */
-    if(host != tdata->runningHost) {
-        g_queue_push_tail(tdata->unprocessedHosts, host);
     }
+
+    /* the host will be made runnable when the worker starts its first round */
+    g_queue_push_tail(tdata->processedHosts, host);
 }
 
-/* primarily a wrapper for dealing with TLS and the hostToThread map.
- * this does not affect unprocessedHosts/processedHosts/runningHost;
- * that migration should be done as normal (from/to the respective threads) */
-static void _schedulerpolicyhoststeal_migrateHost(SchedulerPolicy* policy, Host* host, pthread_t newThread) {
-    MAGIC_ASSERT(policy);
-    HostStealPolicyData* data = policy->data;
-    g_rw_lock_reader_lock(&data->lock);
-    pthread_t oldThread = (pthread_t)g_hash_table_lookup(data->hostToThreadMap, host);
-    if(oldThread == newThread) {
-        g_rw_lock_reader_unlock(&data->lock);
-        return;
-    }
-    HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(oldThread));
-    HostStealThreadData* tdataNew = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread));
-    g_rw_lock_reader_unlock(&data->lock);
-    /* check that there's actually a thread we're migrating from */
-    if(tdata) {
-        /* Sanity check that the host isn't being run on another thread while migrating.
-         * Ostensibly, we could make this check on *all* threads, but this is simpler, faster,
-         * and should catch most bugs (since it's presumably the thread we're stealing from
-         * that would be running it).
-         */
-        utility_assert(tdata->runningHost != tdataNew->runningHost);
+/* move the host's thread-local state to the calling worker thread. this must only be
+ * called by the worker that currently holds the host (as its running host or in its
+ * processed queue), so that no other thread is accessing the host during migration.
+ * stolen hosts are migrated lazily when they have an event to run, so that stealing a
+ * host with nothing left to do this round does not cost a TLS swap. */
+static void _schedulerpolicyhoststeal_migrateHost(HostStealQueueData* qdata, Host* host) {
+    pthread_t oldThread = qdata->ownerThread;
+    pthread_t newThread = pthread_self();
+
+    if(oldThread != newThread) {
         /* migrate the TLS of all objects associated with this host */
         host_migrate(host, &oldThread, &newThread);
+        qdata->ownerThread = newThread;
     }
-    _schedulerpolicyhoststeal_addHost(policy, host, newThread);
-}
-
-static void concat_queue_iter(Host* hostItem, GQueue* userQueue) {
-    g_queue_push_tail(userQueue, hostItem);
 }
 
 static GQueue* _schedulerpolicyhoststeal_getHosts(SchedulerPolicy* policy) {
     MAGIC_ASSERT(policy);
     HostStealPolicyData* data = policy->data;
-    g_rw_lock_reader_lock(&data->lock);
     HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-    g_rw_lock_reader_unlock(&data->lock);
     if(!tdata) {
         return NULL;
     }
-    if(g_queue_is_empty(tdata->unprocessedHosts)) {
-        return tdata->processedHosts;
-    }
-    if(g_queue_is_empty(tdata->processedHosts)) {
-        return tdata->unprocessedHosts;
-    }
-    if(tdata->allHosts) {
-        g_queue_free(tdata->allHosts);
+    /* this is only called before the first round and after the last round, when every
+     * host that this worker owns is waiting in its processed queue */
+    utility_assert(tdata->runningHost == NULL);
+    utility_assert(workstealingdeque_isEmpty(tdata->runnableHosts));
+
+    /* the caller will run code for these hosts, so we must hold their state */
+    for(GList* item = g_queue_peek_head_link(tdata->processedHosts); item != NULL; item = item->next) {
+        Host* host = item->data;
+        HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(data, host);
+        utility_assert(qdata);
+        _schedulerpolicyhoststeal_migrateHost(qdata, host);
     }
-    tdata->allHosts = g_queue_copy(tdata->processedHosts);
-    g_queue_foreach(tdata->unprocessedHosts, (GFunc)concat_queue_iter, tdata->allHosts);
-    return tdata->allHosts;
+
+    return tdata->processedHosts;
 }
 
 static void _schedulerpolicyhoststeal_push(SchedulerPolicy* policy, Event* event, Host* srcHost, Host* dstHost, SimulationTime barrier) {
@@ -232,186 +213,144 @@ static void _schedulerpolicyhoststeal_push(SchedulerPolicy* policy, Event* event
                 "to ensure event causality", eventTime, barrier);
     }
 
-    g_rw_lock_reader_lock(&data->lock);
-    /* we want to track how long this thread spends idle waiting to push the event */
-    HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-
     /* get the queue for the destination */
-    HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, dstHost);
-    g_rw_lock_reader_unlock(&data->lock);
+    HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(data, dstHost);
     utility_assert(qdata);
 
-    /* tracking idle time spent waiting for the destination queue lock */
-    if(tdata) {
-        g_timer_continue(tdata->pushIdleTime);
-        g_mutex_lock(&(tdata->lock));
+    /* 'deliver' the event to the destination queue. the sequence counter may be shared
+     * by several pushing threads, so it must be incremented atomically. */
+    event_setSequence(event, __atomic_add_fetch(&(qdata->pushSequenceCounter), 1, __ATOMIC_RELAXED));
+
+    if(srcHost == dstHost) {
+        /* we are running the destination host, so we are the only thread using its queue */
+        _hoststealqueuedata_receive(event, qdata);
+    } else {
+        /* another thread may be running the destination host, hand the event off to it */
+        mpscqueue_push(qdata->mailbox, event);
     }
-    g_mutex_lock(&(qdata->lock));
-    if(tdata) {
-        g_timer_stop(tdata->pushIdleTime);
+}
+
+static Event* _schedulerpolicyhoststeal_popFromHost(HostStealQueueData* qdata, SimulationTime barrier) {
+    _hoststealqueuedata_drainMailbox(qdata);
+
+    Event* nextEvent;
+    SimulationTime eventTime = eventqueue_peekTime(qdata->pq);
+
+    if(eventTime < barrier) {
+        utility_assert(eventTime >= qdata->lastEventTime);
+        qdata->lastEventTime = eventTime;
+        nextEvent = eventqueue_pop(qdata->pq);
+        qdata->nPopped++;
+    } else {
+        nextEvent = NULL;
     }
 
-    /* 'deliver' the event to the destination queue */
-    event_setSequence(event, ++(qdata->pushSequenceCounter));
-    priorityqueue_push(qdata->pq, event);
-    qdata->nPushed++;
+    return nextEvent;
+}
 
-    /* release the destination queue lock */
-    g_mutex_unlock(&(qdata->lock));
-    if(tdata) {
-        g_mutex_unlock(&(tdata->lock));
+static Host* _schedulerpolicyhoststeal_stealHost(HostStealPolicyData* data, HostStealThreadData* tdata) {
+    guint n = data->threadCount;
+
+    /* visit the other workers in order starting with our neighbor, so that the thieves
+     * spread out over the victims instead of all hitting the same deque */
+    for(guint i = 1; i < n; i++) {
+        guint stolenTnumber = (i + tdata->tnumber) % n;
+        HostStealThreadData* stolenTdata = g_array_index(data->threadList, HostStealThreadData*, stolenTnumber);
+
+        Host* host = workstealingdeque_steal(stolenTdata->runnableHosts);
+        if(host != NULL) {
+            tdata->nStolen++;
+            return host;
+        }
     }
+
+    return NULL;
 }
 
-static Event* _schedulerpolicyhoststeal_popFromThread(SchedulerPolicy* policy, HostStealThreadData* tdata, GQueue* assignedHosts, SimulationTime barrier) {
+static Event* _schedulerpolicyhoststeal_pop(SchedulerPolicy* policy, SimulationTime barrier) {
+    MAGIC_ASSERT(policy);
+    HostStealPolicyData* data = policy->data;
+
+    HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
     /* if there is no tdata, that means this thread didn't get any hosts assigned to it */
     if(!tdata) {
+        /* this thread will remain idle */
         return NULL;
     }
 
-    HostStealPolicyData* data = policy->data;
+    if(barrier > tdata->currentBarrier) {
+        tdata->currentBarrier = barrier;
+
+        /* make sure all of the hosts that were processed last time get processed in the next
+         * round. other workers may start stealing these as soon as we push them. */
+        while(!g_queue_is_empty(tdata->processedHosts)) {
+            workstealingdeque_push(tdata->runnableHosts, g_queue_pop_head(tdata->processedHosts));
+        }
+    }
 
-    while(!g_queue_is_empty(assignedHosts) || tdata->runningHost) {
+    while(TRUE) {
         /* if there's no running host, we completed the last assignment and need a new one */
         if(!tdata->runningHost) {
-            tdata->runningHost = g_queue_pop_head(assignedHosts);
-        }
-        Host* host = tdata->runningHost;
-        g_rw_lock_reader_lock(&data->lock);
-        HostStealQueueData* qdata = g_hash_table_lookup(data->hostToQueueDataMap, host);
-        g_rw_lock_reader_unlock(&data->lock);
-        utility_assert(qdata);
+            /* first, we try to pop a host from this thread's deque */
+            Host* host = workstealingdeque_pop(tdata->runnableHosts);
 
-        g_mutex_lock(&(qdata->lock));
-        Event* nextEvent = priorityqueue_peek(qdata->pq);
-        SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
+            /* no more hosts with events on this thread, try to steal a host from the other threads */
+            if(!host) {
+                host = _schedulerpolicyhoststeal_stealHost(data, tdata);
 
-        if(nextEvent != NULL && eventTime < barrier) {
-            utility_assert(eventTime >= qdata->lastEventTime);
-            qdata->lastEventTime = eventTime;
-            nextEvent = priorityqueue_pop(qdata->pq);
-            qdata->nPopped++;
-            /* migrate iff a migration is needed */
-            _schedulerpolicyhoststeal_migrateHost(policy, host, pthread_self());
-        } else {
-            nextEvent = NULL;
-        }
+                if(!host) {
+                    /* all hosts have been taken by some worker this round */
+                    return NULL;
+                }
+            }
 
-        if(nextEvent == NULL) {
-            /* no more events on the runningHost, mark it as NULL so we get a new one */
-            g_queue_push_tail(tdata->processedHosts, host);
-            tdata->runningHost = NULL;
+            tdata->runningHost = host;
         }
 
-        g_mutex_unlock(&(qdata->lock));
+        Host* host = tdata->runningHost;
+        HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(data, host);
+        utility_assert(qdata);
+
+        Event* nextEvent = _schedulerpolicyhoststeal_popFromHost(qdata, barrier);
 
         if(nextEvent != NULL) {
+            /* migrate iff a migration is needed */
+            _schedulerpolicyhoststeal_migrateHost(qdata, host);
             return nextEvent;
         }
-    }
 
-    /* if we make it here, all hosts for this thread have no more events before barrier */
-    return NULL;
+        /* no more events on the runningHost, mark it as NULL so we get a new one */
+        g_queue_push_tail(tdata->processedHosts, host);
+        tdata->runningHost = NULL;
+    }
 }
 
-static Event* _schedulerpolicyhoststeal_pop(SchedulerPolicy* policy, SimulationTime barrier) {
+static Event* _schedulerpolicyhoststeal_popForHost(SchedulerPolicy* policy, Host* host, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     HostStealPolicyData* data = policy->data;
 
-    /* first, we try to pop a host from this thread's queue */
-    g_rw_lock_reader_lock(&data->lock);
     HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-    g_rw_lock_reader_unlock(&data->lock);
-
-    /* we only need to lock this thread's lock, since it's our own queue */
-    g_timer_continue(tdata->popIdleTime);
-    g_mutex_lock(&(tdata->lock));
-    g_timer_stop(tdata->popIdleTime);
 
-    if(tdata != NULL && barrier > tdata->currentBarrier) {
-        tdata->currentBarrier = barrier;
-
-        /* make sure all of the hosts that were processed last time get processed in the next round */
-        if(g_queue_is_empty(tdata->unprocessedHosts) && !g_queue_is_empty(tdata->processedHosts)) {
-            GQueue* swap = tdata->unprocessedHosts;
-            tdata->unprocessedHosts = tdata->processedHosts;
-            tdata->processedHosts = swap;
-        } else {
-            while(!g_queue_is_empty(tdata->processedHosts)) {
-                g_queue_push_tail(tdata->unprocessedHosts, g_queue_pop_head(tdata->processedHosts));
-            }
-        }
-    }
-    /* attempt to get an event from this thread's queue */
-    Event* nextEvent = _schedulerpolicyhoststeal_popFromThread(policy, tdata, tdata->unprocessedHosts, barrier);
-    g_mutex_unlock(&(tdata->lock));
-    if(nextEvent != NULL) {
-        return nextEvent;
+    /* pop keeps running the same host until it has no more events, and a running
+     * host is not in any deque so it can not be stolen from us in the meantime */
+    if(!tdata || tdata->runningHost != host) {
+        return NULL;
     }
 
-    /* no more hosts with events on this thread, try to steal a host from the other threads' queues */
-    GHashTableIter iter;
-    gpointer key, value;
-    g_rw_lock_reader_lock(&data->lock);
-    guint i, n = data->threadCount;
-    g_rw_lock_reader_unlock(&data->lock);
-    for(i = 1; i < n; i++) {
-        guint stolenTnumber = (i + tdata->tnumber) % n;
-        g_rw_lock_reader_lock(&data->lock);
-        HostStealThreadData* stolenTdata = g_array_index(data->threadList, HostStealThreadData*, stolenTnumber);
-        g_rw_lock_reader_unlock(&data->lock);
-        /* We don't need a lock here, because we're only reading, and a misread just means either
-         * we read as empty when it's not, in which case the assigned thread (or one of the others)
-         * will pick it up anyway, or it reads as non-empty when it is empty, in which case we'll
-         * just get a NULL event and move on. Accepting this reduces lock contention towards the end
-         * of every round. */
-        if(g_queue_is_empty(stolenTdata->unprocessedHosts)) {
-            continue;
-        }
-        /* We need to lock the thread we're stealing from, to be sure that we're not stealing
-         * something already being stolen, as well as our own lock, to be sure nobody steals
-         * what we just stole. But we also need to do this in a well-ordered manner, to
-         * prevent deadlocks. To do this, we always lock the lock with the smaller thread
-         * number first. */
-        g_timer_continue(tdata->popIdleTime);
-        if(tdata->tnumber < stolenTnumber) {
-            g_mutex_lock(&(tdata->lock));
-            g_mutex_lock(&(stolenTdata->lock));
-        } else {
-            g_mutex_lock(&(stolenTdata->lock));
-            g_mutex_lock(&(tdata->lock));
-        }
-        g_timer_stop(tdata->popIdleTime);
-
-        /* attempt to get event from the other thread's queue, likely moving a host from its
-         * unprocessedHosts into this threads runningHost (and eventually processedHosts) */
-        nextEvent = _schedulerpolicyhoststeal_popFromThread(policy, tdata, stolenTdata->unprocessedHosts, barrier);
-
-        /* must unlock in reverse order of locking */
-        if(tdata->tnumber < stolenTnumber) {
-            g_mutex_unlock(&(stolenTdata->lock));
-            g_mutex_unlock(&(tdata->lock));
-        } else {
-            g_mutex_unlock(&(tdata->lock));
-            g_mutex_unlock(&(stolenTdata->lock));
-        }
+    HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(data, host);
+    utility_assert(qdata);
 
-        if(nextEvent != NULL) {
-            break;
-        }
-    }
-    return nextEvent;
+    /* if the host is done, the next pop will move it to the processed queue */
+    return _schedulerpolicyhoststeal_popFromHost(qdata, barrier);
 }
 
 static void _schedulerpolicyhoststeal_findMinTime(Host* host, HostStealSearchState* state) {
-    g_rw_lock_reader_lock(&state->data->lock);
-    HostStealQueueData* qdata = g_hash_table_lookup(state->data->hostToQueueDataMap, host);
-    g_rw_lock_reader_unlock(&state->data->lock);
+    HostStealQueueData* qdata = _schedulerpolicyhoststeal_getQueueData(state->data, host);
     utility_assert(qdata);
 
-    g_mutex_lock(&(qdata->lock));
-    Event* event = priorityqueue_peek(qdata->pq);
-    g_mutex_unlock(&(qdata->lock));
+    /* events that arrived during the last round may be earlier than the ones we already have */
+    _hoststealqueuedata_drainMailbox(qdata);
+    Event* event = eventqueue_peek(qdata->pq);
 
     if(event != NULL) {
         state->nextEventTime = MIN(state->nextEventTime, event_getTime(event));
@@ -428,12 +367,10 @@ static SimulationTime _schedulerpolicyhoststeal_getNextTime(SchedulerPolicy* pol
     searchState.data = data;
     searchState.nextEventTime = SIMTIME_MAX;
 
-    g_rw_lock_reader_lock(&data->lock);
     HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
-    g_rw_lock_reader_unlock(&data->lock);
     if(tdata) {
-        /* make sure we get all hosts, which are probably held in the processedHosts queue between rounds */
-        g_queue_foreach(tdata->unprocessedHosts, (GFunc)_schedulerpolicyhoststeal_findMinTime, &searchState);
+        /* between rounds, all hosts this worker ran in the last round are in its processed queue */
+        utility_assert(tdata->runningHost == NULL);
         g_queue_foreach(tdata->processedHosts, (GFunc)_schedulerpolicyhoststeal_findMinTime, &searchState);
     }
     info("next event at time %"G_GUINT64_FORMAT, searchState.nextEventTime);
@@ -441,14 +378,20 @@ static SimulationTime _schedulerpolicyhoststeal_getNextTime(SchedulerPolicy* pol
     return searchState.nextEventTime;
 }
 
+static gsize _schedulerpolicyhoststeal_getNumStolen(SchedulerPolicy* policy) {
+    MAGIC_ASSERT(policy);
+    HostStealPolicyData* data = policy->data;
+    HostStealThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
+    return (tdata != NULL) ? tdata->nStolen : 0;
+}
+
 static void _schedulerpolicyhoststeal_free(SchedulerPolicy* policy) {
     MAGIC_ASSERT(policy);
     HostStealPolicyData* data = policy->data;
 
-    g_hash_table_destroy(data->hostToQueueDataMap);
+    g_ptr_array_free(data->hostQueueData, TRUE);
     g_hash_table_destroy(data->threadToThreadDataMap);
-    g_hash_table_destroy(data->hostToThreadMap);
-    g_rw_lock_clear(&data->lock);
+    g_array_free(data->threadList, TRUE);
     g_free(data);
 
     MAGIC_CLEAR(policy);
@@ -458,10 +401,8 @@ static void _schedulerpolicyhoststeal_free(SchedulerPolicy* policy) {
 SchedulerPolicy* schedulerpolicyhoststeal_new() {
     HostStealPolicyData* data = g_new0(HostStealPolicyData, 1);
     data->threadList = g_array_new(FALSE, FALSE, sizeof(HostStealThreadData*));
-    data->hostToQueueDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_hoststealqueuedata_free);
+    data->hostQueueData = g_ptr_array_new_with_free_func((GDestroyNotify)_hoststealqueuedata_free);
     data->threadToThreadDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_hoststealthreaddata_free);
-    data->hostToThreadMap = g_hash_table_new(g_direct_hash, g_direct_equal);
-    g_rw_lock_init(&data->lock);
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
     MAGIC_INIT(policy);
@@ -469,7 +410,9 @@ SchedulerPolicy* schedulerpolicyhoststeal_new() {
     policy->getAssignedHosts = _schedulerpolicyhoststeal_getHosts;
     policy->push = _schedulerpolicyhoststeal_push;
     policy->pop = _schedulerpolicyhoststeal_pop;
+    policy->popForHost = _schedulerpolicyhoststeal_popForHost;
     policy->getNextTime = _schedulerpolicyhoststeal_getNextTime;
+    policy->getNumStolen = _schedulerpolicyhoststeal_getNumStolen;
     policy->free = _schedulerpolicyhoststeal_free;
 
     policy->type = SP_PARALLEL_HOST_STEAL;
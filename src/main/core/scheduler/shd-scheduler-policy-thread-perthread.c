@@ -7,7 +7,7 @@
 
 typedef struct _ThreadPerThreadQueueData ThreadPerThreadQueueData;
 struct _ThreadPerThreadQueueData {
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -28,14 +28,28 @@ struct _ThreadPerThreadThreadData {
 typedef struct _ThreadPerThreadPolicyData ThreadPerThreadPolicyData;
 struct _ThreadPerThreadPolicyData {
     GHashTable* threadToThreadDataMap;
-    GHashTable* hostToThreadMap;
+    /* host index -> pthread_t, or 0 if the host is not assigned */
+    GArray* hostThreads;
     MAGIC_DECLARE;
 };
 
+static pthread_t _schedulerpolicythreadperthread_getHostThread(ThreadPerThreadPolicyData* data, Host* host) {
+    guint hostIndex = host_getIndex(host);
+    return hostIndex < data->hostThreads->len ? g_array_index(data->hostThreads, pthread_t, hostIndex) : 0;
+}
+
+static void _schedulerpolicythreadperthread_setHostThread(ThreadPerThreadPolicyData* data, Host* host, pthread_t thread) {
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= data->hostThreads->len) {
+        g_array_set_size(data->hostThreads, hostIndex + 1);
+    }
+    g_array_index(data->hostThreads, pthread_t, hostIndex) = thread;
+}
+
 static ThreadPerThreadQueueData* _threadperthreadqueuedata_new() {
     ThreadPerThreadQueueData* qdata = g_new0(ThreadPerThreadQueueData, 1);
 
-    qdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    qdata->pq = eventqueue_new();
 
     return qdata;
 }
@@ -43,7 +57,7 @@ static ThreadPerThreadQueueData* _threadperthreadqueuedata_new() {
 static void _threadperthreadqueuedata_free(ThreadPerThreadQueueData* qdata) {
     if(qdata) {
         if(qdata->pq) {
-            priorityqueue_free(qdata->pq);
+            eventqueue_free(qdata->pq);
         }
         g_free(qdata);
     }
@@ -51,7 +65,7 @@ static void _threadperthreadqueuedata_free(ThreadPerThreadQueueData* qdata) {
 
 static ThreadPerThreadThreadData* _threadperthreadthreaddata_new() {
     ThreadPerThreadThreadData* tdata = g_new0(ThreadPerThreadThreadData, 1);
-    tdata->threadToPQueueMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)priorityqueue_free);
+    tdata->threadToPQueueMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)eventqueue_free);
     tdata->qdata = _threadperthreadqueuedata_new();
     tdata->assignedHosts = g_queue_new();
     g_mutex_init(&(tdata->lock));
@@ -87,7 +101,47 @@ static void _schedulerpolicythreadperthread_addHost(SchedulerPolicy* policy, Hos
     g_queue_push_tail(tdata->assignedHosts, host);
 
     /* finally, store the host-to-thread mapping */
-    g_hash_table_replace(data->hostToThreadMap, host, GUINT_TO_POINTER(assignedThread));
+    _schedulerpolicythreadperthread_setHostThread(data, host, assignedThread);
+}
+
+/* this must only be called between rounds, while no worker is running events. the
+ * future events of all threads were already moved into the main queues when the
+ * workers collected their next event times, so we only need to look there. */
+static void _schedulerpolicythreadperthread_migrateHost(SchedulerPolicy* policy, Host* host, pthread_t newThread) {
+    MAGIC_ASSERT(policy);
+    ThreadPerThreadPolicyData* data = policy->data;
+
+    pthread_t oldThread = _schedulerpolicythreadperthread_getHostThread(data, host);
+    if(pthread_equal(oldThread, newThread)) {
+        return;
+    }
+
+    ThreadPerThreadThreadData* oldTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(oldThread));
+    utility_assert(oldTData);
+    g_queue_remove(oldTData->assignedHosts, host);
+
+    ThreadPerThreadThreadData* newTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread));
+    if(!newTData) {
+        newTData = _threadperthreadthreaddata_new();
+        g_hash_table_replace(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread), newTData);
+    }
+    g_queue_push_tail(newTData->assignedHosts, host);
+
+    /* the sequence numbers of the host's events came from the old thread's counter. give
+     * them new ones from the new thread's counter, in order, so that they are neither
+     * reordered among themselves nor ahead of events that the new thread already has. */
+    GQueue* events = eventqueue_removeHostEvents(oldTData->qdata->pq, host);
+    while(!g_queue_is_empty(events)) {
+        Event* event = g_queue_pop_head(events);
+        event_setSequence(event, ++(newTData->qdata->pushSequenceCounter));
+        eventqueue_push(newTData->qdata->pq, event);
+        newTData->qdata->lastEventTime = MIN(newTData->qdata->lastEventTime, event_getTime(event));
+        newTData->qdata->nPushed++;
+    }
+    g_queue_free(events);
+
+    _schedulerpolicythreadperthread_setHostThread(data, host, newThread);
+    host_migrate(host, &oldThread, &newThread);
 }
 
 static GQueue* _schedulerpolicythreadperthread_getHosts(SchedulerPolicy* policy) {
@@ -104,8 +158,8 @@ static void _schedulerpolicythreadperthread_push(SchedulerPolicy* policy, Event*
     /* non-local events must be properly delayed so the event wont show up at another worker
      * before the next scheduling interval. this is only a problem if the sender and
      * receivers have been assigned to different worker threads. */
-    pthread_t srcThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, srcHost));
-    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, dstHost));
+    pthread_t srcThread = _schedulerpolicythreadperthread_getHostThread(data, srcHost);
+    pthread_t dstThread = _schedulerpolicythreadperthread_getHostThread(data, dstHost);
 
     SimulationTime eventTime = event_getTime(event);
 
@@ -122,7 +176,7 @@ static void _schedulerpolicythreadperthread_push(SchedulerPolicy* policy, Event*
     pthread_t self = pthread_self();
     if(pthread_equal(dstThread, self)) {
         event_setSequence(event, ++(tdata->qdata->pushSequenceCounter));
-        priorityqueue_push(tdata->qdata->pq, event);
+        eventqueue_push(tdata->qdata->pq, event);
         tdata->qdata->nPushed++;
     } else {
         /* we need to lock this if srcThread != pthread_self */
@@ -131,14 +185,14 @@ static void _schedulerpolicythreadperthread_push(SchedulerPolicy* policy, Event*
         }
 
         /* now make sure we have a mailbox for the source and create one if needed */
-        PriorityQueue* futureEvents = g_hash_table_lookup(tdata->threadToPQueueMap, GUINT_TO_POINTER(srcThread));
+        EventQueue* futureEvents = g_hash_table_lookup(tdata->threadToPQueueMap, GUINT_TO_POINTER(srcThread));
         if(!futureEvents) {
-            futureEvents = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+            futureEvents = eventqueue_new();
             g_hash_table_replace(tdata->threadToPQueueMap, GUINT_TO_POINTER(srcThread), futureEvents);
         }
 
         /* 'deliver' the event there */
-        priorityqueue_push(futureEvents, event);
+        eventqueue_push(futureEvents, event);
 
         if(!pthread_equal(srcThread, self)) {
             g_mutex_unlock(&(tdata->lock));
@@ -146,6 +200,26 @@ static void _schedulerpolicythreadperthread_push(SchedulerPolicy* policy, Event*
     }
 }
 
+/* if host is non-NULL, only pops the next event if it belongs to that host */
+static Event* _threadperthreadqueuedata_pop(ThreadPerThreadQueueData* qdata, Host* host, SimulationTime barrier) {
+    Event* nextEvent = eventqueue_peek(qdata->pq);
+
+    if(nextEvent == NULL || event_getTime(nextEvent) >= barrier) {
+        /* all hosts for this thread have no more events before barrier */
+        return NULL;
+    }
+    if(host != NULL && event_getHost(nextEvent) != host) {
+        return NULL;
+    }
+
+    SimulationTime eventTime = event_getTime(nextEvent);
+    utility_assert(eventTime >= qdata->lastEventTime);
+    qdata->lastEventTime = eventTime;
+    qdata->nPopped++;
+
+    return eventqueue_pop(qdata->pq);
+}
+
 static Event* _schedulerpolicythreadperthread_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     ThreadPerThreadPolicyData* data = policy->data;
@@ -158,20 +232,19 @@ static Event* _schedulerpolicythreadperthread_pop(SchedulerPolicy* policy, Simul
         return NULL;
     }
 
-    Event* nextEvent = priorityqueue_peek(tdata->qdata->pq);
-    SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
+    return _threadperthreadqueuedata_pop(tdata->qdata, NULL, barrier);
+}
 
-    if(nextEvent && eventTime < barrier) {
-        utility_assert(eventTime >= tdata->qdata->lastEventTime);
-        tdata->qdata->lastEventTime = eventTime;
-        nextEvent = priorityqueue_pop(tdata->qdata->pq);
-        tdata->qdata->nPopped++;
-    } else {
-        /* if we make it here, all hosts for this thread have no more events before barrier */
-        nextEvent = NULL;
+static Event* _schedulerpolicythreadperthread_popForHost(SchedulerPolicy* policy, Host* host, SimulationTime barrier) {
+    MAGIC_ASSERT(policy);
+    ThreadPerThreadPolicyData* data = policy->data;
+
+    ThreadPerThreadThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
+    if(!tdata) {
+        return NULL;
     }
 
-    return nextEvent;
+    return _threadperthreadqueuedata_pop(tdata->qdata, host, barrier);
 }
 
 static SimulationTime _schedulerpolicythreadperthread_getNextTime(SchedulerPolicy* policy) {
@@ -186,12 +259,12 @@ static SimulationTime _schedulerpolicythreadperthread_getNextTime(SchedulerPolic
         GList* values = g_hash_table_get_values(tdata->threadToPQueueMap);
         GList* item = values;
         while(item) {
-            PriorityQueue* futureEvents = item->data;
+            EventQueue* futureEvents = item->data;
 
-            while(!priorityqueue_isEmpty(futureEvents)) {
-                Event* event = priorityqueue_pop(futureEvents);
+            while(!eventqueue_isEmpty(futureEvents)) {
+                Event* event = eventqueue_pop(futureEvents);
                 event_setSequence(event, ++(tdata->qdata->pushSequenceCounter));
-                priorityqueue_push(tdata->qdata->pq, event);
+                eventqueue_push(tdata->qdata->pq, event);
                 tdata->qdata->nPushed++;
             }
 
@@ -202,7 +275,7 @@ static SimulationTime _schedulerpolicythreadperthread_getNextTime(SchedulerPolic
         }
 
         /* now get the min time */
-        Event* nextEvent = priorityqueue_peek(tdata->qdata->pq);
+        Event* nextEvent = eventqueue_peek(tdata->qdata->pq);
         if(nextEvent != NULL) {
             nextTime = MIN(nextTime, event_getTime(nextEvent));
         }
@@ -219,8 +292,8 @@ static void _schedulerpolicythreadperthread_free(SchedulerPolicy* policy) {
         if(data->threadToThreadDataMap) {
             g_hash_table_destroy(data->threadToThreadDataMap);
         }
-        if(data->hostToThreadMap) {
-            g_hash_table_destroy(data->hostToThreadMap);
+        if(data->hostThreads) {
+            g_array_free(data->hostThreads, TRUE);
         }
         g_free(data);
     }
@@ -232,7 +305,7 @@ static void _schedulerpolicythreadperthread_free(SchedulerPolicy* policy) {
 SchedulerPolicy* schedulerpolicythreadperthread_new() {
     ThreadPerThreadPolicyData* data = g_new0(ThreadPerThreadPolicyData, 1);
     data->threadToThreadDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_threadperthreadthreaddata_free);
-    data->hostToThreadMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    data->hostThreads = g_array_new(FALSE, TRUE, sizeof(pthread_t));
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
     MAGIC_INIT(policy);
@@ -240,7 +313,9 @@ SchedulerPolicy* schedulerpolicythreadperthread_new() {
     policy->getAssignedHosts = _schedulerpolicythreadperthread_getHosts;
     policy->push = _schedulerpolicythreadperthread_push;
     policy->pop = _schedulerpolicythreadperthread_pop;
+    policy->popForHost = _schedulerpolicythreadperthread_popForHost;
     policy->getNextTime = _schedulerpolicythreadperthread_getNextTime;
+    policy->migrateHost = _schedulerpolicythreadperthread_migrateHost;
     policy->free = _schedulerpolicythreadperthread_free;
 
     policy->type = SP_PARALLEL_THREAD_PERTHREAD;
@@ -9,7 +9,7 @@ typedef struct _ThreadSingleThreadData ThreadSingleThreadData;
 struct _ThreadSingleThreadData {
     GQueue* assignedHosts2;
     GMutex lock;
-    PriorityQueue* pq;
+    EventQueue* pq;
     SimulationTime pushSequenceCounter;
     SimulationTime lastEventTime;
     gsize nPushed;
@@ -19,14 +19,28 @@ struct _ThreadSingleThreadData {
 typedef struct _ThreadSinglePolicyData ThreadSinglePolicyData;
 struct _ThreadSinglePolicyData {
     GHashTable* threadToThreadDataMap;
-    GHashTable* hostToThreadMap;
+    /* host index -> pthread_t, or 0 if the host is not assigned */
+    GArray* hostThreads;
     MAGIC_DECLARE;
 };
 
+static pthread_t _schedulerpolicythreadsingle_getHostThread(ThreadSinglePolicyData* data, Host* host) {
+    guint hostIndex = host_getIndex(host);
+    return hostIndex < data->hostThreads->len ? g_array_index(data->hostThreads, pthread_t, hostIndex) : 0;
+}
+
+static void _schedulerpolicythreadsingle_setHostThread(ThreadSinglePolicyData* data, Host* host, pthread_t thread) {
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= data->hostThreads->len) {
+        g_array_set_size(data->hostThreads, hostIndex + 1);
+    }
+    g_array_index(data->hostThreads, pthread_t, hostIndex) = thread;
+}
+
 static ThreadSingleThreadData* _threadsinglethreaddata_new() {
     ThreadSingleThreadData* tdata = g_new0(ThreadSingleThreadData, 1);
     g_mutex_init(&(tdata->lock));
-    tdata->pq = priorityqueue_new((GCompareDataFunc)event_compare, NULL, (GDestroyNotify)event_unref);
+    tdata->pq = eventqueue_new();
     tdata->assignedHosts2 = g_queue_new();
     return tdata;
 }
@@ -37,7 +51,7 @@ static void _threadsinglethreaddata_free(ThreadSingleThreadData* tdata) {
             g_queue_free(tdata->assignedHosts2);
         }
         if(tdata->pq) {
-            priorityqueue_free(tdata->pq);
+            eventqueue_free(tdata->pq);
         }
         g_mutex_clear(&(tdata->lock));
         g_free(tdata);
@@ -59,7 +73,45 @@ static void _schedulerpolicythreadsingle_addHost(SchedulerPolicy* policy, Host*
     g_queue_push_tail(tdata->assignedHosts2, host);
 
     /* finally, store the host-to-thread mapping */
-    g_hash_table_replace(data->hostToThreadMap, host, GUINT_TO_POINTER(assignedThread));
+    _schedulerpolicythreadsingle_setHostThread(data, host, assignedThread);
+}
+
+/* this must only be called between rounds, while no worker is running events */
+static void _schedulerpolicythreadsingle_migrateHost(SchedulerPolicy* policy, Host* host, pthread_t newThread) {
+    MAGIC_ASSERT(policy);
+    ThreadSinglePolicyData* data = policy->data;
+
+    pthread_t oldThread = _schedulerpolicythreadsingle_getHostThread(data, host);
+    if(pthread_equal(oldThread, newThread)) {
+        return;
+    }
+
+    ThreadSingleThreadData* oldTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(oldThread));
+    utility_assert(oldTData);
+    g_queue_remove(oldTData->assignedHosts2, host);
+
+    ThreadSingleThreadData* newTData = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread));
+    if(!newTData) {
+        newTData = _threadsinglethreaddata_new();
+        g_hash_table_replace(data->threadToThreadDataMap, GUINT_TO_POINTER(newThread), newTData);
+    }
+    g_queue_push_tail(newTData->assignedHosts2, host);
+
+    /* the sequence numbers of the host's events came from the old thread's counter. give
+     * them new ones from the new thread's counter, in order, so that they are neither
+     * reordered among themselves nor ahead of events that the new thread already has. */
+    GQueue* events = eventqueue_removeHostEvents(oldTData->pq, host);
+    while(!g_queue_is_empty(events)) {
+        Event* event = g_queue_pop_head(events);
+        event_setSequence(event, ++(newTData->pushSequenceCounter));
+        eventqueue_push(newTData->pq, event);
+        newTData->lastEventTime = MIN(newTData->lastEventTime, event_getTime(event));
+        newTData->nPushed++;
+    }
+    g_queue_free(events);
+
+    _schedulerpolicythreadsingle_setHostThread(data, host, newThread);
+    host_migrate(host, &oldThread, &newThread);
 }
 
 static GQueue* _schedulerpolicythreadsingle_getHosts(SchedulerPolicy* policy) {
@@ -76,8 +128,8 @@ static void _schedulerpolicythreadsingle_push(SchedulerPolicy* policy, Event* ev
     /* non-local events must be properly delayed so the event wont show up at another worker
      * before the next scheduling interval. this is only a problem if the sender and
      * receivers have been assigned to different worker threads. */
-    pthread_t srcThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, srcHost));
-    pthread_t dstThread = GPOINTER_TO_UINT(g_hash_table_lookup(data->hostToThreadMap, dstHost));
+    pthread_t srcThread = _schedulerpolicythreadsingle_getHostThread(data, srcHost);
+    pthread_t dstThread = _schedulerpolicythreadsingle_getHostThread(data, dstHost);
 
     SimulationTime eventTime = event_getTime(event);
 
@@ -94,11 +146,31 @@ static void _schedulerpolicythreadsingle_push(SchedulerPolicy* policy, Event* ev
     /* 'deliver' the event there */
     g_mutex_lock(&(tdata->lock));
     event_setSequence(event, ++(tdata->pushSequenceCounter));
-    priorityqueue_push(tdata->pq, event);
+    eventqueue_push(tdata->pq, event);
     tdata->nPushed++;
     g_mutex_unlock(&(tdata->lock));
 }
 
+/* if host is non-NULL, only pops the next event if it belongs to that host. must hold the lock. */
+static Event* _threadsinglethreaddata_pop(ThreadSingleThreadData* tdata, Host* host, SimulationTime barrier) {
+    Event* nextEvent = eventqueue_peek(tdata->pq);
+
+    if(nextEvent == NULL || event_getTime(nextEvent) >= barrier) {
+        /* all hosts for this thread have no more events before barrier */
+        return NULL;
+    }
+    if(host != NULL && event_getHost(nextEvent) != host) {
+        return NULL;
+    }
+
+    SimulationTime eventTime = event_getTime(nextEvent);
+    utility_assert(eventTime >= tdata->lastEventTime);
+    tdata->lastEventTime = eventTime;
+    tdata->nPopped++;
+
+    return eventqueue_pop(tdata->pq);
+}
+
 static Event* _schedulerpolicythreadsingle_pop(SchedulerPolicy* policy, SimulationTime barrier) {
     MAGIC_ASSERT(policy);
     ThreadSinglePolicyData* data = policy->data;
@@ -112,20 +184,23 @@ static Event* _schedulerpolicythreadsingle_pop(SchedulerPolicy* policy, Simulati
     }
 
     g_mutex_lock(&(tdata->lock));
+    Event* nextEvent = _threadsinglethreaddata_pop(tdata, NULL, barrier);
+    g_mutex_unlock(&(tdata->lock));
+
+    return nextEvent;
+}
+
+static Event* _schedulerpolicythreadsingle_popForHost(SchedulerPolicy* policy, Host* host, SimulationTime barrier) {
+    MAGIC_ASSERT(policy);
+    ThreadSinglePolicyData* data = policy->data;
 
-    Event* nextEvent = priorityqueue_peek(tdata->pq);
-    SimulationTime eventTime = (nextEvent != NULL) ? event_getTime(nextEvent) : SIMTIME_INVALID;
-
-    if(nextEvent && eventTime < barrier) {
-        utility_assert(eventTime >= tdata->lastEventTime);
-        tdata->lastEventTime = eventTime;
-        nextEvent = priorityqueue_pop(tdata->pq);
-        tdata->nPopped++;
-    } else {
-        /* if we make it here, all hosts for this thread have no more events before barrier */
-        nextEvent = NULL;
+    ThreadSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
+    if(!tdata) {
+        return NULL;
     }
 
+    g_mutex_lock(&(tdata->lock));
+    Event* nextEvent = _threadsinglethreaddata_pop(tdata, host, barrier);
     g_mutex_unlock(&(tdata->lock));
 
     return nextEvent;
@@ -140,7 +215,7 @@ static SimulationTime _schedulerpolicythreadsingle_getNextTime(SchedulerPolicy*
     ThreadSingleThreadData* tdata = g_hash_table_lookup(data->threadToThreadDataMap, GUINT_TO_POINTER(pthread_self()));
     if(tdata) {
         g_mutex_lock(&(tdata->lock));
-        Event* event = priorityqueue_peek(tdata->pq);
+        Event* event = eventqueue_peek(tdata->pq);
         g_mutex_unlock(&(tdata->lock));
         if(event != NULL) {
             nextTime = MIN(nextTime, event_getTime(event));
@@ -155,7 +230,7 @@ static void _schedulerpolicythreadsingle_free(SchedulerPolicy* policy) {
     ThreadSinglePolicyData* data = policy->data;
 
     g_hash_table_destroy(data->threadToThreadDataMap);
-    g_hash_table_destroy(data->hostToThreadMap);
+    g_array_free(data->hostThreads, TRUE);
     g_free(data);
 
     MAGIC_CLEAR(policy);
@@ -165,7 +240,7 @@ static void _schedulerpolicythreadsingle_free(SchedulerPolicy* policy) {
 SchedulerPolicy* schedulerpolicythreadsingle_new() {
     ThreadSinglePolicyData* data = g_new0(ThreadSinglePolicyData, 1);
     data->threadToThreadDataMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)_threadsinglethreaddata_free);
-    data->hostToThreadMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    data->hostThreads = g_array_new(FALSE, TRUE, sizeof(pthread_t));
 
     SchedulerPolicy* policy = g_new0(SchedulerPolicy, 1);
     MAGIC_INIT(policy);
@@ -173,7 +248,9 @@ SchedulerPolicy* schedulerpolicythreadsingle_new() {
     policy->getAssignedHosts = _schedulerpolicythreadsingle_getHosts;
     policy->push = _schedulerpolicythreadsingle_push;
     policy->pop = _schedulerpolicythreadsingle_pop;
+    policy->popForHost = _schedulerpolicythreadsingle_popForHost;
     policy->getNextTime = _schedulerpolicythreadsingle_getNextTime;
+    policy->migrateHost = _schedulerpolicythreadsingle_migrateHost;
     policy->free = _schedulerpolicythreadsingle_free;
 
     policy->type = SP_PARALLEL_THREAD_SINGLE;
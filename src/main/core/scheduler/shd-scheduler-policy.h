@@ -12,7 +12,9 @@ typedef enum {
     /* every host has a locked pqueue into which every thread inserts events,
      * max queue contention is N for N threads */
     SP_PARALLEL_HOST_SINGLE,
-    /* modified version of SP_PARALLEL_HOST_SINGLE that implements work stealing */
+    /* modified version of SP_PARALLEL_HOST_SINGLE that implements work stealing: each thread
+     * keeps its runnable hosts in a lock-free deque, and idle threads steal (and migrate)
+     * hosts from the other threads' deques */
     SP_PARALLEL_HOST_STEAL,
     /* every thread has a locked pqueue into which every thread inserts events,
      * max queue contention is N for N threads */
@@ -31,7 +33,10 @@ typedef void (*SchedulerPolicyAddHostFunc)(SchedulerPolicy*, Host*, pthread_t);
 typedef GQueue* (*SchedulerPolicyGetHostsFunc)(SchedulerPolicy*);
 typedef void (*SchedulerPolicyPushFunc)(SchedulerPolicy*, Event*, Host*, Host*, SimulationTime);
 typedef Event* (*SchedulerPolicyPopFunc)(SchedulerPolicy*, SimulationTime);
+typedef Event* (*SchedulerPolicyPopForHostFunc)(SchedulerPolicy*, Host*, SimulationTime);
 typedef SimulationTime (*SchedulerPolicyGetNextTimeFunc)(SchedulerPolicy*);
+typedef void (*SchedulerPolicyMigrateHostFunc)(SchedulerPolicy*, Host*, pthread_t);
+typedef gsize (*SchedulerPolicyGetNumStolenFunc)(SchedulerPolicy*);
 typedef void (*SchedulerPolicyFreeFunc)(SchedulerPolicy*);
 
 struct _SchedulerPolicy {
@@ -42,13 +47,21 @@ struct _SchedulerPolicy {
     SchedulerPolicyGetHostsFunc getAssignedHosts;
     SchedulerPolicyPushFunc push;
     SchedulerPolicyPopFunc pop;
+    /* optional, returns what pop would return only if it is an event for the given host,
+     * and NULL otherwise. never blocks. */
+    SchedulerPolicyPopForHostFunc popForHost;
     SchedulerPolicyGetNextTimeFunc getNextTime;
+    /* optional, only called between rounds while all workers are waiting */
+    SchedulerPolicyMigrateHostFunc migrateHost;
+    /* optional, the number of hosts the calling thread stole from other threads so far */
+    SchedulerPolicyGetNumStolenFunc getNumStolen;
     SchedulerPolicyFreeFunc free;
     MAGIC_DECLARE;
 };
 
 SchedulerPolicy* schedulerpolicyglobalsingle_new();
 SchedulerPolicy* schedulerpolicyhostsingle_new();
+SchedulerPolicy* schedulerpolicyhoststeal_new();
 SchedulerPolicy* schedulerpolicythreadsingle_new();
 SchedulerPolicy* schedulerpolicythreadperthread_new();
 SchedulerPolicy* schedulerpolicythreadperhost_new();
@@ -18,12 +18,11 @@ struct _Scheduler {
     /* barrier for worker threads to start and stop running */
     CountDownLatch* startBarrier;
     CountDownLatch* finishBarrier;
-    /* barrier to wait for worker threads to finish processing this round */
-    CountDownLatch* executeEventsBarrier;
-    /* barrier to wait for worker threads to collect info after a round */
-    CountDownLatch* collectInfoBarrier;
-    /* barrier to wait for main thread to finish updating for the next round */
-    CountDownLatch* prepareRoundBarrier;
+    /* barrier for worker threads to finish processing this round */
+    RoundBarrier* executeEventsBarrier;
+    /* barrier for worker threads to wait for main thread to finish updating for the next
+     * round. the main thread waits here until the workers collected their next event times. */
+    RoundBarrier* prepareRoundBarrier;
 
     /* holds a timer for each thread to track how long threads wait for execution barrier */
     GHashTable* threadToWaitTimerMap;
@@ -34,16 +33,47 @@ struct _Scheduler {
 
     /* we store the hosts here */
     GHashTable* hostIDToHostMap;
+    /* the same hosts, indexed by host_getIndex for lookups on the packet path */
+    GPtrArray* hostsByIndex;
 
     /* used to randomize host-to-thread assignment */
     Random* random;
 
+    /* if non-NULL, each worker's partition of hosts gets its own round end time
+     * computed from the latencies between partitions, instead of the global one */
+    SchedulerLookahead* lookahead;
+    /* where the partition latencies come from, NULL until the lookahead is first computed,
+     * and when the topology next changes, which no partition may run past */
+    Topology* lookaheadTopology;
+    SimulationTime lookaheadEndTime;
+    /* the partition (worker index + 1) of every host indexed by host_getIndex,
+     * only changed between rounds */
+    GArray* hostPartitions;
+
+    /* if non-zero, hosts are moved between threads to even out the time the threads
+     * spend executing events, every time this much simulated time has passed */
+    SimulationTime rebalanceInterval;
+    SimulationTime nextRebalanceTime;
+    /* the measured execution time of every host, keyed by host ID */
+    GHashTable* hostIDToLoadMap;
+
+    /* if non-NULL, we write a line for every worker to this file after every round */
+    FILE* traceFile;
+    /* what each worker did in the current round, indexed by worker thread ID */
+    SchedulerThreadStats* threadStats;
+    guint64 nRounds;
+
     /* auxiliary information about current running state */
     gboolean isRunning;
     SimulationTime endTime;
     struct {
+        SimulationTime startTime;
         SimulationTime endTime;
-        SimulationTime minNextEventTime;
+        /* workers reduce their next event times into this atomically */
+        volatile SimulationTime minNextEventTime;
+        /* per-partition versions of the above, used with the partition lookahead */
+        SimulationTime* partitionEndTimes;
+        SimulationTime* partitionNextEventTimes;
     } currentRound;
 
     /* for memory management */
@@ -51,9 +81,30 @@ struct _Scheduler {
     MAGIC_DECLARE;
 };
 
+typedef struct _SchedulerHostLoad SchedulerHostLoad;
+struct _SchedulerHostLoad {
+    /* the host's total execution time at the last rebalance */
+    gdouble lastElapsed;
+    /* moving average of the execution time per rebalance interval */
+    gdouble load;
+};
+
+/* each worker only writes its own stats, so keep them in separate cache lines */
+typedef struct _SchedulerThreadStats SchedulerThreadStats;
+struct _SchedulerThreadStats {
+    gsize nEventsExecuted;
+    gsize nCrossThreadPushes;
+    gsize nStolen;
+    gdouble barrierWaitTime;
+    /* the cumulative counters at the end of the previous round */
+    gsize lastNumStolen;
+    gdouble lastBarrierWaitTime;
+} __attribute__((aligned(64)));
+
 typedef struct _SchedulerThreadItem SchedulerThreadItem;
 struct _SchedulerThreadItem {
     pthread_t thread;
+    guint partition;
     CountDownLatch* notifyDoneRunning;
 };
 
@@ -95,7 +146,8 @@ static void _scheduler_stopHosts(Scheduler* scheduler) {
 }
 
 Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointer threadUserData,
-        guint schedulerSeed, SimulationTime endTime) {
+        guint schedulerSeed, SimulationTime endTime, gboolean usePartitionLookahead,
+        SimulationTime rebalanceInterval, const gchar* tracePath) {
     Scheduler* scheduler = g_new0(Scheduler, 1);
     MAGIC_INIT(scheduler);
 
@@ -104,9 +156,11 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
 
     scheduler->startBarrier = countdownlatch_new(nWorkers+1);
     scheduler->finishBarrier = countdownlatch_new(nWorkers+1);
-    scheduler->executeEventsBarrier = countdownlatch_new(nWorkers+1);
-    scheduler->collectInfoBarrier = countdownlatch_new(nWorkers+1);
-    scheduler->prepareRoundBarrier = countdownlatch_new(nWorkers+1);
+    if(nWorkers > 0) {
+        /* only the workers run events, but the main thread prepares each round */
+        scheduler->executeEventsBarrier = roundbarrier_new(nWorkers);
+        scheduler->prepareRoundBarrier = roundbarrier_new(nWorkers+1);
+    }
 
     scheduler->endTime = endTime;
     scheduler->currentRound.endTime = scheduler->endTime;// default to one single round
@@ -114,6 +168,7 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
 
     scheduler->threadToWaitTimerMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_timer_destroy);
     scheduler->hostIDToHostMap = g_hash_table_new(g_direct_hash, g_direct_equal);
+    scheduler->hostsByIndex = g_ptr_array_new();
 
     scheduler->random = random_new(schedulerSeed);
 
@@ -121,7 +176,7 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
     if(nWorkers == 0) {
         scheduler->policyType = SP_SERIAL_GLOBAL;
     } else if(nWorkers > 0 && policyType == SP_SERIAL_GLOBAL) {
-        policyType = SP_PARALLEL_HOST_STEAL;
+        scheduler->policyType = SP_PARALLEL_HOST_STEAL;
     } else {
         scheduler->policyType = policyType;
     }
@@ -133,7 +188,7 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
             break;
         }
         case SP_PARALLEL_HOST_STEAL: {
-            scheduler->policy = schedulerpolicyhostsingle_new();
+            scheduler->policy = schedulerpolicyhoststeal_new();
             break;
         }
         case SP_PARALLEL_THREAD_SINGLE: {
@@ -156,6 +211,59 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
     }
     utility_assert(scheduler->policy);
 
+    /* the partition map is needed for the lookahead as well as for rebalancing */
+    if(nWorkers > 0) {
+        scheduler->hostPartitions = g_array_new(FALSE, TRUE, sizeof(guint));
+    }
+
+    /* the partition lookahead lets a worker run events past the global round end, which
+     * requires that each worker executes its hosts' events in a single time-ordered queue */
+    if(usePartitionLookahead) {
+        if(scheduler->policyType == SP_PARALLEL_THREAD_SINGLE ||
+                scheduler->policyType == SP_PARALLEL_THREAD_PERTHREAD ||
+                scheduler->policyType == SP_PARALLEL_THREAD_PERHOST) {
+            scheduler->lookahead = schedulerlookahead_new(nWorkers);
+            scheduler->currentRound.partitionEndTimes = g_new0(SimulationTime, nWorkers);
+            scheduler->currentRound.partitionNextEventTimes = g_new0(SimulationTime, nWorkers);
+            message("using per-partition lookahead for %u worker threads", nWorkers);
+        } else {
+            warning("the partition lookahead requires the 'thread', 'threadXthread', or 'threadXhost' "
+                    "scheduler policy; using the global lookahead instead");
+        }
+    }
+
+    /* moving hosts requires support from the policy, and more than one thread */
+    if(rebalanceInterval > 0 && nWorkers > 1) {
+        if(scheduler->policy->migrateHost) {
+            scheduler->rebalanceInterval = rebalanceInterval;
+            scheduler->nextRebalanceTime = rebalanceInterval;
+            scheduler->hostIDToLoadMap = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+            message("rebalancing hosts among worker threads every %"G_GUINT64_FORMAT" nanoseconds "
+                    "of simulated time", rebalanceInterval);
+        } else {
+            warning("the scheduler policy does not support moving hosts between threads; "
+                    "hosts will not be rebalanced");
+        }
+    }
+
+    /* rounds are only managed by the scheduler when we have workers */
+    if(tracePath) {
+        if(nWorkers > 0) {
+            scheduler->traceFile = fopen(tracePath, "w");
+            if(scheduler->traceFile) {
+                scheduler->threadStats = g_new0(SchedulerThreadStats, nWorkers);
+                fprintf(scheduler->traceFile, "round,window_start,window_end,worker,worker_end,"
+                        "events,cross_thread_pushes,steals,barrier_wait_us\n");
+                message("writing the scheduler trace to '%s'", tracePath);
+            } else {
+                warning("unable to open scheduler trace file '%s', error %i: %s",
+                        tracePath, errno, g_strerror(errno));
+            }
+        } else {
+            warning("the scheduler trace requires worker threads; not writing it");
+        }
+    }
+
     /* make sure our ref count is set before starting the threads */
     scheduler->referenceCount = 1;
 
@@ -168,6 +276,7 @@ Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointe
         g_string_printf(name, "worker-%i", (i));
 
         SchedulerThreadItem* item = g_new0(SchedulerThreadItem, 1);
+        item->partition = (guint)i;
         item->notifyDoneRunning = countdownlatch_new(1);
 
         WorkerRunData* runData = g_new0(WorkerRunData, 1);
@@ -207,6 +316,7 @@ void scheduler_shutdown(Scheduler* scheduler) {
      * the engine is marked "killed" and workers are destroyed, so that
      * each plug-in is able to destroy/free its virtual nodes properly */
     g_hash_table_destroy(scheduler->hostIDToHostMap);
+    g_ptr_array_free(scheduler->hostsByIndex, TRUE);
 
     /* join and free spawned worker threads */
     guint nWorkers = g_queue_get_length(scheduler->threadItems);
@@ -250,9 +360,12 @@ static void _scheduler_free(Scheduler* scheduler) {
     scheduler->policy->free(scheduler->policy);
     random_free(scheduler->random);
 
-    countdownlatch_free(scheduler->executeEventsBarrier);
-    countdownlatch_free(scheduler->collectInfoBarrier);
-    countdownlatch_free(scheduler->prepareRoundBarrier);
+    if(scheduler->executeEventsBarrier) {
+        roundbarrier_free(scheduler->executeEventsBarrier);
+    }
+    if(scheduler->prepareRoundBarrier) {
+        roundbarrier_free(scheduler->prepareRoundBarrier);
+    }
     countdownlatch_free(scheduler->startBarrier);
     countdownlatch_free(scheduler->finishBarrier);
 
@@ -260,6 +373,23 @@ static void _scheduler_free(Scheduler* scheduler) {
         g_hash_table_destroy(scheduler->threadToWaitTimerMap);
     }
 
+    if(scheduler->hostPartitions) {
+        g_array_free(scheduler->hostPartitions, TRUE);
+    }
+    if(scheduler->traceFile) {
+        fclose(scheduler->traceFile);
+        g_free(scheduler->threadStats);
+    }
+    if(scheduler->hostIDToLoadMap) {
+        g_hash_table_destroy(scheduler->hostIDToLoadMap);
+    }
+
+    if(scheduler->lookahead) {
+        schedulerlookahead_free(scheduler->lookahead);
+        g_free(scheduler->currentRound.partitionEndTimes);
+        g_free(scheduler->currentRound.partitionNextEventTimes);
+    }
+
     g_mutex_clear(&(scheduler->globalLock));
 
     message("%i worker threads finished", nWorkers);
@@ -286,7 +416,17 @@ void scheduler_unref(Scheduler* scheduler) {
     }
 }
 
-void scheduler_push(Scheduler* scheduler, Event* event, GQuark senderHostID, GQuark receiverHostID) {
+static guint _scheduler_getPartition(Scheduler* scheduler, Host* host) {
+    guint partition = g_array_index(scheduler->hostPartitions, guint, host_getIndex(host));
+    utility_assert(partition > 0);
+    return partition - 1;
+}
+
+static void _scheduler_setPartition(Scheduler* scheduler, Host* host, guint partition) {
+    g_array_index(scheduler->hostPartitions, guint, host_getIndex(host)) = partition + 1;
+}
+
+void scheduler_push(Scheduler* scheduler, Event* event, Host* sender, Host* receiver) {
     MAGIC_ASSERT(scheduler);
 
     SimulationTime eventTime = event_getTime(event);
@@ -297,13 +437,93 @@ void scheduler_push(Scheduler* scheduler, Event* event, GQuark senderHostID, GQu
 
     /* parties involved. sender may be NULL, receiver may not!
      * we MAY NOT OWN the receiver, so do not write to it! */
-    Host* sender = scheduler_getHost(scheduler, senderHostID);
-    Host* receiver = scheduler_getHost(scheduler, receiverHostID);
     utility_assert(receiver);
     utility_assert(receiver == event_getHost(event));
 
+    /* the receiver may be running ahead of the global round end */
+    SimulationTime barrier = scheduler->currentRound.endTime;
+    if(scheduler->lookahead) {
+        guint partition = _scheduler_getPartition(scheduler, receiver);
+        barrier = scheduler->currentRound.partitionEndTimes[partition];
+    }
+
+    /* count the push against the worker the sender is assigned to, which is not the
+     * running thread if the sender's events were stolen */
+    if(scheduler->threadStats && sender) {
+        guint srcPartition = _scheduler_getPartition(scheduler, sender);
+        if(srcPartition != _scheduler_getPartition(scheduler, receiver)) {
+            __atomic_fetch_add(&(scheduler->threadStats[srcPartition].nCrossThreadPushes), 1, __ATOMIC_RELAXED);
+        }
+    }
+
     /* push to a queue based on the policy */
-    scheduler->policy->push(scheduler->policy, event, sender, receiver, scheduler->currentRound.endTime);
+    scheduler->policy->push(scheduler->policy, event, sender, receiver, barrier);
+}
+
+static void _scheduler_reduceMinNextEventTime(Scheduler* scheduler, SimulationTime nextTime) {
+    SimulationTime* minTime = (SimulationTime*)&(scheduler->currentRound.minNextEventTime);
+    SimulationTime current = __atomic_load_n(minTime, __ATOMIC_RELAXED);
+
+    /* the barrier that follows makes the result visible to the main thread */
+    while(nextTime < current) {
+        if(__atomic_compare_exchange_n(minTime, &current, nextTime, FALSE,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+}
+
+/* turn the cumulative counters into counts for the round that just ended */
+static void _scheduler_collectThreadStats(Scheduler* scheduler, GTimer* barrierWaitTimer) {
+    SchedulerThreadStats* stats = &(scheduler->threadStats[worker_getThreadID()]);
+
+    if(scheduler->policy->getNumStolen) {
+        gsize numStolen = scheduler->policy->getNumStolen(scheduler->policy);
+        stats->nStolen = numStolen - stats->lastNumStolen;
+        stats->lastNumStolen = numStolen;
+    }
+
+    if(barrierWaitTimer) {
+        gdouble waitTime = g_timer_elapsed(barrierWaitTimer, NULL);
+        stats->barrierWaitTime = waitTime - stats->lastBarrierWaitTime;
+        stats->lastBarrierWaitTime = waitTime;
+    }
+}
+
+/* this is called by the main thread while all workers are waiting */
+static void _scheduler_writeTrace(Scheduler* scheduler) {
+    guint nWorkers = g_queue_get_length(scheduler->threadItems);
+
+    for(guint i = 0; i < nWorkers; i++) {
+        SchedulerThreadStats* stats = &(scheduler->threadStats[i]);
+
+        /* how far this worker was allowed to run, which differs from the window
+         * end only when using the partition lookahead */
+        SimulationTime workerEnd = scheduler->lookahead ?
+                scheduler->currentRound.partitionEndTimes[i] : scheduler->currentRound.endTime;
+
+        fprintf(scheduler->traceFile, "%"G_GUINT64_FORMAT",%"G_GUINT64_FORMAT",%"G_GUINT64_FORMAT","
+                "%u,%"G_GUINT64_FORMAT",%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%.0f\n",
+                scheduler->nRounds, scheduler->currentRound.startTime, scheduler->currentRound.endTime,
+                i, workerEnd, stats->nEventsExecuted, stats->nCrossThreadPushes, stats->nStolen,
+                stats->barrierWaitTime * 1000000.0);
+
+        stats->nEventsExecuted = 0;
+        stats->nCrossThreadPushes = 0;
+        stats->nStolen = 0;
+        stats->barrierWaitTime = 0;
+    }
+
+    scheduler->nRounds++;
+}
+
+static SimulationTime _scheduler_getBarrier(Scheduler* scheduler) {
+    /* our partition may be running ahead of the global round end */
+    if(scheduler->lookahead) {
+        return scheduler->currentRound.partitionEndTimes[worker_getThreadID()];
+    } else {
+        return scheduler->currentRound.endTime;
+    }
 }
 
 Event* scheduler_pop(Scheduler* scheduler) {
@@ -313,10 +533,15 @@ Event* scheduler_pop(Scheduler* scheduler) {
      * return NULL only to signal the worker thread to quit */
 
     while(scheduler->isRunning) {
+        SimulationTime barrier = _scheduler_getBarrier(scheduler);
+
         /* pop from a queue based on the policy */
-        Event* nextEvent = scheduler->policy->pop(scheduler->policy, scheduler->currentRound.endTime);
+        Event* nextEvent = scheduler->policy->pop(scheduler->policy, barrier);
 
         if(nextEvent != NULL) {
+            if(scheduler->threadStats) {
+                scheduler->threadStats[worker_getThreadID()].nEventsExecuted++;
+            }
             /* we have an event, let the worker run it */
             return nextEvent;
         } else if(scheduler->policyType == SP_SERIAL_GLOBAL) {
@@ -333,7 +558,7 @@ Event* scheduler_pop(Scheduler* scheduler) {
             if(executeEventsBarrierWaitTime) {
                 g_timer_continue(executeEventsBarrierWaitTime);
             }
-            countdownlatch_countDownAwait(scheduler->executeEventsBarrier);
+            roundbarrier_await(scheduler->executeEventsBarrier);
             if(executeEventsBarrierWaitTime) {
                 g_timer_stop(executeEventsBarrierWaitTime);
             }
@@ -342,19 +567,23 @@ Event* scheduler_pop(Scheduler* scheduler) {
              * asynchronously collect some stats that the main thread will use. */
             if(scheduler->policy->getNextTime) {
                 SimulationTime nextTime = scheduler->policy->getNextTime(scheduler->policy);
-                g_mutex_lock(&(scheduler->globalLock));
-                scheduler->currentRound.minNextEventTime = MIN(scheduler->currentRound.minNextEventTime, nextTime);
-                g_mutex_unlock(&(scheduler->globalLock));
+                if(scheduler->lookahead) {
+                    /* each worker only writes its own slot */
+                    scheduler->currentRound.partitionNextEventTimes[worker_getThreadID()] = nextTime;
+                }
+                _scheduler_reduceMinNextEventTime(scheduler, nextTime);
+            }
+
+            if(scheduler->threadStats) {
+                _scheduler_collectThreadStats(scheduler, executeEventsBarrierWaitTime);
             }
 
             /* clear all log messages from the last round */
             logger_flushRecords(logger_getDefault(), pthread_self());
 
-            /* wait for other threads to finish their collect step */
-            countdownlatch_countDownAwait(scheduler->collectInfoBarrier);
-
-            /* now wait for main thread to process a barrier update for the next round */
-            countdownlatch_countDownAwait(scheduler->prepareRoundBarrier);
+            /* the main thread waits until every worker arrived here, which means they all
+             * finished their collect step, and then processes a barrier update for the next round */
+            roundbarrier_await(scheduler->prepareRoundBarrier);
         }
     }
 
@@ -362,6 +591,25 @@ Event* scheduler_pop(Scheduler* scheduler) {
     return NULL;
 }
 
+/* returns the event that scheduler_pop would return next if it belongs to the given
+ * host, so that the worker can keep the host active for it. otherwise returns NULL
+ * without blocking, and the worker should call scheduler_pop. */
+Event* scheduler_popForHost(Scheduler* scheduler, Host* host) {
+    MAGIC_ASSERT(scheduler);
+
+    if(!scheduler->isRunning || !scheduler->policy->popForHost) {
+        return NULL;
+    }
+
+    Event* nextEvent = scheduler->policy->popForHost(scheduler->policy, host, _scheduler_getBarrier(scheduler));
+
+    if(nextEvent != NULL && scheduler->threadStats) {
+        scheduler->threadStats[worker_getThreadID()].nEventsExecuted++;
+    }
+
+    return nextEvent;
+}
+
 void scheduler_addHost(Scheduler* scheduler, Host* host) {
     MAGIC_ASSERT(scheduler);
 
@@ -372,6 +620,16 @@ void scheduler_addHost(Scheduler* scheduler, Host* host) {
     GQuark hostID = host_getID(host);
     gpointer hostIDKey = GUINT_TO_POINTER(hostID);
     g_hash_table_replace(scheduler->hostIDToHostMap, hostIDKey, host);
+
+    guint hostIndex = host_getIndex(host);
+    if(hostIndex >= scheduler->hostsByIndex->len) {
+        g_ptr_array_set_size(scheduler->hostsByIndex, hostIndex + 1);
+    }
+    g_ptr_array_index(scheduler->hostsByIndex, hostIndex) = host;
+
+    if(scheduler->hostPartitions && hostIndex >= scheduler->hostPartitions->len) {
+        g_array_set_size(scheduler->hostPartitions, hostIndex + 1);
+    }
 }
 
 Host* scheduler_getHost(Scheduler* scheduler, GQuark hostID) {
@@ -379,6 +637,14 @@ Host* scheduler_getHost(Scheduler* scheduler, GQuark hostID) {
     return (Host*) g_hash_table_lookup(scheduler->hostIDToHostMap, GUINT_TO_POINTER((guint)hostID));
 }
 
+Host* scheduler_getHostByIndex(Scheduler* scheduler, guint hostIndex) {
+    MAGIC_ASSERT(scheduler);
+    if(hostIndex >= scheduler->hostsByIndex->len) {
+        return NULL;
+    }
+    return (Host*) g_ptr_array_index(scheduler->hostsByIndex, hostIndex);
+}
+
 static void _scheduler_appendHostToQueue(gpointer uintKey, Host* host, GQueue* allHosts) {
     g_queue_push_tail(allHosts, host);
 }
@@ -420,7 +686,19 @@ static void _scheduler_shuffleQueue(Scheduler* scheduler, GQueue* queue) {
     }
 }
 
-static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts, pthread_t thread, uint maxAssignments) {
+static void _scheduler_assignHostToThread(Scheduler* scheduler, Host* host, pthread_t thread, guint partition) {
+    MAGIC_ASSERT(scheduler);
+    utility_assert(host);
+    utility_assert(thread);
+
+    scheduler->policy->addHost(scheduler->policy, host, thread);
+    if(scheduler->hostPartitions) {
+        _scheduler_setPartition(scheduler, host, partition);
+    }
+}
+
+static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts, pthread_t thread,
+        guint partition, uint maxAssignments) {
     MAGIC_ASSERT(scheduler);
     utility_assert(hosts);
     utility_assert(thread);
@@ -428,13 +706,65 @@ static void _scheduler_assignHostsToThread(Scheduler* scheduler, GQueue* hosts,
     guint numAssignments = 0;
     while((maxAssignments == 0 || numAssignments < maxAssignments) && !g_queue_is_empty(hosts)) {
         Host* host = (Host*) g_queue_pop_head(hosts);
-        utility_assert(host);
-        scheduler->policy->addHost(scheduler->policy, host, thread);
+        _scheduler_assignHostToThread(scheduler, host, thread, partition);
         numAssignments++;
     }
 }
 
-static void _scheduler_assignHosts(Scheduler* scheduler) {
+static gint _scheduler_compareHostIDs(gconstpointer a, gconstpointer b, gpointer userData) {
+    guint aID = (guint)host_getID((Host*)a);
+    guint bID = (guint)host_getID((Host*)b);
+    return (aID < bID) ? -1 : (aID > bID) ? 1 : 0;
+}
+
+static void _scheduler_assignHostsByTopology(Scheduler* scheduler, GQueue* hosts, Topology* topology) {
+    MAGIC_ASSERT(scheduler);
+    utility_assert(hosts);
+    utility_assert(topology);
+
+    /* the hash table order is arbitrary, make the result only depend on the hosts */
+    g_queue_sort(hosts, _scheduler_compareHostIDs, NULL);
+
+    guint nHosts = g_queue_get_length(hosts);
+    guint nThreads = g_queue_get_length(scheduler->threadItems);
+
+    Host** hostArray = g_new(Host*, nHosts);
+    Address** addresses = g_new(Address*, nHosts);
+    gdouble* weights = g_new(gdouble, nHosts);
+
+    for(guint i = 0; i < nHosts; i++) {
+        hostArray[i] = g_queue_pop_head(hosts);
+        addresses[i] = host_getDefaultAddress(hostArray[i]);
+        /* hosts with more bandwidth are expected to send more packets and thus run more events */
+        guint64 bandwidth = host_getBandwidthDownKiBps(hostArray[i]) + host_getBandwidthUpKiBps(hostArray[i]);
+        weights[i] = (gdouble) MAX(bandwidth, 1);
+    }
+
+    /* keep hosts that are attached close together on the same thread */
+    guint* partitions = topology_partition(topology, addresses, weights, nHosts, nThreads);
+
+    /* the thread queue may have been rotated, so index the items by partition */
+    SchedulerThreadItem** items = g_new0(SchedulerThreadItem*, nThreads);
+    for(GList* link = g_queue_peek_head_link(scheduler->threadItems); link != NULL; link = g_list_next(link)) {
+        SchedulerThreadItem* item = link->data;
+        items[item->partition] = item;
+    }
+
+    for(guint i = 0; i < nHosts; i++) {
+        SchedulerThreadItem* item = items[partitions[i]];
+        utility_assert(item);
+        _scheduler_assignHostToThread(scheduler, hostArray[i], item->thread, item->partition);
+    }
+
+    g_free(items);
+
+    g_free(partitions);
+    g_free(weights);
+    g_free(addresses);
+    g_free(hostArray);
+}
+
+static void _scheduler_assignHosts(Scheduler* scheduler, Topology* topology) {
     MAGIC_ASSERT(scheduler);
 
     g_mutex_lock(&scheduler->globalLock);
@@ -456,7 +786,10 @@ static void _scheduler_assignHosts(Scheduler* scheduler) {
         }
 
         /* assign *all* of the hosts to the chosen thread */
-        _scheduler_assignHostsToThread(scheduler, hosts, chosen, 0);
+        _scheduler_assignHostsToThread(scheduler, hosts, chosen, 0, 0);
+        utility_assert(g_queue_is_empty(hosts));
+    } else if(topology) {
+        _scheduler_assignHostsByTopology(scheduler, hosts, topology);
         utility_assert(g_queue_is_empty(hosts));
     } else {
         /* we need to shuffle the list of hosts to make sure they are randomly assigned */
@@ -467,7 +800,7 @@ static void _scheduler_assignHosts(Scheduler* scheduler) {
             SchedulerThreadItem* item = g_queue_pop_head(scheduler->threadItems);
             pthread_t nextThread = item->thread;
 
-            _scheduler_assignHostsToThread(scheduler, hosts, nextThread, 1);
+            _scheduler_assignHostsToThread(scheduler, hosts, nextThread, item->partition, 1);
 
             g_queue_push_tail(scheduler->threadItems, item);
         }
@@ -479,33 +812,191 @@ static void _scheduler_assignHosts(Scheduler* scheduler) {
     g_mutex_unlock(&scheduler->globalLock);
 }
 
-static void _scheduler_rebalanceHosts(Scheduler* scheduler) {
+static Host* _scheduler_findHostToMove(Scheduler* scheduler, GQueue* hosts, gdouble maxLoad) {
     MAGIC_ASSERT(scheduler);
 
-    // WARNING if this is run, then all existing eventSequenceCounters
-    // need to get set to the max of all existing counters to ensure order correctness
+    /* the largest host that still fits into the gap */
+    Host* best = NULL;
+    gdouble bestLoad = 0;
+
+    for(GList* link = g_queue_peek_head_link(hosts); link != NULL; link = g_list_next(link)) {
+        Host* host = link->data;
+        SchedulerHostLoad* hostLoad = g_hash_table_lookup(scheduler->hostIDToLoadMap,
+                GUINT_TO_POINTER((guint)host_getID(host)));
+        if(hostLoad->load > bestLoad && hostLoad->load < maxLoad) {
+            best = host;
+            bestLoad = hostLoad->load;
+        }
+    }
 
-    /* get queue of all hosts */
+    return best;
+}
+
+/* computes how far apart the partitions are from the latencies of the topology paths
+ * between their hosts. this must only be called between rounds. */
+static void _scheduler_computeLookahead(Scheduler* scheduler) {
+    MAGIC_ASSERT(scheduler);
+    utility_assert(scheduler->lookahead);
+
+    guint nPartitions = g_queue_get_length(scheduler->threadItems);
+    gdouble* pathLatencies = g_new(gdouble, nPartitions * nPartitions);
+
+    /* the latencies are only valid until the next edge change */
+    scheduler->lookaheadEndTime = scheduler->lookaheadTopology ?
+            topology_getNextEdgeChangeTime(scheduler->lookaheadTopology) : SIMTIME_INVALID;
+
+    if(scheduler->lookaheadTopology && topology_getPartitionLatencies(scheduler->lookaheadTopology,
+            (const guint*) scheduler->hostPartitions->data, scheduler->hostPartitions->len,
+            nPartitions, pathLatencies)) {
+        SimulationTime* latencies = g_new(SimulationTime, nPartitions * nPartitions);
+        for(guint i = 0; i < nPartitions * nPartitions; i++) {
+            /* packets are delayed by at least the rounded up path latency, see worker_sendPacket */
+            latencies[i] = pathLatencies[i] < 0 ? SIMTIME_MAX :
+                    (SimulationTime) floor(pathLatencies[i] * SIMTIME_ONE_MILLISECOND);
+        }
+        schedulerlookahead_setLatencies(scheduler->lookahead, latencies);
+        g_free(latencies);
+    } else {
+        /* without precomputed paths, any two partitions may be as close as the closest hosts */
+        schedulerlookahead_reset(scheduler->lookahead);
+    }
+
+    g_free(pathLatencies);
+}
+
+/* recomputes the partition lookahead from the topology's path latencies. this must be
+ * called after scheduler_start, and again between rounds whenever the paths change. */
+void scheduler_updateLookahead(Scheduler* scheduler, Topology* topology) {
+    MAGIC_ASSERT(scheduler);
+
+    if(!scheduler->lookahead) {
+        return;
+    }
+
+    g_mutex_lock(&scheduler->globalLock);
+    scheduler->lookaheadTopology = topology;
+    _scheduler_computeLookahead(scheduler);
+    g_mutex_unlock(&scheduler->globalLock);
+}
+
+/* this must only be called by the main thread between rounds, while workers are waiting */
+static void _scheduler_rebalanceHosts(Scheduler* scheduler, SimulationTime windowStart) {
+    MAGIC_ASSERT(scheduler);
+
+    if(!scheduler->rebalanceInterval || windowStart < scheduler->nextRebalanceTime) {
+        return;
+    }
+    scheduler->nextRebalanceTime = windowStart + scheduler->rebalanceInterval;
+
+    guint nThreads = g_queue_get_length(scheduler->threadItems);
+
+    /* index the thread items by partition, the queue may have been rotated */
+    SchedulerThreadItem** items = g_new0(SchedulerThreadItem*, nThreads);
+    for(GList* link = g_queue_peek_head_link(scheduler->threadItems); link != NULL; link = g_list_next(link)) {
+        SchedulerThreadItem* item = link->data;
+        items[item->partition] = item;
+    }
+
+    gdouble* threadLoads = g_new0(gdouble, nThreads);
+    GQueue** threadHosts = g_new0(GQueue*, nThreads);
+    for(guint i = 0; i < nThreads; i++) {
+        threadHosts[i] = g_queue_new();
+    }
+
+    /* sort so that the result does not depend on the hash table order */
     GQueue* hosts = g_queue_new();
     g_hash_table_foreach(scheduler->hostIDToHostMap, (GHFunc)_scheduler_appendHostToQueue, hosts);
+    g_queue_sort(hosts, _scheduler_compareHostIDs, NULL);
 
-    _scheduler_shuffleQueue(scheduler, hosts);
-
-    /* now that our host order has been randomized, assign them evenly to worker threads */
+    /* measure how much time each host spent running events since the last rebalance,
+     * smoothing it out so that a single busy interval does not move hosts around */
+    gdouble totalLoad = 0;
     while(!g_queue_is_empty(hosts)) {
         Host* host = g_queue_pop_head(hosts);
-        SchedulerThreadItem* item = g_queue_pop_head(scheduler->threadItems);
-        pthread_t newThread = item->thread;
+        gpointer hostIDKey = GUINT_TO_POINTER((guint)host_getID(host));
+
+        gdouble elapsed = host_getElapsedExecutionTime(host);
+        SchedulerHostLoad* hostLoad = g_hash_table_lookup(scheduler->hostIDToLoadMap, hostIDKey);
+        if(!hostLoad) {
+            hostLoad = g_new0(SchedulerHostLoad, 1);
+            hostLoad->load = elapsed;
+            g_hash_table_replace(scheduler->hostIDToLoadMap, hostIDKey, hostLoad);
+        } else {
+            hostLoad->load = (0.5 * hostLoad->load) + (0.5 * (elapsed - hostLoad->lastElapsed));
+        }
+        hostLoad->lastElapsed = elapsed;
 
-//        TODO this needs to get uncommented/updated when migration code is added
-//        scheduler->policy->migrateHost(scheduler->policy, host, newThread);
+        guint partition = _scheduler_getPartition(scheduler, host);
+        threadLoads[partition] += hostLoad->load;
+        g_queue_push_tail(threadHosts[partition], host);
+        totalLoad += hostLoad->load;
+    }
+    g_queue_free(hosts);
+
+    /* greedily move hosts from the busiest to the idlest thread. we only move a host if
+     * it is smaller than the difference, so that the maximum load always goes down. */
+    gdouble tolerance = 0.1 * (totalLoad / nThreads);
+    guint nMoved = 0;
+
+    while(nMoved < g_hash_table_size(scheduler->hostIDToHostMap)) {
+        guint busiest = 0, idlest = 0;
+        for(guint i = 1; i < nThreads; i++) {
+            if(threadLoads[i] > threadLoads[busiest]) {
+                busiest = i;
+            }
+            if(threadLoads[i] < threadLoads[idlest]) {
+                idlest = i;
+            }
+        }
 
-        g_queue_push_tail(scheduler->threadItems, item);
+        gdouble gap = threadLoads[busiest] - threadLoads[idlest];
+        if(gap <= tolerance) {
+            break;
+        }
+
+        Host* host = _scheduler_findHostToMove(scheduler, threadHosts[busiest], gap);
+        if(!host) {
+            break;
+        }
+
+        GQuark hostID = host_getID(host);
+        SchedulerHostLoad* hostLoad = g_hash_table_lookup(scheduler->hostIDToLoadMap, GUINT_TO_POINTER((guint)hostID));
+
+        debug("moving host %s with load %f from thread %u (load %f) to thread %u (load %f)",
+                g_quark_to_string(hostID), hostLoad->load, busiest, threadLoads[busiest],
+                idlest, threadLoads[idlest]);
+
+        scheduler->policy->migrateHost(scheduler->policy, host, items[idlest]->thread);
+        _scheduler_setPartition(scheduler, host, idlest);
+
+        /* the host's events now run in the new partition, so it must not run ahead of them */
+        if(scheduler->lookahead) {
+            SimulationTime* nextTimes = scheduler->currentRound.partitionNextEventTimes;
+            nextTimes[idlest] = MIN(nextTimes[idlest], nextTimes[busiest]);
+        }
+
+        g_queue_remove(threadHosts[busiest], host);
+        g_queue_push_tail(threadHosts[idlest], host);
+        threadLoads[busiest] -= hostLoad->load;
+        threadLoads[idlest] += hostLoad->load;
+        nMoved++;
     }
 
-    if(hosts) {
-        g_queue_free(hosts);
+    /* the latencies were between the old partitions */
+    if(nMoved > 0 && scheduler->lookahead) {
+        _scheduler_computeLookahead(scheduler);
     }
+
+    if(nMoved > 0) {
+        message("moved %u hosts between worker threads to balance their load", nMoved);
+    }
+
+    for(guint i = 0; i < nThreads; i++) {
+        g_queue_free(threadHosts[i]);
+    }
+    g_free(threadHosts);
+    g_free(threadLoads);
+    g_free(items);
 }
 
 SchedulerPolicyType scheduler_getPolicy(Scheduler* scheduler) {
@@ -535,7 +1026,7 @@ void scheduler_awaitStart(Scheduler* scheduler) {
     _scheduler_startHosts(scheduler);
 
     /* everyone is waiting for the next round to be ready */
-    countdownlatch_countDownAwait(scheduler->prepareRoundBarrier);
+    roundbarrier_await(scheduler->prepareRoundBarrier);
 }
 
 void scheduler_awaitFinish(Scheduler* scheduler) {
@@ -550,8 +1041,10 @@ void scheduler_awaitFinish(Scheduler* scheduler) {
     countdownlatch_countDownAwait(scheduler->finishBarrier);
 }
 
-void scheduler_start(Scheduler* scheduler) {
-    _scheduler_assignHosts(scheduler);
+/* if topology is non-NULL, hosts that are attached close to each other will be assigned
+ * to the same worker thread. otherwise, hosts are assigned to threads randomly. */
+void scheduler_start(Scheduler* scheduler, Topology* topology) {
+    _scheduler_assignHosts(scheduler, topology);
 
     g_mutex_lock(&scheduler->globalLock);
     scheduler->isRunning = TRUE;
@@ -563,39 +1056,65 @@ void scheduler_start(Scheduler* scheduler) {
     }
 }
 
+static void _scheduler_updatePartitionEndTimes(Scheduler* scheduler, SimulationTime windowStart,
+        SimulationTime windowEnd) {
+    MAGIC_ASSERT(scheduler);
+
+    guint nPartitions = g_queue_get_length(scheduler->threadItems);
+    SimulationTime* nextTimes = scheduler->currentRound.partitionNextEventTimes;
+    SimulationTime* endTimes = scheduler->currentRound.partitionEndTimes;
+
+    /* the global window is the smallest lookahead that any pair of partitions may have */
+    SimulationTime minLookahead = windowEnd > windowStart ? windowEnd - windowStart : 1;
+    schedulerlookahead_computeHorizons(scheduler->lookahead, nextTimes, minLookahead, endTimes);
+
+    for(guint i = 0; i < nPartitions; i++) {
+        /* never run less than the global window, past the next topology change, or past
+         * the end of the simulation */
+        SimulationTime maxEndTime = MIN(scheduler->endTime, scheduler->lookaheadEndTime);
+        endTimes[i] = MAX(windowEnd, MIN(endTimes[i], maxEndTime));
+        debug("partition %u may run until %"G_GUINT64_FORMAT" (global window end is %"G_GUINT64_FORMAT")",
+                i, endTimes[i], windowEnd);
+
+        /* workers will fill this in again when they finish the round */
+        nextTimes[i] = SIMTIME_MAX;
+    }
+}
+
 void scheduler_continueNextRound(Scheduler* scheduler, SimulationTime windowStart, SimulationTime windowEnd) {
     g_mutex_lock(&scheduler->globalLock);
+    scheduler->currentRound.startTime = windowStart;
     scheduler->currentRound.endTime = windowEnd;
     scheduler->currentRound.minNextEventTime = SIMTIME_MAX;
+    _scheduler_rebalanceHosts(scheduler, windowStart);
+    if(scheduler->lookahead) {
+        _scheduler_updatePartitionEndTimes(scheduler, windowStart, windowEnd);
+    }
     g_mutex_unlock(&scheduler->globalLock);
 
     if(scheduler->policyType != SP_SERIAL_GLOBAL) {
         /* workers are waiting for preparation of the next round
          * this will cause them to start running events */
-        countdownlatch_countDownAwait(scheduler->prepareRoundBarrier);
+        roundbarrier_await(scheduler->prepareRoundBarrier);
 
         /* workers are running events now, and will wait at executeEventsBarrier
          * when blocked because there are no more events available in the current round */
-        countdownlatch_reset(scheduler->prepareRoundBarrier);
     }
 }
 
 SimulationTime scheduler_awaitNextRound(Scheduler* scheduler) {
     /* this function is called by the slave main thread */
     if(scheduler->policyType != SP_SERIAL_GLOBAL) {
-        /* other workers will also wait at this barrier when they are finished with their events */
-        countdownlatch_countDownAwait(scheduler->executeEventsBarrier);
-        countdownlatch_reset(scheduler->executeEventsBarrier);
-        /* then they collect stats and wait at this barrier */
-        countdownlatch_countDownAwait(scheduler->collectInfoBarrier);
-        countdownlatch_reset(scheduler->collectInfoBarrier);
+        /* workers wait for each other at executeEventsBarrier when they are finished with
+         * their events, then collect stats and park at this barrier until we release them */
+        roundbarrier_awaitOthers(scheduler->prepareRoundBarrier);
+
+        if(scheduler->traceFile) {
+            _scheduler_writeTrace(scheduler);
+        }
     }
 
-    SimulationTime minNextEventTime = SIMTIME_MAX;
-    g_mutex_lock(&scheduler->globalLock);
-    minNextEventTime = scheduler->currentRound.minNextEventTime;
-    g_mutex_unlock(&scheduler->globalLock);
-    return minNextEventTime;
+    return __atomic_load_n(&(scheduler->currentRound.minNextEventTime), __ATOMIC_ACQUIRE);
 }
 
 void scheduler_finish(Scheduler* scheduler) {
@@ -607,7 +1126,7 @@ void scheduler_finish(Scheduler* scheduler) {
     if(scheduler->policyType != SP_SERIAL_GLOBAL) {
         /* wake up threads from their waiting for the next round.
          * because isRunning is now false, they will all exit and wait at finishBarrier */
-        countdownlatch_countDownAwait(scheduler->prepareRoundBarrier);
+        roundbarrier_await(scheduler->prepareRoundBarrier);
 
         /* wait for them to be ready to finish */
         countdownlatch_countDownAwait(scheduler->finishBarrier);
@@ -617,5 +1136,6 @@ void scheduler_finish(Scheduler* scheduler) {
     if(g_hash_table_size(scheduler->hostIDToHostMap) > 0) {
         g_hash_table_remove_all(scheduler->hostIDToHostMap);
     }
+    g_ptr_array_set_size(scheduler->hostsByIndex, 0);
     g_mutex_unlock(&scheduler->globalLock);
 }
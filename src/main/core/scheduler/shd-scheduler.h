@@ -12,23 +12,27 @@
 typedef struct _Scheduler Scheduler;
 
 Scheduler* scheduler_new(SchedulerPolicyType policyType, guint nWorkers, gpointer threadUserData,
-        guint schedulerSeed, SimulationTime endTime);
+        guint schedulerSeed, SimulationTime endTime, gboolean usePartitionLookahead,
+        SimulationTime rebalanceInterval, const gchar* tracePath);
 void scheduler_ref(Scheduler*);
 void scheduler_unref(Scheduler*);
 void scheduler_shutdown(Scheduler* scheduler);
 
 void scheduler_awaitStart(Scheduler*);
 void scheduler_awaitFinish(Scheduler*);
-void scheduler_start(Scheduler*);
+void scheduler_start(Scheduler*, Topology*);
+void scheduler_updateLookahead(Scheduler*, Topology*);
 void scheduler_continueNextRound(Scheduler*, SimulationTime, SimulationTime);
 SimulationTime scheduler_awaitNextRound(Scheduler*);
 void scheduler_finish(Scheduler*);
 
-void scheduler_push(Scheduler*, Event*, GQuark, GQuark);
+void scheduler_push(Scheduler*, Event*, Host*, Host*);
 Event* scheduler_pop(Scheduler*);
+Event* scheduler_popForHost(Scheduler*, Host*);
 
 void scheduler_addHost(Scheduler*, Host*);
 Host* scheduler_getHost(Scheduler*, GQuark);
+Host* scheduler_getHostByIndex(Scheduler*, guint);
 SchedulerPolicyType scheduler_getPolicy(Scheduler*);
 gboolean scheduler_isRunning(Scheduler* scheduler);
 
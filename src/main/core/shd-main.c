@@ -723,6 +723,28 @@ static gint _main_helper(Options* options) {
     return returnCode;
 }
 
+static gint _main_compileTopology(Options* options) {
+    const gchar* graphPath = options_getInputXMLFilename(options)->str;
+    const gchar* compiledPath = options_getCompiledTopologyPath(options);
+
+    if(compiledtopology_isCompiled(graphPath)) {
+        critical("topology '%s' is already compiled", graphPath);
+        return EXIT_FAILURE;
+    }
+
+    /* this fully validates the graph, so loading the compiled version can skip that */
+    Topology* topology = topology_new(graphPath);
+    if(!topology) {
+        critical("unable to load topology '%s'", graphPath);
+        return EXIT_FAILURE;
+    }
+
+    gboolean isSuccess = topology_compile(topology, compiledPath);
+    topology_free(topology);
+
+    return isSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 gint main_runShadow(gint argc, gchar* argv[]) {
     /* check the compiled GLib version */
     if (!GLIB_CHECK_VERSION(2, 32, 0)) {
@@ -779,7 +801,12 @@ gint main_runShadow(gint argc, gchar* argv[]) {
     /* disable buffering during startup so that we see every message immediately in the terminal */
     logger_setEnableBuffering(shadowLogger, FALSE);
 
-    gint returnCode = _main_helper(options);
+    gint returnCode = 0;
+    if(options_getCompiledTopologyPath(options)) {
+        returnCode = _main_compileTopology(options);
+    } else {
+        returnCode = _main_helper(options);
+    }
 
     options_free(options);
     Logger* logger = logger_getDefault();
@@ -219,6 +219,26 @@ static void _master_loadTopology(Master* master) {
     master->dns = dns_new();
 }
 
+static void _master_registerTopologyChangeCallback(ConfigurationTopologyChangeElement* ce, Master* master) {
+    MAGIC_ASSERT(master);
+    utility_assert(ce);
+    utility_assert(ce->source.isSet && ce->target.isSet);
+
+    gboolean success = topology_scheduleEdgeChange(master->topology,
+            SIMTIME_ONE_SECOND * ce->time.integer, ce->source.string->str, ce->target.string->str,
+            ce->latency.isSet ? ce->latency.real : -1, ce->packetloss.isSet ? ce->packetloss.real : -1);
+    if(!success) {
+        error("error scheduling topology change between '%s' and '%s'",
+                ce->source.string->str, ce->target.string->str);
+    }
+}
+
+static void _master_registerTopologyChanges(Master* master) {
+    MAGIC_ASSERT(master);
+    GQueue* changes = configuration_getTopologyChangeElements(master->config);
+    g_queue_foreach(changes, (GFunc)_master_registerTopologyChangeCallback, master);
+}
+
 static void _master_initializeTimeWindows(Master* master) {
     MAGIC_ASSERT(master);
 
@@ -323,6 +343,8 @@ static void _master_registerHostCallback(ConfigurationHostElement* he, Master* m
 
         params->logPcap = (he->logpcap.isSet && !g_ascii_strcasecmp(he->logpcap.string->str, "true")) ? TRUE : FALSE;
         params->pcapDir = he->pcapdir.isSet ? he->pcapdir.string->str : NULL;
+        params->virtualPayloads = (he->virtualpayload.isSet &&
+                !g_ascii_strcasecmp(he->virtualpayload.string->str, "true")) ? TRUE : FALSE;
 
         /* socket buffer settings - if size is set manually, turn off autotuning */
         params->recvBufSize = he->socketrecvbuffer.isSet ? he->socketrecvbuffer.integer :
@@ -375,6 +397,7 @@ gint master_run(Master* master) {
     /* start loading and initializing simulation data */
     _master_loadConfiguration(master);
     _master_loadTopology(master);
+    _master_registerTopologyChanges(master);
     _master_initializeTimeWindows(master);
 
     /* the master will be responsible for distributing the actions to the slaves so that
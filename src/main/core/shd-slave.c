@@ -38,6 +38,15 @@ struct _Slave {
 
     guint numPluginErrors;
 
+    /* the index that the next host will get */
+    guint nextHostIndex;
+
+    /* when the next scheduled topology change is due */
+    SimulationTime nextTopologyChangeTime;
+
+    /* the queues of the bandwidth limited topology edges, NULL if there are none */
+    LinkQueues* linkQueues;
+
     gchar* cwdPath;
     gchar* dataPath;
     gchar* hostsPath;
@@ -74,11 +83,24 @@ static SchedulerPolicyType _slave_getEventSchedulerPolicy(Slave* slave) {
     } else if (g_ascii_strcasecmp(policyStr, "threadXhost") == 0) {
         return SP_PARALLEL_THREAD_PERHOST;
     } else {
-        error("unknown event scheduler policy '%s'; valid values are 'thread', 'host', 'threadXthread', or 'threadXhost'", policyStr);
+        error("unknown event scheduler policy '%s'; valid values are 'thread', 'host', 'steal', 'threadXthread', or 'threadXhost'", policyStr);
         return SP_SERIAL_GLOBAL;
     }
 }
 
+/* the topology to use when assigning hosts to workers, or NULL to assign them randomly */
+static Topology* _slave_getAssignmentTopology(Slave* slave) {
+    const gchar* assignmentStr = options_getHostAssignment(slave->options);
+    if (g_ascii_strcasecmp(assignmentStr, "topology") == 0) {
+        return slave_getTopology(slave);
+    } else if (g_ascii_strcasecmp(assignmentStr, "random") == 0) {
+        return NULL;
+    } else {
+        error("unknown host assignment '%s'; valid values are 'random' or 'topology'", assignmentStr);
+        return NULL;
+    }
+}
+
 Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint randomSeed) {
     Slave* slave = g_new0(Slave, 1);
     MAGIC_INIT(slave);
@@ -90,6 +112,11 @@ Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint
     slave->options = options;
     slave->random = random_new(randomSeed);
 
+    /* packets only trace their delivery statuses if someone can see the debug messages */
+    if(options_getLogLevel(options) == LOGLEVEL_DEBUG) {
+        packet_setDeliveryStatusTracing(TRUE);
+    }
+
     slave->rawFrequencyKHz = utility_getRawCPUFrequency(CONFIG_CPU_MAX_FREQ_FILE);
     if(slave->rawFrequencyKHz == 0) {
         info("unable to read '%s' for copying", CONFIG_CPU_MAX_FREQ_FILE);
@@ -103,7 +130,11 @@ Slave* slave_new(Master* master, Options* options, SimulationTime endTime, guint
     guint nWorkers = options_getNWorkerThreads(options);
     SchedulerPolicyType policy = _slave_getEventSchedulerPolicy(slave);
     guint schedulerSeed = slave_nextRandomUInt(slave);
-    slave->scheduler = scheduler_new(policy, nWorkers, slave, schedulerSeed, endTime);
+    gboolean usePartitionLookahead = options_doPartitionRunAhead(options);
+    SimulationTime rebalanceInterval = options_getRebalanceInterval(options);
+    const gchar* tracePath = options_getSchedulerTracePath(options);
+    slave->scheduler = scheduler_new(policy, nWorkers, slave, schedulerSeed, endTime,
+            usePartitionLookahead, rebalanceInterval, tracePath);
 
     slave->cwdPath = g_get_current_dir();
     slave->dataPath = g_build_filename(slave->cwdPath, options_getDataOutputPath(options), NULL);
@@ -143,6 +174,10 @@ gint slave_free(Slave* slave) {
 
     g_hash_table_destroy(slave->programPaths);
 
+    if(slave->linkQueues) {
+        linkqueues_free(slave->linkQueues);
+    }
+
     g_mutex_clear(&(slave->lock));
     g_mutex_clear(&(slave->pluginInitLock));
 
@@ -215,9 +250,15 @@ void slave_addNewVirtualHost(Slave* slave, HostParameters* params) {
 
     /* quarks are unique per slave process, so do the conversion here */
     params->id = g_quark_from_string(params->hostname);
+    params->index = slave->nextHostIndex++;
     params->nodeSeed = slave_nextRandomUInt(slave);
 
+    if(params->logLevel == LOGLEVEL_DEBUG) {
+        packet_setDeliveryStatusTracing(TRUE);
+    }
+
     Host* host = host_new(params);
+    host_setup(host, slave_getDNS(slave), slave_getTopology(slave));
     scheduler_addHost(slave->scheduler, host);
 }
 
@@ -322,10 +363,80 @@ static void _slave_heartbeat(Slave* slave, SimulationTime simClockNow) {
     }
 }
 
+static void _slave_precomputePaths(Slave* slave) {
+    MAGIC_ASSERT(slave);
+
+    /* all hosts are attached now, so the paths between them will not change */
+    Topology* topology = slave_getTopology(slave);
+
+    /* the workers are not running yet, so we can use as many threads as they would */
+    guint nThreads = MAX(1, options_getNWorkerThreads(slave->options));
+    topology_precomputePaths(topology, nThreads);
+
+    /* we are not a worker, so the topology could not tell us about the latencies yet */
+    gdouble minLatency = topology_getMinimumPathLatency(topology);
+    if(minLatency > 0) {
+        slave_updateMinTimeJump(slave, minLatency);
+    }
+
+    /* each worker thread counts its own traffic over the links */
+    guint nLinks = topology_getLinkCount(topology);
+    if(nLinks > 0) {
+        slave->linkQueues = linkqueues_new(topology_getLinkBandwidths(topology), nLinks, nThreads);
+    }
+}
+
+LinkQueues* slave_getLinkQueues(Slave* slave) {
+    MAGIC_ASSERT(slave);
+    return slave->linkQueues;
+}
+
+/* drains the link queues if they were not updated for a while. this must only be called
+ * while no other thread is sending packets. */
+void slave_updateLinkQueues(Slave* slave, SimulationTime now) {
+    MAGIC_ASSERT(slave);
+
+    if(!slave->linkQueues ||
+            now < linkqueues_getLastUpdateTime(slave->linkQueues) + CONFIG_LINK_QUEUE_UPDATE_INTERVAL) {
+        return;
+    }
+
+    linkqueues_update(slave->linkQueues, now);
+}
+
+/* applies the topology changes that are due at the given time. this must only be called
+ * while no other thread is looking up paths. */
+void slave_applyTopologyChanges(Slave* slave, SimulationTime now) {
+    MAGIC_ASSERT(slave);
+
+    if(now < slave->nextTopologyChangeTime) {
+        return;
+    }
+
+    Topology* topology = slave_getTopology(slave);
+    topology_applyEdgeChanges(topology, now);
+    slave->nextTopologyChangeTime = topology_getNextEdgeChangeTime(topology);
+
+    /* a shorter path means less time between rounds */
+    gdouble minLatency = topology_getMinimumPathLatency(topology);
+    if(minLatency > 0) {
+        slave_updateMinTimeJump(slave, minLatency);
+    }
+
+    /* the partitions are now closer to or farther from each other */
+    scheduler_updateLookahead(slave->scheduler, topology);
+}
+
 void slave_run(Slave* slave) {
     MAGIC_ASSERT(slave);
+
+    /* all hosts are registered now, so address lookups no longer need the dns lock */
+    dns_freeze(slave_getDNS(slave));
+    _slave_precomputePaths(slave);
+    slave->nextTopologyChangeTime = topology_getNextEdgeChangeTime(slave_getTopology(slave));
+
     if(scheduler_getPolicy(slave->scheduler) == SP_SERIAL_GLOBAL) {
-        scheduler_start(slave->scheduler);
+        scheduler_start(slave->scheduler, _slave_getAssignmentTopology(slave));
 
         /* the main slave thread becomes the only worker and runs everything */
         WorkerRunData* data = g_new0(WorkerRunData, 1);
@@ -344,7 +455,8 @@ void slave_run(Slave* slave) {
         SimulationTime minNextEventTime = SIMTIME_INVALID;
         gboolean keepRunning = TRUE;
 
-        scheduler_start(slave->scheduler);
+        scheduler_start(slave->scheduler, _slave_getAssignmentTopology(slave));
+        scheduler_updateLookahead(slave->scheduler, slave_getTopology(slave));
 
         while(keepRunning) {
             /* release the workers and run next round */
@@ -367,9 +479,26 @@ void slave_run(Slave* slave) {
             info("finished execution window [%"G_GUINT64_FORMAT"--%"G_GUINT64_FORMAT"] next event at %"G_GUINT64_FORMAT,
                     windowStart, windowEnd, minNextEventTime);
 
+            /* the workers are parked, so this is when the topology may change. the next
+             * round starts at our next event, and the changes due by then must be in place
+             * before the master computes its window from the minimum path latency. */
+            if(minNextEventTime < SIMTIME_MAX) {
+                slave_applyTopologyChanges(slave, minNextEventTime);
+            }
+
             /* notify master that we finished this round, and the time of our next event
              * in order to fast-forward our execute window if possible */
             keepRunning = master_slaveFinishedCurrentRound(slave->master, minNextEventTime, &windowStart, &windowEnd);
+
+            if(keepRunning) {
+                /* end the round when the next change is due, so that it applies on time */
+                if(slave->nextTopologyChangeTime > windowStart && slave->nextTopologyChangeTime < windowEnd) {
+                    windowEnd = slave->nextTopologyChangeTime;
+                }
+
+                /* the links drain what was sent during the round */
+                slave_updateLinkQueues(slave, windowStart);
+            }
         }
 
         scheduler_finish(slave->scheduler);
@@ -43,6 +43,9 @@ void slave_incrementPluginError(Slave* slave);
 const gchar* slave_getHostsRootPath(Slave* slave);
 
 void slave_updateMinTimeJump(Slave* slave, gdouble minPathLatency);
+void slave_applyTopologyChanges(Slave* slave, SimulationTime now);
+LinkQueues* slave_getLinkQueues(Slave* slave);
+void slave_updateLinkQueues(Slave* slave, SimulationTime now);
 
 void slave_run(Slave*);
 gboolean slave_schedulerIsRunning(Slave* slave);
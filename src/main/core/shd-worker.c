@@ -35,6 +35,9 @@ struct _Worker {
         Process* process;
     } active;
 
+    /* reused to look up the bandwidth limited links on the path of every packet we send */
+    GArray* pathLinks;
+
     MAGIC_DECLARE;
 };
 
@@ -69,6 +72,7 @@ static Worker* _worker_new(Slave* slave, guint threadID) {
     worker->clock.now = SIMTIME_INVALID;
     worker->clock.last = SIMTIME_INVALID;
     worker->clock.barrier = SIMTIME_INVALID;
+    worker->pathLinks = g_array_new(FALSE, FALSE, sizeof(guint));
 
     g_private_replace(&workerKey, worker);
 
@@ -80,6 +84,8 @@ static void _worker_free(Worker* worker) {
 
     g_private_set(&workerKey, NULL);
 
+    g_array_free(worker->pathLinks, TRUE);
+
     MAGIC_CLEAR(worker);
     g_free(worker);
 }
@@ -126,20 +132,42 @@ gpointer worker_run(WorkerRunData* data) {
     /* wait until the slave is done with initialization */
     scheduler_awaitStart(worker->scheduler);
 
+    /* there are no rounds in serial mode, so we apply topology changes and drain the link
+     * queues as events reach them */
+    gboolean isSerial = scheduler_getPolicy(worker->scheduler) == SP_SERIAL_GLOBAL;
+
     /* ask the slave for the next event, blocking until one is available that
      * we are allowed to run. when this returns NULL, we should stop. */
     Event* event = NULL;
     while((event = scheduler_pop(worker->scheduler)) != NULL) {
-        /* update cache, reset clocks */
-        worker->clock.now = event_getTime(event);
-
-        /* process the local event */
-        event_execute(event);
-        event_unref(event);
-
-        /* update times */
-        worker->clock.last = worker->clock.now;
-        worker->clock.now = SIMTIME_INVALID;
+        /* hosts usually have several events in a row, so we run all of them
+         * under a single lock and activation of the host */
+        Host* host = event_getHost(event);
+        host_lock(host);
+        worker_setActiveHost(host);
+        host_continueExecutionTimer(host);
+
+        do {
+            /* update cache, reset clocks */
+            worker->clock.now = event_getTime(event);
+
+            if(isSerial) {
+                slave_applyTopologyChanges(worker->slave, worker->clock.now);
+                slave_updateLinkQueues(worker->slave, worker->clock.now);
+            }
+
+            /* process the local event */
+            event_execute(event);
+            event_unref(event);
+
+            /* update times */
+            worker->clock.last = worker->clock.now;
+            worker->clock.now = SIMTIME_INVALID;
+        } while((event = scheduler_popForHost(worker->scheduler, host)) != NULL);
+
+        host_stopExecutionTimer(host);
+        worker_setActiveHost(NULL);
+        host_unlock(host);
     }
 
     /* this will free the host data that we have been managing */
@@ -169,8 +197,7 @@ void worker_scheduleTask(Task* task, SimulationTime nanoDelay) {
         utility_assert(worker->clock.now != SIMTIME_INVALID);
         utility_assert(worker->active.host != NULL);
         Event* event = event_new_(task, worker->clock.now + nanoDelay, worker->active.host);
-        GQuark hostID = host_getID(worker->active.host);
-        scheduler_push(worker->scheduler, event, hostID, hostID);
+        scheduler_push(worker->scheduler, event, worker->active.host, worker->active.host);
     }
 }
 
@@ -192,47 +219,74 @@ void worker_sendPacket(Packet* packet) {
         return;
     }
 
-    in_addr_t srcIP = packet_getSourceIP(packet);
-    in_addr_t dstIP = packet_getDestinationIP(packet);
+    /* the addresses are resolved to host indices the first time the packet is sent,
+     * so retransmissions of the same packet skip the DNS */
+    guint srcIndex = packet_getSourceHostIndex(packet);
+    guint dstIndex = packet_getDestinationHostIndex(packet);
+
+    if(srcIndex == HOST_INDEX_INVALID || dstIndex == HOST_INDEX_INVALID) {
+        Address* srcAddress = worker_resolveIPToAddress(packet_getSourceIP(packet));
+        Address* dstAddress = worker_resolveIPToAddress(packet_getDestinationIP(packet));
+
+        if(!srcAddress || !dstAddress) {
+            error("unable to schedule packet because of null addresses");
+            return;
+        }
 
-    Address* srcAddress = worker_resolveIPToAddress(srcIP);
-    Address* dstAddress = worker_resolveIPToAddress(dstIP);
+        srcIndex = address_getHostIndex(srcAddress);
+        dstIndex = address_getHostIndex(dstAddress);
+        packet_setHostIndices(packet, srcIndex, dstIndex);
+    }
 
-    if(!srcAddress || !dstAddress) {
-        error("unable to schedule packet because of null addresses");
+    /* one lookup gives us both the reliability and the latency */
+    gdouble latency = 0, reliability = 0;
+    if(!topology_getPathInfoByHostIndex(worker_getTopology(), srcIndex, dstIndex, &latency, &reliability)) {
+        error("unable to schedule packet because there is no path between the addresses");
         return;
     }
 
+    /* the bandwidth limited links on the path add their queueing delay and drops from the
+     * last update, and count our traffic for the next one */
+    SimulationTime queueDelay = 0;
+    LinkQueues* linkQueues = slave_getLinkQueues(worker->slave);
+    if(linkQueues) {
+        gsize totalSize = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
+        topology_getPathLinks(worker_getTopology(), srcIndex, dstIndex, worker->pathLinks);
+        for(guint i = 0; i < worker->pathLinks->len; i++) {
+            guint link = g_array_index(worker->pathLinks, guint, i);
+            queueDelay += linkqueues_getDelay(linkQueues, link);
+            reliability *= 1.0f - linkqueues_getDropChance(linkQueues, link);
+            linkqueues_addDemand(linkQueues, worker->threadID, link, totalSize);
+        }
+    }
+
     /* check if network reliability forces us to 'drop' the packet */
-    gdouble reliability = topology_getReliability(worker_getTopology(), srcAddress, dstAddress);
     Random* random = host_getRandom(worker_getActiveHost());
     gdouble chance = random_nextDouble(random);
 
     /* don't drop control packets with length 0, otherwise congestion
      * control has problems responding to packet loss */
     if(chance <= reliability || packet_getPayloadLength(packet) == 0) {
-        /* the sender's packet will make it through, find latency */
-        gdouble latency = topology_getLatency(worker_getTopology(), srcAddress, dstAddress);
-        SimulationTime delay = (SimulationTime) ceil(latency * SIMTIME_ONE_MILLISECOND);
+        /* the sender's packet will make it through */
+        SimulationTime delay = (SimulationTime) ceil(latency * SIMTIME_ONE_MILLISECOND) + queueDelay;
         SimulationTime deliverTime = worker->clock.now + delay;
 
         /* TODO this should change for sending to remote slave (on a different machine)
          * this is the only place where tasks are sent between separate hosts */
 
         Host* srcHost = worker->active.host;
-        GQuark srcID = srcHost == NULL ? 0 : host_getID(srcHost);
-        GQuark dstID = (GQuark)address_getID(dstAddress);
-        Host* dstHost = scheduler_getHost(worker->scheduler, dstID);
+        Host* dstHost = scheduler_getHostByIndex(worker->scheduler, dstIndex);
         utility_assert(dstHost);
 
+        /* the receiver may run as soon as the event is pushed, so this is our last change */
+        packet_addDeliveryStatus(packet, PDS_INET_SENT);
+
         Task* packetTask = task_new((TaskFunc)_worker_runDeliverPacketTask, packet, NULL);
         packet_ref(packet);
         Event* packetEvent = event_new_(packetTask, deliverTime, dstHost);
         task_unref(packetTask);
 
-        scheduler_push(worker->scheduler, packetEvent, srcID, dstID);
-
-        packet_addDeliveryStatus(packet, PDS_INET_SENT);
+        scheduler_push(worker->scheduler, packetEvent, srcHost, dstHost);
     } else {
         packet_addDeliveryStatus(packet, PDS_INET_DROPPED);
     }
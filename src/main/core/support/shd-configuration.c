@@ -24,6 +24,7 @@ struct _Parser {
     ConfigurationTopologyElement* topology;
     GQueue* plugins; // holds items of type ConfigurationPluginElement
     GQueue* hosts; // holds items of type ConfigurationHostElement
+    GQueue* topologyChanges; // holds items of type ConfigurationTopologyChangeElement
     MAGIC_DECLARE;
 };
 
@@ -128,6 +129,21 @@ static void _parser_freeTopologyElement(ConfigurationTopologyElement* topology)
     g_free(topology);
 }
 
+static void _parser_freeTopologyChangeElement(ConfigurationTopologyChangeElement* change) {
+    utility_assert(change != NULL);
+
+    if(change->source.isSet) {
+        utility_assert(change->source.string != NULL);
+        g_string_free(change->source.string, TRUE);
+    }
+    if(change->target.isSet) {
+        utility_assert(change->target.string != NULL);
+        g_string_free(change->target.string, TRUE);
+    }
+
+    g_free(change);
+}
+
 static void _parser_freePluginElement(ConfigurationPluginElement* plugin) {
     utility_assert(plugin != NULL);
 
@@ -201,6 +217,10 @@ static void _parser_freeHostElement(ConfigurationHostElement* host) {
         utility_assert(host->pcapdir.string != NULL);
         g_string_free(host->pcapdir.string, TRUE);
     }
+    if(host->virtualpayload.isSet) {
+        utility_assert(host->virtualpayload.string != NULL);
+        g_string_free(host->virtualpayload.string, TRUE);
+    }
     if(host->processes) {
         g_queue_free_full(host->processes, (GDestroyNotify)_parser_freeProcessElement);
     }
@@ -319,6 +339,74 @@ static void _parser_handleTopologyText(GMarkupParseContext *context,
     }
 }
 
+static GError* _parser_handleTopologyChangeAttributes(Parser* parser, const gchar** attributeNames, const gchar** attributeValues) {
+    ConfigurationTopologyChangeElement* change = g_new0(ConfigurationTopologyChangeElement, 1);
+    GError* error = NULL;
+
+    const gchar **nameCursor = attributeNames;
+    const gchar **valueCursor = attributeValues;
+
+    /* check the attributes */
+    while (!error && *nameCursor) {
+        const gchar* name = *nameCursor;
+        const gchar* value = *valueCursor;
+
+        debug("found attribute '%s=%s'", name, value);
+
+        if(!change->time.isSet && !g_ascii_strcasecmp(name, "time")) {
+            change->time.integer = g_ascii_strtoull(value, NULL, 10);
+            change->time.isSet = TRUE;
+        } else if (!change->source.isSet && !g_ascii_strcasecmp(name, "source")) {
+            change->source.string = g_string_new(value);
+            change->source.isSet = TRUE;
+        } else if (!change->target.isSet && !g_ascii_strcasecmp(name, "target")) {
+            change->target.string = g_string_new(value);
+            change->target.isSet = TRUE;
+        } else if (!change->latency.isSet && !g_ascii_strcasecmp(name, "latency")) {
+            change->latency.real = g_ascii_strtod(value, NULL);
+            change->latency.isSet = TRUE;
+        } else if (!change->packetloss.isSet && !g_ascii_strcasecmp(name, "packetloss")) {
+            change->packetloss.real = g_ascii_strtod(value, NULL);
+            change->packetloss.isSet = TRUE;
+        } else {
+            error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_UNKNOWN_ATTRIBUTE,
+                            "unknown 'topologychange' attribute '%s'", name);
+        }
+
+        nameCursor++;
+        valueCursor++;
+    }
+
+    /* validate the values */
+    if(!error && (!change->time.isSet || !change->source.isSet || !change->target.isSet)) {
+        error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+                "element 'topologychange' requires attributes 'time' 'source' 'target'");
+    }
+    if(!error && !change->latency.isSet && !change->packetloss.isSet) {
+        error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_MISSING_ATTRIBUTE,
+                "element 'topologychange' requires at least one of attributes 'latency' 'packetloss'");
+    }
+    if(!error && change->latency.isSet && change->latency.real <= 0) {
+        error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT,
+                "element 'topologychange' attribute 'latency' must be positive");
+    }
+    if(!error && change->packetloss.isSet &&
+            (change->packetloss.real < 0 || change->packetloss.real > 1)) {
+        error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT,
+                "element 'topologychange' attribute 'packetloss' must be between 0 and 1");
+    }
+
+    if(error) {
+        /* clean up */
+        _parser_freeTopologyChangeElement(change);
+    } else {
+        /* no error, store the config */
+        g_queue_push_tail(parser->topologyChanges, change);
+    }
+
+    return error;
+}
+
 static GError* _parser_handlePluginAttributes(Parser* parser, const gchar** attributeNames, const gchar** attributeValues) {
     ConfigurationPluginElement* plugin = g_new0(ConfigurationPluginElement, 1);
     GError* error = NULL;
@@ -419,6 +507,9 @@ static GError* _parser_handleHostAttributes(Parser* parser, const gchar** attrib
         } else if (!host->pcapdir.isSet && !g_ascii_strcasecmp(name, "pcapdir")) {
             host->pcapdir.string = g_string_new(value);
             host->pcapdir.isSet = TRUE;
+        } else if (!host->virtualpayload.isSet && !g_ascii_strcasecmp(name, "virtualpayload")) {
+            host->virtualpayload.string = g_string_new(value);
+            host->virtualpayload.isSet = TRUE;
         } else if (!host->quantity.isSet && !g_ascii_strcasecmp(name, "quantity")) {
             host->quantity.integer = g_ascii_strtoull(value, NULL, 10);
             host->quantity.isSet = TRUE;
@@ -715,6 +806,8 @@ static void _parser_handleRootStartElement(GMarkupParseContext* context,
         *error = _parser_handleTopologyAttributes(parser, attributeNames, attributeValues);
         /* handle content text in a sub parser */
         g_markup_parse_context_push(context, &(parser->xmlTopologyParser), parser);
+    } else if (!g_ascii_strcasecmp(elementName, "topologychange")) {
+        *error = _parser_handleTopologyChangeAttributes(parser, attributeNames, attributeValues);
     } else if (!g_ascii_strcasecmp(elementName, "shadow")) {
         *error = _parser_handleShadowAttributes(parser, attributeNames, attributeValues);
     } else {
@@ -758,7 +851,8 @@ static void _parser_handleRootEndElement(GMarkupParseContext* context,
         }
     } else {
         if(!(!g_ascii_strcasecmp(elementName, "plugin") ||
-                !g_ascii_strcasecmp(elementName, "kill"))) {
+                !g_ascii_strcasecmp(elementName, "kill") ||
+                !g_ascii_strcasecmp(elementName, "topologychange"))) {
             *error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_UNKNOWN_ELEMENT,
                             "unknown 'root' child ending element '%s'", elementName);
         }
@@ -794,6 +888,7 @@ static Parser* _parser_new() {
 
     parser->plugins = g_queue_new();
     parser->hosts = g_queue_new();
+    parser->topologyChanges = g_queue_new();
 
     /* we handle the start_element and end_element callbacks, but ignore
      * text, passthrough (comments), and errors
@@ -852,6 +947,9 @@ static void _parser_free(Parser* parser) {
     if(parser->plugins) {
         g_queue_free_full(parser->plugins, (GDestroyNotify)_parser_freePluginElement);
     }
+    if(parser->topologyChanges) {
+        g_queue_free_full(parser->topologyChanges, (GDestroyNotify)_parser_freeTopologyChangeElement);
+    }
     if(parser->shadow) {
         _parser_freeShadowElement(parser->shadow);
     }
@@ -925,3 +1023,9 @@ GQueue* configuration_getHostElements(Configuration* config) {
     utility_assert(config->parser && config->parser->hosts);
     return config->parser->hosts;
 }
+
+GQueue* configuration_getTopologyChangeElements(Configuration* config) {
+    MAGIC_ASSERT(config);
+    utility_assert(config->parser && config->parser->topologyChanges);
+    return config->parser->topologyChanges;
+}
@@ -33,6 +33,12 @@ struct _ConfigurationIntegerAttribute {
     gboolean isSet;
 };
 
+typedef struct _ConfigurationDoubleAttribute ConfigurationDoubleAttribute;
+struct _ConfigurationDoubleAttribute {
+    gdouble real;
+    gboolean isSet;
+};
+
 typedef struct _ConfigurationPluginElement ConfigurationPluginElement;
 struct _ConfigurationPluginElement {
     /* required */
@@ -48,6 +54,17 @@ struct _ConfigurationTopologyElement {
     ConfigurationStringAttribute cdata;
 };
 
+typedef struct _ConfigurationTopologyChangeElement ConfigurationTopologyChangeElement;
+struct _ConfigurationTopologyChangeElement {
+    /* required */
+    ConfigurationIntegerAttribute time;
+    ConfigurationStringAttribute source;
+    ConfigurationStringAttribute target;
+    /* optional, but at least one is required */
+    ConfigurationDoubleAttribute latency;
+    ConfigurationDoubleAttribute packetloss;
+};
+
 typedef struct _ConfigurationProcessElement ConfigurationProcessElement;
 struct _ConfigurationProcessElement {
     /* required */
@@ -81,6 +98,7 @@ struct _ConfigurationHostElement {
     ConfigurationIntegerAttribute cpufrequency;
     ConfigurationStringAttribute logpcap;
     ConfigurationStringAttribute pcapdir;
+    ConfigurationStringAttribute virtualpayload;
 };
 
 typedef struct _ConfigurationShadowElement ConfigurationShadowElement;
@@ -100,6 +118,7 @@ ConfigurationTopologyElement* configuration_getTopologyElement(Configuration* co
 ConfigurationPluginElement* configuration_getPluginElementByID(Configuration* config, const gchar* pluginID);
 GQueue* configuration_getPluginElements(Configuration* config);
 GQueue* configuration_getHostElements(Configuration* config);
+GQueue* configuration_getTopologyChangeElements(Configuration* config);
 
 /** @} */
 
@@ -17,6 +17,12 @@ typedef guint64 SimulationTime;
  */
 typedef guint ShadowID;
 
+/**
+ * Hosts are numbered densely from 0 in the order they are created, so that per-host
+ * data can be kept in arrays. This marks an unknown host.
+ */
+#define HOST_INDEX_INVALID G_MAXUINT
+
 /**
  * Represents an invalid simulation time.
  */
@@ -210,6 +216,36 @@ typedef guint ShadowID;
  */
 #define CONFIG_TCPCLOSETIMER_DELAY (60 * SIMTIME_ONE_SECOND)
 
+/**
+ * Maximum number of distinct attached topology vertices for which we precompute a
+ * matrix of all path latencies and reliabilities (16 bytes per pair).
+ */
+#define CONFIG_TOPOLOGY_MATRIX_MAX_VERTICES 4096
+
+/**
+ * Maximum number of entries in the shortest path trees we keep for the path matrix
+ * when edges change during the simulation (4 bytes per attached vertex per graph vertex).
+ */
+#define CONFIG_TOPOLOGY_PATH_TREE_MAX_ENTRIES 67108864
+
+/**
+ * Number of paths between host pairs that each thread remembers in front of the shared
+ * topology path cache, so repeated lookups take no locks. Must be a power of 2.
+ */
+#define CONFIG_TOPOLOGY_LOCAL_CACHE_ENTRIES 1024
+
+/**
+ * How much traffic a bandwidth limited topology edge can queue, as the time it takes
+ * the edge to send it. Traffic beyond that is dropped.
+ */
+#define CONFIG_LINK_QUEUE_BUFFER_TIME (100*SIMTIME_ONE_MILLISECOND)
+
+/**
+ * How often the queues of bandwidth limited topology edges are updated when the
+ * simulation does not run in rounds. Otherwise they are updated between rounds.
+ */
+#define CONFIG_LINK_QUEUE_UPDATE_INTERVAL SIMTIME_ONE_MILLISECOND
+
 /**
  * Filename to find the CPU speed.
  */
@@ -24,11 +24,13 @@ struct _Options {
     gboolean debug;
     gchar* dataDirPath;
     gchar* dataTemplatePath;
+    gchar* compiledTopologyPath;
 
     GOptionGroup* networkOptionGroup;
     gint cpuThreshold;
     gint cpuPrecision;
     gint minRunAhead;
+    gboolean partitionRunAhead;
     gint initialTCPWindow;
     gint interfaceBufferSize;
     gint initialSocketReceiveBufferSize;
@@ -37,6 +39,9 @@ struct _Options {
     gboolean autotuneSocketSendBuffer;
     gchar* interfaceQueuingDiscipline;
     gchar* eventSchedulingPolicy;
+    gchar* hostAssignment;
+    gint rebalanceInterval;
+    gchar* schedulerTracePath;
     SimulationTime interfaceBatchTime;
     gchar* tcpCongestionControl;
     gint tcpSlowStartThreshold;
@@ -80,6 +85,7 @@ Options* options_new(gint argc, gchar* argv[]) {
     /* set options to change defaults for the main group */
     options->mainOptionGroup = g_option_group_new("main", "Main Options", "Primary simulator options", NULL, NULL);
     const GOptionEntry mainEntries[] = {
+      { "compile-topology", 0, 0, G_OPTION_ARG_STRING, &(options->compiledTopologyPath), "Instead of running a simulation, compile the graphml topology given in place of shadow.config.xml into a binary topology at PATH that loads much faster, and exit. The compiled PATH may then be used as the topology path in shadow.config.xml [None]", "PATH" },
       { "data-directory", 'd', 0, G_OPTION_ARG_STRING, &(options->dataDirPath), "PATH to store simulation output ['shadow.data']", "PATH" },
       { "data-template", 'e', 0, G_OPTION_ARG_STRING, &(options->dataTemplatePath), "PATH to recursively copy during startup and use as the data-directory ['shadow.data.template']", "PATH" },
       { "gdb", 'g', 0, G_OPTION_ARG_NONE, &(options->debug), "Pause at startup for debugger attachment", NULL },
@@ -89,7 +95,11 @@ Options* options_new(gint argc, gchar* argv[]) {
       { "log-level", 'l', 0, G_OPTION_ARG_STRING, &(options->logLevelInput), "Log LEVEL above which to filter messages ('error' < 'critical' < 'warning' < 'message' < 'info' < 'debug') ['message']", "LEVEL" },
       { "preload", 'p', 0, G_OPTION_ARG_STRING, &(options->preloads), "LD_PRELOAD environment VALUE to use for function interposition (/path/to/lib:...) [None]", "VALUE" },
       { "runahead", 'r', 0, G_OPTION_ARG_INT, &(options->minRunAhead), "If set, overrides the automatically calculated minimum TIME workers may run ahead when sending events between nodes, in milliseconds [0]", "TIME" },
+      { "runahead-partition", 0, 0, G_OPTION_ARG_NONE, &(options->partitionRunAhead), "Let each worker run ahead based on the path latencies between its hosts and other workers' hosts, instead of the global minimum runahead (requires the 'thread', 'threadXthread', or 'threadXhost' policy)", NULL },
       { "seed", 's', 0, G_OPTION_ARG_INT, &(options->randomSeed), "Initialize randomness for each thread using seed N [1]", "N" },
+      { "scheduler-assignment", 0, 0, G_OPTION_ARG_STRING, &(options->hostAssignment), "How hosts are assigned to worker threads; 'topology' keeps hosts that are close together in the network on the same thread ('random', 'topology') ['random']", "SASS" },
+      { "scheduler-rebalance", 0, 0, G_OPTION_ARG_INT, &(options->rebalanceInterval), "Move hosts between worker threads every N seconds of simulated time to balance the measured execution time of the threads, 0 to disable (requires the 'host', 'thread', 'threadXthread', or 'threadXhost' policy) [0]", "N" },
+      { "scheduler-trace", 0, 0, G_OPTION_ARG_STRING, &(options->schedulerTracePath), "Write a CSV line with the events, cross-thread pushes, steals, and barrier wait time of every worker after every round to PATH, to help tune --runahead and --workers [None]", "PATH" },
       { "scheduler-policy", 't', 0, G_OPTION_ARG_STRING, &(options->eventSchedulingPolicy), "The event scheduler's policy for thread synchronization ('thread', 'host', 'steal', 'threadXthread', 'threadXhost') ['steal']", "SPOL" },
       { "workers", 'w', 0, G_OPTION_ARG_INT, &(options->nWorkerThreads), "Run concurrently with N worker threads [0]", "N" },
       { "valgrind", 'x', 0, G_OPTION_ARG_NONE, &(options->runValgrind), "Run through valgrind for debugging", NULL },
@@ -193,6 +203,9 @@ Options* options_new(gint argc, gchar* argv[]) {
     if(options->eventSchedulingPolicy == NULL) {
         options->eventSchedulingPolicy = g_strdup("steal");
     }
+    if(options->hostAssignment == NULL) {
+        options->hostAssignment = g_strdup("random");
+    }
     if(!options->initialSocketReceiveBufferSize) {
         options->initialSocketReceiveBufferSize = CONFIG_RECV_BUFFER_SIZE;
         options->autotuneSocketReceiveBuffer = TRUE;
@@ -234,6 +247,13 @@ void options_free(Options* options) {
     g_free(options->heartbeatLogInfo);
     g_free(options->interfaceQueuingDiscipline);
     g_free(options->eventSchedulingPolicy);
+    g_free(options->hostAssignment);
+    if(options->schedulerTracePath) {
+        g_free(options->schedulerTracePath);
+    }
+    if(options->compiledTopologyPath) {
+        g_free(options->compiledTopologyPath);
+    }
     g_free(options->tcpCongestionControl);
     if(options->argstr) {
         g_free(options->argstr);
@@ -316,6 +336,21 @@ gchar* options_getEventSchedulerPolicy(Options* options) {
     return options->eventSchedulingPolicy;
 }
 
+const gchar* options_getHostAssignment(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->hostAssignment;
+}
+
+SimulationTime options_getRebalanceInterval(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->rebalanceInterval > 0 ? ((SimulationTime)options->rebalanceInterval) * SIMTIME_ONE_SECOND : 0;
+}
+
+const gchar* options_getSchedulerTracePath(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->schedulerTracePath;
+}
+
 guint options_getNWorkerThreads(Options* options) {
     MAGIC_ASSERT(options);
     return options->nWorkerThreads > 0 ? (guint)options->nWorkerThreads : 0;
@@ -331,6 +366,11 @@ guint options_getRandomSeed(Options* options) {
     return options->randomSeed;
 }
 
+const gchar* options_getCompiledTopologyPath(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->compiledTopologyPath;
+}
+
 gboolean options_doRunPrintVersion(Options* options) {
     MAGIC_ASSERT(options);
     return options->printSoftwareVersion;
@@ -371,6 +411,11 @@ gint options_getCPUPrecision(Options* options) {
     return options->cpuPrecision;
 }
 
+gboolean options_doPartitionRunAhead(Options* options) {
+    MAGIC_ASSERT(options);
+    return options->partitionRunAhead;
+}
+
 gint options_getMinRunAhead(Options* options) {
     MAGIC_ASSERT(options);
     return options->minRunAhead;
@@ -88,6 +88,9 @@ SimulationTime options_getHeartbeatInterval(Options* options);
 QDiscMode options_getQueuingDiscipline(Options* options);
 
 gchar* options_getEventSchedulerPolicy(Options* options);
+const gchar* options_getHostAssignment(Options* options);
+SimulationTime options_getRebalanceInterval(Options* options);
+const gchar* options_getSchedulerTracePath(Options* options);
 
 guint options_getNWorkerThreads(Options* options);
 
@@ -96,6 +99,8 @@ const gchar* options_getHeartbeatLogInfoString(Options* options);
 const gchar* options_getPreloadString(Options* options);
 guint options_getRandomSeed(Options* options);
 
+const gchar* options_getCompiledTopologyPath(Options* options);
+
 gboolean options_doRunPrintVersion(Options* options);
 gboolean options_doRunValgrind(Options* options);
 gboolean options_doRunDebug(Options* options);
@@ -106,6 +111,7 @@ gint options_getCPUThreshold(Options* options);
 gint options_getCPUPrecision(Options* options);
 
 gint options_getMinRunAhead(Options* options);
+gboolean options_doPartitionRunAhead(Options* options);
 gint options_getTCPWindow(Options* options);
 const gchar* options_getTCPCongestionControl(Options* options);
 gint options_getTCPSlowStartThreshold(Options* options);
@@ -0,0 +1,197 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* the heap is 4-ary, which makes it shallower than a binary heap and keeps all of the
+ * children of a node next to each other in memory */
+#define EVENTQUEUE_ARITY 4
+#define EVENTQUEUE_INITIAL_SIZE 64
+
+typedef struct _EventQueueEntry EventQueueEntry;
+struct _EventQueueEntry {
+    SimulationTime time;
+    guint64 sequence;
+    Event* event;
+};
+
+struct _EventQueue {
+    EventQueueEntry* heap;
+    gsize size;
+    gsize heapSize;
+    MAGIC_DECLARE;
+};
+
+EventQueue* eventqueue_new() {
+    EventQueue* queue = g_new0(EventQueue, 1);
+    MAGIC_INIT(queue);
+
+    queue->heapSize = EVENTQUEUE_INITIAL_SIZE;
+    queue->heap = g_new(EventQueueEntry, queue->heapSize);
+
+    return queue;
+}
+
+void eventqueue_free(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+
+    for(gsize i = 0; i < queue->size; i++) {
+        event_unref(queue->heap[i].event);
+    }
+    g_free(queue->heap);
+
+    MAGIC_CLEAR(queue);
+    g_free(queue);
+}
+
+gsize eventqueue_getLength(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+    return queue->size;
+}
+
+gboolean eventqueue_isEmpty(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+    return queue->size == 0 ? TRUE : FALSE;
+}
+
+/* same ordering as event_compare: events already scheduled get priority over new events */
+static inline gboolean _eventqueue_isLess(const EventQueueEntry* a, const EventQueueEntry* b) {
+    return (a->time < b->time) || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static void _eventqueue_siftUp(EventQueue* queue, gsize index, EventQueueEntry entry) {
+    /* move parents down into the hole until we find the spot for entry */
+    while(index > 0) {
+        gsize parent = (index - 1) / EVENTQUEUE_ARITY;
+        if(!_eventqueue_isLess(&entry, &(queue->heap[parent]))) {
+            break;
+        }
+        queue->heap[index] = queue->heap[parent];
+        index = parent;
+    }
+    queue->heap[index] = entry;
+}
+
+static void _eventqueue_siftDown(EventQueue* queue, gsize index, EventQueueEntry entry) {
+    /* move the smallest child up into the hole until we find the spot for entry */
+    while(TRUE) {
+        gsize firstChild = (index * EVENTQUEUE_ARITY) + 1;
+        if(firstChild >= queue->size) {
+            break;
+        }
+
+        gsize lastChild = MIN(firstChild + EVENTQUEUE_ARITY, queue->size);
+        gsize minChild = firstChild;
+        for(gsize child = firstChild + 1; child < lastChild; child++) {
+            if(_eventqueue_isLess(&(queue->heap[child]), &(queue->heap[minChild]))) {
+                minChild = child;
+            }
+        }
+
+        if(!_eventqueue_isLess(&(queue->heap[minChild]), &entry)) {
+            break;
+        }
+        queue->heap[index] = queue->heap[minChild];
+        index = minChild;
+    }
+    queue->heap[index] = entry;
+}
+
+void eventqueue_push(EventQueue* queue, Event* event) {
+    MAGIC_ASSERT(queue);
+    utility_assert(event);
+
+    if(queue->size >= queue->heapSize) {
+        queue->heapSize *= 2;
+        queue->heap = g_renew(EventQueueEntry, queue->heap, queue->heapSize);
+    }
+
+    EventQueueEntry entry;
+    entry.time = event_getTime(event);
+    entry.sequence = event_getSequence(event);
+    entry.event = event;
+
+    queue->size++;
+    _eventqueue_siftUp(queue, queue->size - 1, entry);
+}
+
+Event* eventqueue_peek(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+    return (queue->size > 0) ? queue->heap[0].event : NULL;
+}
+
+SimulationTime eventqueue_peekTime(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+    return (queue->size > 0) ? queue->heap[0].time : SIMTIME_INVALID;
+}
+
+static gint _eventqueue_compareEntries(gconstpointer a, gconstpointer b) {
+    const EventQueueEntry* ea = a;
+    const EventQueueEntry* eb = b;
+    return _eventqueue_isLess(ea, eb) ? -1 : _eventqueue_isLess(eb, ea) ? 1 : 0;
+}
+
+/* removes all of the events that belong to the given host, and returns them in the
+ * order in which they would have been popped. the caller owns the returned events.
+ * this is linear in the size of the queue, so it should only be used rarely, such as
+ * when a host is moved to another queue. */
+GQueue* eventqueue_removeHostEvents(EventQueue* queue, gpointer host) {
+    MAGIC_ASSERT(queue);
+
+    EventQueueEntry* removed = g_new(EventQueueEntry, MAX(queue->size, 1));
+    gsize nRemoved = 0;
+    gsize nKept = 0;
+
+    /* compact the entries that we keep to the front of the array */
+    for(gsize i = 0; i < queue->size; i++) {
+        if(event_getHost(queue->heap[i].event) == host) {
+            removed[nRemoved++] = queue->heap[i];
+        } else {
+            queue->heap[nKept++] = queue->heap[i];
+        }
+    }
+    queue->size = nKept;
+
+    /* the remaining entries lost their heap order, so rebuild it bottom-up */
+    if(queue->size > 1) {
+        gsize lastParent = (queue->size - 2) / EVENTQUEUE_ARITY;
+        for(gsize i = lastParent + 1; i > 0; i--) {
+            _eventqueue_siftDown(queue, i - 1, queue->heap[i - 1]);
+        }
+    }
+
+    qsort(removed, nRemoved, sizeof(EventQueueEntry), _eventqueue_compareEntries);
+
+    GQueue* events = g_queue_new();
+    for(gsize i = 0; i < nRemoved; i++) {
+        g_queue_push_tail(events, removed[i].event);
+    }
+    g_free(removed);
+
+    return events;
+}
+
+Event* eventqueue_pop(EventQueue* queue) {
+    MAGIC_ASSERT(queue);
+
+    if(queue->size == 0) {
+        return NULL;
+    }
+
+    Event* event = queue->heap[0].event;
+
+    queue->size--;
+    if(queue->size > 0) {
+        /* fill the hole at the root with the last entry */
+        _eventqueue_siftDown(queue, 0, queue->heap[queue->size]);
+    }
+
+    if((queue->heapSize > EVENTQUEUE_INITIAL_SIZE) && (queue->size * 4 < queue->heapSize)) {
+        queue->heapSize /= 2;
+        queue->heap = g_renew(EventQueueEntry, queue->heap, queue->heapSize);
+    }
+
+    return event;
+}
@@ -0,0 +1,27 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_EVENT_QUEUE_H_
+#define SHD_EVENT_QUEUE_H_
+
+#include "shadow.h"
+
+/* A min-heap of events ordered by time and then by sequence. The ordering keys are
+ * copied into the heap when an event is pushed, so an event's time and sequence must
+ * not be changed while it is in the queue. The queue owns one reference to each event. */
+typedef struct _EventQueue EventQueue;
+
+EventQueue* eventqueue_new();
+void eventqueue_free(EventQueue* queue);
+
+gsize eventqueue_getLength(EventQueue* queue);
+gboolean eventqueue_isEmpty(EventQueue* queue);
+void eventqueue_push(EventQueue* queue, Event* event);
+Event* eventqueue_peek(EventQueue* queue);
+SimulationTime eventqueue_peekTime(EventQueue* queue);
+Event* eventqueue_pop(EventQueue* queue);
+GQueue* eventqueue_removeHostEvents(EventQueue* queue, gpointer host);
+
+#endif /* SHD_EVENT_QUEUE_H_ */
@@ -14,9 +14,18 @@ struct _Event {
     MAGIC_DECLARE;
 };
 
+/* events are created and destroyed at a very high rate, so we recycle their memory */
+static ObjectPool* _event_getPool() {
+    static gsize pool = 0;
+    if(g_once_init_enter(&pool)) {
+        g_once_init_leave(&pool, (gsize)objectpool_new(sizeof(Event)));
+    }
+    return (ObjectPool*)pool;
+}
+
 Event* event_new_(Task* task, SimulationTime time, gpointer host) {
     utility_assert(task != NULL);
-    Event* event = g_new0(Event, 1);
+    Event* event = objectpool_alloc0(_event_getPool());
     MAGIC_INIT(event);
 
     event->host = (Host*)host;
@@ -31,7 +40,7 @@ Event* event_new_(Task* task, SimulationTime time, gpointer host) {
 static void _event_free(Event* event) {
     task_unref(event->task);
     MAGIC_CLEAR(event);
-    g_free(event);
+    objectpool_release(_event_getPool(), event);
 }
 
 void event_ref(Event* event) {
@@ -47,12 +56,11 @@ void event_unref(Event* event) {
     }
 }
 
+/* the caller must hold the host lock and have made the host active, so that
+ * consecutive events of the same host can share that setup */
 void event_execute(Event* event) {
     MAGIC_ASSERT(event);
 
-    host_lock(event->host);
-    worker_setActiveHost(event->host);
-
     /* check if we are allowed to execute or have to wait for cpu delays */
     CPU* cpu = host_getCPU(event->host);
     cpu_updateTime(cpu, event->time);
@@ -68,13 +76,8 @@ void event_execute(Event* event) {
         worker_scheduleTask(event->task, cpuDelay);
     } else {
         /* cpu is not blocked, its ok to execute the event */
-        host_continueExecutionTimer(event->host);
         task_execute(event->task);
-        host_stopExecutionTimer(event->host);
     }
-
-    worker_setActiveHost(NULL);
-    host_unlock(event->host);
 }
 
 SimulationTime event_getTime(Event* event) {
@@ -97,6 +100,11 @@ void event_setSequence(Event* event, guint64 sequence) {
     event->sequence = sequence;
 }
 
+guint64 event_getSequence(Event* event) {
+    MAGIC_ASSERT(event);
+    return event->sequence;
+}
+
 gint event_compare(const Event* a, const Event* b, gpointer userData) {
     MAGIC_ASSERT(a);
     MAGIC_ASSERT(b);
@@ -22,5 +22,6 @@ gpointer event_getHost(Event* event);
 SimulationTime event_getTime(Event* event);
 void event_setTime(Event* event, SimulationTime time);
 void event_setSequence(Event* event, guint64 sequence);
+guint64 event_getSequence(Event* event);
 
 #endif /* SHD_EVENT_H_ */
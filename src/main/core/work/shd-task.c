@@ -14,10 +14,19 @@ struct _Task {
 };
 
 
+/* tasks are created and destroyed at a very high rate, so we recycle their memory */
+static ObjectPool* _task_getPool() {
+    static gsize pool = 0;
+    if(g_once_init_enter(&pool)) {
+        g_once_init_leave(&pool, (gsize)objectpool_new(sizeof(Task)));
+    }
+    return (ObjectPool*)pool;
+}
+
 Task* task_new(TaskFunc execute, gpointer data, gpointer callbackArgument) {
     utility_assert(execute != NULL);
 
-    Task* task = g_new0(Task, 1);
+    Task* task = objectpool_alloc0(_task_getPool());
 
     task->execute = execute;
     task->data = data;
@@ -30,7 +39,7 @@ Task* task_new(TaskFunc execute, gpointer data, gpointer callbackArgument) {
 
 static void _task_free(Task* task) {
     MAGIC_CLEAR(task);
-    g_free(task);
+    objectpool_release(_task_getPool(), task);
 }
 
 void task_ref(Task* task) {
@@ -0,0 +1,162 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+#define RETRANSMIT_QUEUE_INITIAL_CAPACITY 64
+
+struct _RetransmitQueue {
+    /* a power of two number of slots, NULL where no packet is queued */
+    Packet** slots;
+    guint capacity;
+
+    /* the slot and sequence of the first queued packet */
+    guint headIndex;
+    guint headSequence;
+    /* the number of slots from the first to the last queued packet */
+    guint span;
+    /* the number of queued packets */
+    guint length;
+
+    MAGIC_DECLARE;
+};
+
+RetransmitQueue* retransmitqueue_new() {
+    RetransmitQueue* queue = g_new0(RetransmitQueue, 1);
+    MAGIC_INIT(queue);
+
+    queue->capacity = RETRANSMIT_QUEUE_INITIAL_CAPACITY;
+    queue->slots = g_new0(Packet*, queue->capacity);
+
+    return queue;
+}
+
+static inline Packet** _retransmitqueue_getSlot(RetransmitQueue* queue, guint offset) {
+    return &(queue->slots[(queue->headIndex + offset) & (queue->capacity - 1)]);
+}
+
+void retransmitqueue_free(RetransmitQueue* queue) {
+    MAGIC_ASSERT(queue);
+
+    for(guint i = 0; i < queue->span; i++) {
+        Packet* packet = *_retransmitqueue_getSlot(queue, i);
+        if(packet) {
+            packet_unref(packet);
+        }
+    }
+    g_free(queue->slots);
+
+    MAGIC_CLEAR(queue);
+    g_free(queue);
+}
+
+/* makes room for span slots, starting the new head shift slots before the old one */
+static void _retransmitqueue_reserve(RetransmitQueue* queue, guint span, guint shift) {
+    if(span <= queue->capacity) {
+        /* the slots outside the span are always empty, so the head can move back in place */
+        queue->headIndex = (queue->headIndex - shift) & (queue->capacity - 1);
+        return;
+    }
+
+    guint capacity = queue->capacity;
+    while(capacity < span) {
+        capacity *= 2;
+    }
+
+    Packet** slots = g_new0(Packet*, capacity);
+    for(guint i = 0; i < queue->span; i++) {
+        slots[shift + i] = *_retransmitqueue_getSlot(queue, i);
+    }
+    g_free(queue->slots);
+
+    queue->slots = slots;
+    queue->capacity = capacity;
+    queue->headIndex = 0;
+}
+
+/* drops the empty slots at both ends so the head is always a queued packet */
+static void _retransmitqueue_trim(RetransmitQueue* queue) {
+    if(queue->length == 0) {
+        queue->span = 0;
+        return;
+    }
+    while(*_retransmitqueue_getSlot(queue, 0) == NULL) {
+        queue->headIndex = (queue->headIndex + 1) & (queue->capacity - 1);
+        queue->headSequence++;
+        queue->span--;
+    }
+    while(*_retransmitqueue_getSlot(queue, queue->span - 1) == NULL) {
+        queue->span--;
+    }
+}
+
+/* takes the caller's reference to the packet, replacing any packet with the same sequence */
+void retransmitqueue_add(RetransmitQueue* queue, guint sequence, Packet* packet) {
+    MAGIC_ASSERT(queue);
+    utility_assert(packet);
+
+    if(queue->length == 0) {
+        queue->headSequence = sequence;
+        queue->span = 0;
+    }
+
+    if(sequence < queue->headSequence) {
+        /* a retransmitted packet from before the first one still queued */
+        guint shift = queue->headSequence - sequence;
+        _retransmitqueue_reserve(queue, queue->span + shift, shift);
+        queue->headSequence = sequence;
+        queue->span += shift;
+    } else if(sequence - queue->headSequence >= queue->span) {
+        guint span = sequence - queue->headSequence + 1;
+        _retransmitqueue_reserve(queue, span, 0);
+        queue->span = span;
+    }
+
+    Packet** slot = _retransmitqueue_getSlot(queue, sequence - queue->headSequence);
+    if(*slot) {
+        packet_unref(*slot);
+    } else {
+        queue->length++;
+    }
+    *slot = packet;
+}
+
+Packet* retransmitqueue_get(RetransmitQueue* queue, guint sequence) {
+    MAGIC_ASSERT(queue);
+    if(queue->length == 0 || sequence < queue->headSequence ||
+            sequence - queue->headSequence >= queue->span) {
+        return NULL;
+    }
+    return *_retransmitqueue_getSlot(queue, sequence - queue->headSequence);
+}
+
+/* removes the packet with the given sequence and returns the queue's reference to it */
+Packet* retransmitqueue_steal(RetransmitQueue* queue, guint sequence) {
+    MAGIC_ASSERT(queue);
+
+    Packet* packet = retransmitqueue_get(queue, sequence);
+    if(packet) {
+        *_retransmitqueue_getSlot(queue, sequence - queue->headSequence) = NULL;
+        queue->length--;
+        _retransmitqueue_trim(queue);
+    }
+    return packet;
+}
+
+/* removes the first packet if its sequence is less than the given one and returns the
+ * queue's reference to it, or NULL if there is no such packet */
+Packet* retransmitqueue_popBefore(RetransmitQueue* queue, guint sequence) {
+    MAGIC_ASSERT(queue);
+
+    if(queue->length == 0 || queue->headSequence >= sequence) {
+        return NULL;
+    }
+    return retransmitqueue_steal(queue, queue->headSequence);
+}
+
+guint retransmitqueue_getLength(RetransmitQueue* queue) {
+    MAGIC_ASSERT(queue);
+    return queue->length;
+}
@@ -0,0 +1,27 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_TCP_RETRANSMIT_QUEUE_H_
+#define SHD_TCP_RETRANSMIT_QUEUE_H_
+
+#include "shadow.h"
+
+/* The packets a TCP sender keeps until they are acknowledged, in a ring indexed by
+ * sequence number. Packets are added in close to sequence order, cumulative ACKs remove
+ * them from the front, and retransmits remove single packets by sequence, all in constant
+ * time. The queue holds one reference to each packet. */
+
+typedef struct _RetransmitQueue RetransmitQueue;
+
+RetransmitQueue* retransmitqueue_new();
+void retransmitqueue_free(RetransmitQueue* queue);
+
+void retransmitqueue_add(RetransmitQueue* queue, guint sequence, Packet* packet);
+Packet* retransmitqueue_get(RetransmitQueue* queue, guint sequence);
+Packet* retransmitqueue_steal(RetransmitQueue* queue, guint sequence);
+Packet* retransmitqueue_popBefore(RetransmitQueue* queue, guint sequence);
+guint retransmitqueue_getLength(RetransmitQueue* queue);
+
+#endif /* SHD_TCP_RETRANSMIT_QUEUE_H_ */
@@ -14,23 +14,26 @@ enum _BlockStatus {
     BLOCK_STATUS_RETRANSMITTED,
 };
 
+/* a run of consecutive packets that share a status. retransmitted blocks each have their
+ * own retransmission id, so they always hold a single packet. */
 typedef struct _ScoreBoardBlock ScoreBoardBlock;
 struct _ScoreBoardBlock {
-    /* sequence number of the block/packet */
-    gint sequence;
-    /* sequence of the next packet to be sent */
+    /* sequence numbers [start, end) of the packets in the block */
+    gint start;
+    gint end;
+    /* sequence of the next packet to be sent, if the packet has been retransmitted */
     gint nextSend;
     /* retransmission id if the packet has been retransmitted */
     gint retransmissionId;
     /* status of the block */
     BlockStatus status;
-
-    MAGIC_DECLARE;
 };
 
 struct _ScoreBoard {
-    /* list of blocks in the scoreboard */
-    GQueue* blocksQ;
+    /* the blocks in the scoreboard, sorted by sequence and never overlapping */
+    GArray* blocks;
+    /* reused to rebuild the blocks without allocating */
+    GArray* spareBlocks;
 
     /* the furthest SACKed sequence number */
     gint fack;
@@ -48,38 +51,19 @@ struct _ScoreBoard {
     MAGIC_DECLARE;
 };
 
-static ScoreBoardBlock* _scoreboardblock_new(gint sequence, BlockStatus status) {
-    ScoreBoardBlock* block = g_new0(ScoreBoardBlock, 1);
-    MAGIC_INIT(block);
-    block->sequence = sequence;
-    block->status = status;
-
-    return block;
-}
-
-static gint _scoreboardblock_compareStatus(ScoreBoardBlock* block1, ScoreBoardBlock* block2) {
-    return (block1->status < block2->status ? -1 : block1->status > block2->status ? 1 : 0);
-}
-
-static gint _scoreboardblock_compareSequence(ScoreBoardBlock* block1, ScoreBoardBlock* block2) {
-    return (block1->sequence < block2->sequence ? -1 : block1->sequence > block2->sequence ? 1 : 0);
-}
+#define _scoreboard_getBlock(blocks, index) (&g_array_index((blocks), ScoreBoardBlock, (index)))
 
-static gint _scoreboardblock_compareSequenceData(ScoreBoardBlock* block1, ScoreBoardBlock* block2, gpointer userData) {
-    return _scoreboardblock_compareSequence(block1, block2);
-}
-
-static void _scoreboardblock_free(ScoreBoardBlock* block) {
-    MAGIC_ASSERT(block);
-    MAGIC_CLEAR(block);
-    g_free(block);
+static gboolean _scoreboardblock_canMerge(ScoreBoardBlock* block1, ScoreBoardBlock* block2) {
+    return block1->end == block2->start && block1->status == block2->status &&
+            block1->status != BLOCK_STATUS_RETRANSMITTED;
 }
 
 ScoreBoard* scoreboard_new() {
     ScoreBoard* scoreboard = g_new0(ScoreBoard, 1);
     MAGIC_INIT(scoreboard);
 
-    scoreboard->blocksQ = g_queue_new();
+    scoreboard->blocks = g_array_new(FALSE, FALSE, sizeof(ScoreBoardBlock));
+    scoreboard->spareBlocks = g_array_new(FALSE, FALSE, sizeof(ScoreBoardBlock));
 
     return scoreboard;
 }
@@ -92,38 +76,102 @@ void scoreboard_clear(ScoreBoard* scoreboard) {
     scoreboard->fack = 0;
     scoreboard->fackOut = 0;
 
-    /* reset the blocks queue */
-    if(scoreboard->blocksQ) {
-        g_queue_free_full(scoreboard->blocksQ, (GDestroyNotify)_scoreboardblock_free);
-        scoreboard->blocksQ = g_queue_new();
-    }
+    g_array_set_size(scoreboard->blocks, 0);
 }
 
 void scoreboard_free(ScoreBoard* scoreboard) {
     MAGIC_ASSERT(scoreboard);
-    scoreboard_clear(scoreboard);
-    g_queue_free(scoreboard->blocksQ);
+    g_array_free(scoreboard->blocks, TRUE);
+    g_array_free(scoreboard->spareBlocks, TRUE);
     MAGIC_CLEAR(scoreboard);
     g_free(scoreboard);
 }
 
-static ScoreBoardBlock* _scoreboard_addBlock(ScoreBoard* scoreboard, gint sequence, BlockStatus status) {
-    MAGIC_ASSERT(scoreboard);
+/* returns the index of the first block that ends after sequence, or the number of blocks */
+static guint _scoreboard_findBlock(ScoreBoard* scoreboard, gint sequence) {
+    guint low = 0, high = scoreboard->blocks->len;
+    while(low < high) {
+        guint middle = low + (high - low) / 2;
+        if(_scoreboard_getBlock(scoreboard->blocks, middle)->end <= sequence) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* appends packets [start, end) with the status of the given block, extending the last
+ * block instead if they can be merged */
+static void _scoreboard_appendBlock(GArray* blocks, ScoreBoardBlock* block, gint start, gint end) {
+    if(start >= end) {
+        return;
+    }
 
-    ScoreBoardBlock* block = _scoreboardblock_new(sequence, status);
-    g_queue_insert_sorted(scoreboard->blocksQ, block, (GCompareDataFunc) _scoreboardblock_compareSequenceData, NULL);
+    ScoreBoardBlock appended = *block;
+    appended.start = start;
+    appended.end = end;
 
-    return block;
+    if(blocks->len > 0) {
+        ScoreBoardBlock* last = _scoreboard_getBlock(blocks, blocks->len - 1);
+        if(_scoreboardblock_canMerge(last, &appended)) {
+            last->end = end;
+            return;
+        }
+    }
+    g_array_append_val(blocks, appended);
 }
 
-static ScoreBoardBlock* _scoreboard_findBlock(ScoreBoard* scoreboard, gint sequence) {
-    MAGIC_ASSERT(scoreboard);
+/* starts rebuilding the blocks into the spare array */
+static GArray* _scoreboard_beginRebuild(ScoreBoard* scoreboard) {
+    g_array_set_size(scoreboard->spareBlocks, 0);
+    return scoreboard->spareBlocks;
+}
 
-    ScoreBoardBlock b;
-    b.sequence = sequence;
-    GList* link = g_queue_find_custom(scoreboard->blocksQ, &b, (GCompareFunc)_scoreboardblock_compareSequence);
+static void _scoreboard_finishRebuild(ScoreBoard* scoreboard) {
+    GArray* blocks = scoreboard->blocks;
+    scoreboard->blocks = scoreboard->spareBlocks;
+    scoreboard->spareBlocks = blocks;
+}
 
-    return link ? (ScoreBoardBlock*)link->data : NULL;
+/* sets the status of the single packet in the given block, splitting the block that
+ * holds it or adding it if no block does */
+static void _scoreboard_setPacket(ScoreBoard* scoreboard, ScoreBoardBlock* packet) {
+    GArray* blocks = scoreboard->blocks;
+    gint sequence = packet->start;
+    guint index = _scoreboard_findBlock(scoreboard, sequence);
+
+    if(index < blocks->len && _scoreboard_getBlock(blocks, index)->start <= sequence) {
+        /* cut the packet out of the block that holds it */
+        ScoreBoardBlock left = *_scoreboard_getBlock(blocks, index);
+        ScoreBoardBlock right = left;
+        left.end = sequence;
+        right.start = sequence + 1;
+
+        g_array_remove_index(blocks, index);
+        if(right.start < right.end) {
+            g_array_insert_val(blocks, index, right);
+        }
+        if(left.start < left.end) {
+            g_array_insert_val(blocks, index, left);
+            index++;
+        }
+    }
+
+    ScoreBoardBlock* previous = index > 0 ? _scoreboard_getBlock(blocks, index - 1) : NULL;
+    ScoreBoardBlock* next = index < blocks->len ? _scoreboard_getBlock(blocks, index) : NULL;
+
+    if(previous && _scoreboardblock_canMerge(previous, packet)) {
+        previous->end = packet->end;
+        if(next && _scoreboardblock_canMerge(previous, next)) {
+            previous->end = next->end;
+            g_array_remove_index(blocks, index);
+        }
+    } else if(next && _scoreboardblock_canMerge(packet, next)) {
+        next->start = packet->start;
+    } else {
+        g_array_insert_val(blocks, index, *packet);
+    }
 }
 
 static gchar* _scoreboard_getStatusString(BlockStatus status) {
@@ -140,129 +188,213 @@ static gchar* _scoreboard_getStatusString(BlockStatus status) {
     return "UNKNOWN";
 }
 
-static void _scoreboardblock_appendString(ScoreBoardBlock* block, GString* msg) {
-    g_string_append_printf(msg, " %d (st=%s nxt=%d rtx=%d)", block->sequence, _scoreboard_getStatusString(block->status), block->nextSend, block->retransmissionId);
-}
-
 static void _scoreboard_dump(ScoreBoard* scoreboard) {
     MAGIC_ASSERT(scoreboard);
 
     GString* msg = g_string_new("");
     g_string_append_printf(msg, "[SCOREBOARD] fack=%d ackRtx=%d |", scoreboard->fack, scoreboard->ackedRetransmissionId);
-    g_queue_foreach(scoreboard->blocksQ, (GFunc)_scoreboardblock_appendString, msg);
+    for(guint i = 0; i < scoreboard->blocks->len; i++) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, i);
+        g_string_append_printf(msg, " %d-%d (st=%s nxt=%d rtx=%d)", block->start, block->end - 1,
+                _scoreboard_getStatusString(block->status), block->nextSend, block->retransmissionId);
+    }
 
     message("%s", msg->str);
     g_string_free(msg, TRUE);
 }
 
-static gint _scoreboard_compareSack(gconstpointer s1, gconstpointer s2) {
-    gint sack1 = GPOINTER_TO_INT(s1);
-    gint sack2 = GPOINTER_TO_INT(s2);
-    return sack1 < sack2 ? -1 : sack1 > sack2 ? 1 : 0;
-}
-
 static void _scoreboard_removeAcked(ScoreBoard* scoreboard, gint32 unacked) {
     MAGIC_ASSERT(scoreboard);
 
-    /* reconstruct the blocks queue to avoid editing it in-place */
-    GQueue* updatedBlocksQ = g_queue_new();
+    /* the blocks are sorted, so the acked ones are all at the front */
+    guint index = _scoreboard_findBlock(scoreboard, (gint)unacked);
+    if(index > 0) {
+        g_array_remove_range(scoreboard->blocks, 0, index);
+    }
+    if(scoreboard->blocks->len > 0) {
+        ScoreBoardBlock* first = _scoreboard_getBlock(scoreboard->blocks, 0);
+        first->start = MAX(first->start, (gint)unacked);
+    }
+}
 
-    /* keep all blocks that have not been fully ACKed */
-    while(!g_queue_is_empty(scoreboard->blocksQ)) {
-        ScoreBoardBlock* block = g_queue_pop_head(scoreboard->blocksQ);
-        if(block->sequence < ((gint)unacked)) {
-            /* the block has been acked, destroy it */
-            _scoreboardblock_free(block);
-        } else {
-            /* the block has not yet been acked, keep it */
-            g_queue_push_tail(updatedBlocksQ, block);
+/* appends packets [start, end), marking the ones that were selectively acked as SACKED
+ * and giving the others the status of the given block */
+static void _scoreboard_appendSelectiveACKs(ScoreBoard* scoreboard, GArray* blocks,
+        RangeSet* selectiveACKs, ScoreBoardBlock* block, gint start, gint end) {
+    ScoreBoardBlock sacked = {0};
+    sacked.status = BLOCK_STATUS_SACKED;
+
+    gint position = start;
+    guint nRanges = rangeset_getNumRanges(selectiveACKs);
+    for(guint i = rangeset_find(selectiveACKs, (guint)start); i < nRanges && position < end; i++) {
+        guint sackStart = 0, sackEnd = 0;
+        rangeset_getRange(selectiveACKs, i, &sackStart, &sackEnd);
+
+        gint sackedStart = MAX(position, (gint)sackStart);
+        gint sackedEnd = MIN(end, (gint)sackEnd);
+        if(sackedStart >= end) {
+            break;
         }
+
+        _scoreboard_appendBlock(blocks, block, position, sackedStart);
+        _scoreboard_appendBlock(blocks, &sacked, sackedStart, sackedEnd);
+        if(block->status == BLOCK_STATUS_RETRANSMITTED) {
+            scoreboard->ackedRetransmissionId = block->retransmissionId;
+        }
+        position = sackedEnd;
     }
 
-    /* clean up the old blocks queue */
-    g_queue_free(scoreboard->blocksQ);
-    scoreboard->blocksQ = updatedBlocksQ;
+    _scoreboard_appendBlock(blocks, block, position, end);
 }
 
-TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs, gint32 unacked, gint32 next) {
+/* applies the selective acks to packets [start, end), adding blocks for packets that are
+ * not yet in the scoreboard. returns TRUE if any blocks were added. */
+static gboolean _scoreboard_updateSelectiveACKs(ScoreBoard* scoreboard, RangeSet* selectiveACKs,
+        gint start, gint end) {
     MAGIC_ASSERT(scoreboard);
-    utility_assert(unacked <= next);
 
-    TCPProcessFlags flag = TCP_PF_NONE;
+    ScoreBoardBlock inflight = {0};
+    inflight.status = BLOCK_STATUS_INFLIGHT;
 
-    _scoreboard_removeAcked(scoreboard, unacked);
+    GArray* updated = _scoreboard_beginRebuild(scoreboard);
+    gboolean isAdded = FALSE;
+    /* the first packet in [start, end) that we have not appended yet */
+    gint position = start;
 
-    if(selectiveACKs) {
-        selectiveACKs = g_list_sort(selectiveACKs, (GCompareFunc)_scoreboard_compareSack);
+    for(guint i = 0; i < scoreboard->blocks->len; i++) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, i);
 
-        gint firstSeq = (gint)MAX(unacked, GPOINTER_TO_INT(g_list_first(selectiveACKs)->data));
-        gint lastSeq = 0;
-        if(next > 0) {
-            lastSeq = (gint)MIN((next-1), GPOINTER_TO_INT(g_list_last(selectiveACKs)->data));
+        if(block->end <= start || block->start >= end) {
+            if(block->start >= end && position < end) {
+                _scoreboard_appendSelectiveACKs(scoreboard, updated, selectiveACKs, &inflight, position, end);
+                isAdded = TRUE;
+                position = end;
+            }
+            _scoreboard_appendBlock(updated, block, block->start, block->end);
+            continue;
         }
-        scoreboard->fack = MAX(scoreboard->fack, lastSeq);
 
-        /* go through all sequence that might be sacked and update scoreboard */
-        for(gint seq = firstSeq; seq <= lastSeq; seq++) {
-            GList* findResult = g_list_find(selectiveACKs, GINT_TO_POINTER(seq));
-            gboolean sacked = findResult ? TRUE : FALSE;
-            BlockStatus status = (sacked ? BLOCK_STATUS_SACKED : BLOCK_STATUS_INFLIGHT);
-
-            ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, seq);
-            if(!block) {
-                _scoreboard_addBlock(scoreboard, seq, status);
-                flag |= TCP_PF_DATA_SACKED;
-            } else if(status == BLOCK_STATUS_SACKED) {
-                if(block->status == BLOCK_STATUS_RETRANSMITTED) {
-                    scoreboard->ackedRetransmissionId = block->retransmissionId;
-                }
-                block->status = status;
-            }
+        _scoreboard_appendBlock(updated, block, block->start, start);
+        if(block->start > position) {
+            _scoreboard_appendSelectiveACKs(scoreboard, updated, selectiveACKs, &inflight, position, block->start);
+            isAdded = TRUE;
         }
+
+        position = MIN(block->end, end);
+        _scoreboard_appendSelectiveACKs(scoreboard, updated, selectiveACKs, block,
+                MAX(block->start, start), position);
+        _scoreboard_appendBlock(updated, block, end, block->end);
     }
 
-    /* update duplicate ACK count */
-    if(scoreboard->lastAcknowledgment == unacked) {
-        scoreboard->duplicateACKCount += 1;
-    } else {
-        scoreboard->duplicateACKCount = 0;
+    if(position < end) {
+        _scoreboard_appendSelectiveACKs(scoreboard, updated, selectiveACKs, &inflight, position, end);
+        isAdded = TRUE;
     }
-    scoreboard->lastAcknowledgment = unacked;
 
-    /* go through all the blocks and check if any of the INFLIGHT ones need to be retransmitted */
-    for(guint i = 0; i < g_queue_get_length(scoreboard->blocksQ); i++) {
-        ScoreBoardBlock* block = (ScoreBoardBlock*)g_queue_peek_nth(scoreboard->blocksQ, i);
-        if(!block) continue;
+    _scoreboard_finishRebuild(scoreboard);
+    return isAdded;
+}
+
+/* marks the INFLIGHT and RETRANSMITTED packets that should be retransmitted as LOST */
+static TCPProcessFlags _scoreboard_detectLoss(ScoreBoard* scoreboard) {
+    MAGIC_ASSERT(scoreboard);
+
+    TCPProcessFlags flag = TCP_PF_NONE;
+    ScoreBoardBlock lost = {0};
+    lost.status = BLOCK_STATUS_LOST;
+
+    GArray* updated = _scoreboard_beginRebuild(scoreboard);
+
+    for(guint i = 0; i < scoreboard->blocks->len; i++) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, i);
 
         switch(block->status) {
-            case BLOCK_STATUS_INFLIGHT:
+            case BLOCK_STATUS_INFLIGHT: {
+                /* packets at least 4 behind the furthest SACK have been skipped by 3 duplicate ACKs */
+                gint lostEnd = CLAMP(scoreboard->fack - 3, block->start, block->end);
+                gint position = lostEnd;
+                gint nLost = lostEnd - block->start;
+                _scoreboard_appendBlock(updated, &lost, block->start, lostEnd);
+
                 /* checks for 3 duplicate ACKs */
-                if(block->sequence <= scoreboard->fack - 4 || 
-                   (block->sequence == scoreboard->lastAcknowledgment && scoreboard->duplicateACKCount == 3)) {
-                    block->status = BLOCK_STATUS_LOST;
-                    scoreboard->fackOut += 1;
+                gint lastAcknowledgment = scoreboard->lastAcknowledgment;
+                if(scoreboard->duplicateACKCount == 3 &&
+                        lastAcknowledgment >= position && lastAcknowledgment < block->end) {
+                    _scoreboard_appendBlock(updated, block, position, lastAcknowledgment);
+                    _scoreboard_appendBlock(updated, &lost, lastAcknowledgment, lastAcknowledgment + 1);
+                    position = lastAcknowledgment + 1;
+                    nLost++;
+                }
+
+                _scoreboard_appendBlock(updated, block, position, block->end);
+
+                if(nLost > 0) {
+                    scoreboard->fackOut += nLost;
                     flag |= TCP_PF_DATA_LOST;
                 }
                 break;
+            }
 
             case BLOCK_STATUS_RETRANSMITTED:
                 if((block->nextSend <= scoreboard->fack) ||
                    (block->retransmissionId + 4 < scoreboard->ackedRetransmissionId)) {
-                    block->status = BLOCK_STATUS_LOST;
-                    scoreboard->fackOut += 1;
+                    _scoreboard_appendBlock(updated, &lost, block->start, block->end);
+                    scoreboard->fackOut += block->end - block->start;
                     flag |= TCP_PF_DATA_LOST;
+                } else {
+                    _scoreboard_appendBlock(updated, block, block->start, block->end);
                 }
                 break;
 
             case BLOCK_STATUS_LOST:
-                break;
-
             case BLOCK_STATUS_SACKED:
+                _scoreboard_appendBlock(updated, block, block->start, block->end);
                 break;
         }
+    }
 
+    _scoreboard_finishRebuild(scoreboard);
+    return flag;
+}
+
+TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, RangeSet* selectiveACKs, gint32 unacked, gint32 next) {
+    MAGIC_ASSERT(scoreboard);
+    utility_assert(unacked <= next);
+
+    TCPProcessFlags flag = TCP_PF_NONE;
+
+    _scoreboard_removeAcked(scoreboard, unacked);
+
+    if(selectiveACKs && !rangeset_isEmpty(selectiveACKs)) {
+        guint firstSack = 0, lastSackEnd = 0;
+        rangeset_getRange(selectiveACKs, 0, &firstSack, NULL);
+        rangeset_getRange(selectiveACKs, rangeset_getNumRanges(selectiveACKs) - 1, NULL, &lastSackEnd);
+
+        gint firstSeq = (gint)MAX(unacked, (gint)firstSack);
+        gint lastSeq = 0;
+        if(next > 0) {
+            lastSeq = (gint)MIN((next-1), (gint)lastSackEnd - 1);
+        }
+        scoreboard->fack = MAX(scoreboard->fack, lastSeq);
+
+        /* update the scoreboard for all sequences that might be sacked */
+        if(firstSeq <= lastSeq &&
+                _scoreboard_updateSelectiveACKs(scoreboard, selectiveACKs, firstSeq, lastSeq + 1)) {
+            flag |= TCP_PF_DATA_SACKED;
+        }
     }
 
+    /* update duplicate ACK count */
+    if(scoreboard->lastAcknowledgment == unacked) {
+        scoreboard->duplicateACKCount += 1;
+    } else {
+        scoreboard->duplicateACKCount = 0;
+    }
+    scoreboard->lastAcknowledgment = unacked;
+
+    /* go through all the blocks and check if any of the INFLIGHT ones need to be retransmitted */
+    flag |= _scoreboard_detectLoss(scoreboard);
+
     //_scoreboard_dump(scoreboard);
 
     return flag;
@@ -271,18 +403,21 @@ TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs,
 gint scoreboard_getNextRetransmit(ScoreBoard* scoreboard) {
     MAGIC_ASSERT(scoreboard);
 
-    ScoreBoardBlock b;
-    b.status = BLOCK_STATUS_LOST;
-    GList* link = g_queue_find_custom(scoreboard->blocksQ, &b, (GCompareFunc)_scoreboardblock_compareStatus);
+    for(guint i = 0; i < scoreboard->blocks->len; i++) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, i);
+        if(block->status == BLOCK_STATUS_LOST) {
+            return block->start;
+        }
+    }
 
-    return link ? ((ScoreBoardBlock*)(link->data))->sequence : -1;
+    return -1;
 }
 
 void scoreboard_markRetransmitted(ScoreBoard* scoreboard, gint sequence, gint nextSend) {
     MAGIC_ASSERT(scoreboard);
 
-    ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, sequence);
-    if(!block) {
+    guint index = _scoreboard_findBlock(scoreboard, sequence);
+    if(index >= scoreboard->blocks->len || _scoreboard_getBlock(scoreboard->blocks, index)->start > sequence) {
         warning("Couldn't find block for sequence %d to mark retransmitted", sequence);
         return;
     }
@@ -292,57 +427,70 @@ void scoreboard_markRetransmitted(ScoreBoard* scoreboard, gint sequence, gint ne
         warning("fack out is negative at %d with sequence %d and next send %d", scoreboard->fackOut, sequence, nextSend);
     }
 
-    block->status = BLOCK_STATUS_RETRANSMITTED;
-    block->nextSend = nextSend;
-    block->retransmissionId = scoreboard->retransmissionId;
+    ScoreBoardBlock retransmitted = {0};
+    retransmitted.start = sequence;
+    retransmitted.end = sequence + 1;
+    retransmitted.status = BLOCK_STATUS_RETRANSMITTED;
+    retransmitted.nextSend = nextSend;
+    retransmitted.retransmissionId = scoreboard->retransmissionId;
     scoreboard->retransmissionId++;
+
+    _scoreboard_setPacket(scoreboard, &retransmitted);
 }
 
 void scoreboard_packetDropped(ScoreBoard* scoreboard, gint sequence) {
     MAGIC_ASSERT(scoreboard);
 
-    ScoreBoardBlock* block = _scoreboard_findBlock(scoreboard, sequence);
-    if(!block) {
-        block = _scoreboard_addBlock(scoreboard, sequence, BLOCK_STATUS_INFLIGHT);
-    }
-
-    if(block->status != BLOCK_STATUS_INFLIGHT) {
-        return;
+    /* a packet that is not in the scoreboard yet is in flight */
+    guint index = _scoreboard_findBlock(scoreboard, sequence);
+    if(index < scoreboard->blocks->len) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, index);
+        if(block->start <= sequence && block->status != BLOCK_STATUS_INFLIGHT) {
+            return;
+        }
     }
 
-    block->status = BLOCK_STATUS_LOST;
+    ScoreBoardBlock lost = {0};
+    lost.start = sequence;
+    lost.end = sequence + 1;
+    lost.status = BLOCK_STATUS_LOST;
+    _scoreboard_setPacket(scoreboard, &lost);
 
     scoreboard->fackOut++;
 }
 
-static void _scoreboard_markLossHelper(ScoreBoardBlock* block, ScoreBoard* scoreboard) {
-    MAGIC_ASSERT(scoreboard);
-    MAGIC_ASSERT(block);
-    if(block->status != BLOCK_STATUS_SACKED) {
-        if(block->status != BLOCK_STATUS_LOST) {
-            scoreboard->fackOut += 1;
-        }
-        block->status = BLOCK_STATUS_LOST;
-    }
-}
-
 void scoreboard_markLoss(ScoreBoard* scoreboard, gint unacked, gint nextSend) {
     MAGIC_ASSERT(scoreboard);
 
-    g_queue_foreach(scoreboard->blocksQ, (GFunc)_scoreboard_markLossHelper, scoreboard);
+    ScoreBoardBlock lost = {0};
+    lost.status = BLOCK_STATUS_LOST;
+
+    /* everything that was not selectively acked is lost */
+    GArray* updated = _scoreboard_beginRebuild(scoreboard);
+    for(guint i = 0; i < scoreboard->blocks->len; i++) {
+        ScoreBoardBlock* block = _scoreboard_getBlock(scoreboard->blocks, i);
+        if(block->status == BLOCK_STATUS_SACKED) {
+            _scoreboard_appendBlock(updated, block, block->start, block->end);
+        } else {
+            if(block->status != BLOCK_STATUS_LOST) {
+                scoreboard->fackOut += block->end - block->start;
+            }
+            _scoreboard_appendBlock(updated, &lost, block->start, block->end);
+        }
+    }
+    _scoreboard_finishRebuild(scoreboard);
 
     gint start = unacked;
-    BlockStatus status = BLOCK_STATUS_LOST;
-    if(!g_queue_is_empty(scoreboard->blocksQ)) {
-        ScoreBoardBlock* block = g_queue_peek_tail(scoreboard->blocksQ);
-        start = block->sequence + 1;
-        status = BLOCK_STATUS_INFLIGHT;
+    ScoreBoardBlock added = lost;
+    if(scoreboard->blocks->len > 0) {
+        start = _scoreboard_getBlock(scoreboard->blocks, scoreboard->blocks->len - 1)->end;
+        added.status = BLOCK_STATUS_INFLIGHT;
     }
 
-    for(gint sequence = start; sequence < nextSend; sequence++) {
-        _scoreboard_addBlock(scoreboard, sequence, status);
-        if(status == BLOCK_STATUS_LOST) {
-            scoreboard->fackOut += 1;
+    if(start < nextSend) {
+        _scoreboard_appendBlock(scoreboard->blocks, &added, start, nextSend);
+        if(added.status == BLOCK_STATUS_LOST) {
+            scoreboard->fackOut += nextSend - start;
         }
     }
 
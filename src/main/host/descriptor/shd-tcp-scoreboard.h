@@ -15,7 +15,7 @@ ScoreBoard* scoreboard_new();
 void scoreboard_clear(ScoreBoard* scoreboard);
 void scoreboard_free(ScoreBoard* scoreboard);
 
-TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, GList* selectiveACKs, gint32 unacked, gint32 next);
+TCPProcessFlags scoreboard_update(ScoreBoard* scoreboard, RangeSet* selectiveACKs, gint32 unacked, gint32 next);
 gint scoreboard_getNextRetransmit(ScoreBoard* scoreboard);
 void scoreboard_markRetransmitted(ScoreBoard* scoreboard, gint sequence, gint sendNext);
 void scoreboard_markLoss(ScoreBoard* scoreboard, gint unacked, gint sendNext);
@@ -127,13 +127,13 @@ struct _TCP {
         guint32 highestSequence;
         /* total number of packets sent */
         guint32 packetsSent;
-        /* list of selective ACKs, packets received after a missing packet */
-        GList* selectiveACKs;
+        /* selective ACKs, packets received after a missing packet */
+        RangeSet* selectiveACKs;
     } send;
 
     struct {
         /* TCP provides reliable transport, keep track of packets until they are acked */
-        GHashTable* queue;
+        RetransmitQueue* queue;
         /* track amount of queued application data */
         gsize queueLength;
         /* retransmission timeout value (rto), in milliseconds */
@@ -669,7 +669,10 @@ static void _tcp_updateSendWindow(TCP* tcp) {
     tcp->send.window = (guint32)MIN(tcp->congestion->window, (gint)tcp->receive.lastWindow);
 }
 
-static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, gconstpointer payload, gsize payloadLength) {
+/* the packet carries payloadLength bytes of the payload starting at payloadOffset, or a
+ * virtual payload of that length if payload is NULL */
+static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, Payload* payload,
+        gsize payloadOffset, gsize payloadLength) {
     MAGIC_ASSERT(tcp);
 
     /*
@@ -702,7 +705,14 @@ static Packet* _tcp_createPacket(TCP* tcp, enum ProtocolTCPFlags flags, gconstpo
     guint sequence = payloadLength > 0 || isFinNotAck ? tcp->send.next : 0;
 
     /* create the TCP packet. the ack, window, and timestamps will be set in _tcp_flush */
-    Packet* packet = packet_new(payload, payloadLength);
+    Packet* packet = NULL;
+    if(payload) {
+        packet = packet_newFromPayload(payload, payloadOffset, payloadLength);
+    } else if(payloadLength > 0) {
+        packet = packet_newVirtual(payloadLength);
+    } else {
+        packet = packet_new(NULL, 0);
+    }
     packet_setDropNotificationDelay(packet, (tcp->congestion->rttSmoothed * 2) * SIMTIME_ONE_MILLISECOND);
     packet_setTCP(packet, flags, sourceIP, sourcePort, destinationIP, destinationPort, sequence);
     packet_addDeliveryStatus(packet, PDS_SND_CREATED);
@@ -722,7 +732,7 @@ static void _tcp_addRetransmit(TCP* tcp, Packet* packet) {
 
     PacketTCPHeader header;
     packet_getTCPHeader(packet, &header);
-    g_hash_table_insert(tcp->retransmit.queue, GINT_TO_POINTER(header.sequence), packet);
+    retransmitqueue_add(tcp->retransmit.queue, header.sequence, packet);
     packet_addDeliveryStatus(packet, PDS_SND_TCP_ENQUEUE_RETRANSMIT);
 
     tcp->retransmit.queueLength += packet_getPayloadLength(packet);
@@ -735,19 +745,12 @@ static void _tcp_addRetransmit(TCP* tcp, Packet* packet) {
 static void _tcp_clearRetransmit(TCP* tcp, guint sequence) {
     MAGIC_ASSERT(tcp);
 
-    GHashTableIter iter;
-    gpointer key, value;
-    g_hash_table_iter_init(&iter, tcp->retransmit.queue);
-
-    while(g_hash_table_iter_next(&iter, &key, &value)) {
-        guint ackedSequence = GPOINTER_TO_INT(key);
-        Packet* ackedPacket = (Packet*)value;
-
-        if(ackedSequence < sequence) {
-            tcp->retransmit.queueLength -= packet_getPayloadLength(ackedPacket);
-            packet_addDeliveryStatus(ackedPacket, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
-            g_hash_table_iter_remove(&iter);
-        }
+    /* the queue is in sequence order, so only the acked packets are visited */
+    Packet* ackedPacket = NULL;
+    while((ackedPacket = retransmitqueue_popBefore(tcp->retransmit.queue, sequence)) != NULL) {
+        tcp->retransmit.queueLength -= packet_getPayloadLength(ackedPacket);
+        packet_addDeliveryStatus(ackedPacket, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
+        packet_unref(ackedPacket);
     }
 
     if(_tcp_getBufferSpaceOut(tcp) > 0) {
@@ -857,7 +860,8 @@ static void _tcp_updateRTTEstimate(TCP* tcp, SimulationTime timestamp) {
 static void _tcp_retransmitPacket(TCP* tcp, gint sequence) {
     MAGIC_ASSERT(tcp);
 
-    Packet* packet = g_hash_table_lookup(tcp->retransmit.queue, GINT_TO_POINTER(sequence));
+    /* remove from queue and update length and status */
+    Packet* packet = retransmitqueue_steal(tcp->retransmit.queue, (guint)sequence);
     /* if packet wasn't found is was most likely retransmitted from a previous SACK
      * but has yet to be received/acknowledged by the receiver */
     if(!packet) {
@@ -866,9 +870,13 @@ static void _tcp_retransmitPacket(TCP* tcp, gint sequence) {
 
     debug("retransmitting packet %d", sequence);
 
-    /* remove from queue and update length and status */
-    g_hash_table_steal(tcp->retransmit.queue, GINT_TO_POINTER(sequence));
     tcp->retransmit.queueLength -= packet_getPayloadLength(packet);
+
+    /* the original may still be on its way to or held by the receiver, so send a copy
+     * that we are free to update without the two workers sharing the packet */
+    Packet* original = packet;
+    packet = packet_copy(original);
+    packet_unref(original);
     packet_addDeliveryStatus(packet, PDS_SND_TCP_DEQUEUE_RETRANSMIT);
 
     if(_tcp_getBufferSpaceOut(tcp) > 0) {
@@ -1057,7 +1065,7 @@ static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData) {
         return;
     }
 
-    if(g_hash_table_size(tcp->retransmit.queue) == 0) {
+    if(retransmitqueue_getLength(tcp->retransmit.queue) == 0) {
         _tcp_stopRetransmitTimer(tcp);
         return;
     }
@@ -1091,7 +1099,7 @@ static void _tcp_runRetransmitTimerExpiredTask(TCP* tcp, gpointer userData) {
 
     /* resend the next unacked packet */
     gint sequence = (gint)tcp->send.unacked;
-    if(tcp->send.unacked == 1 && g_hash_table_lookup(tcp->retransmit.queue, GINT_TO_POINTER(0))) {
+    if(tcp->send.unacked == 1 && retransmitqueue_get(tcp->retransmit.queue, 0)) {
         sequence = 0;
     }
 
@@ -1244,7 +1252,7 @@ gint tcp_connectToPeer(TCP* tcp, in_addr_t ip, in_port_t port, sa_family_t famil
     socket_setPeerName(&(tcp->super), ip, port);
 
     /* send 1st part of 3-way handshake, state->syn_sent */
-    Packet* packet = _tcp_createPacket(tcp, PTCP_SYN, NULL, 0);
+    Packet* packet = _tcp_createPacket(tcp, PTCP_SYN, NULL, 0, 0);
 
     /* dont have to worry about space since this has no payload */
     _tcp_bufferPacketOut(tcp, packet);
@@ -1350,24 +1358,6 @@ static TCP* _tcp_getSourceTCP(TCP* tcp, in_addr_t ip, in_port_t port) {
     return tcp;
 }
 
-static GList* _tcp_removeSacks(GList* selectiveACKs, gint sequence) {
-    GList *unacked = NULL;
-    if(selectiveACKs) {
-        GList *iter = selectiveACKs;
-        while(iter) {
-            gint sackSequence = GPOINTER_TO_INT(iter->data);
-
-            if(sackSequence > sequence) {
-                unacked = g_list_append(unacked, iter->data);
-            }
-
-            iter = g_list_next(iter);
-        }
-        g_list_free(selectiveACKs);
-    }
-    return unacked;
-}
-
 TCPProcessFlags _tcp_dataProcessing(TCP* tcp, Packet* packet, PacketTCPHeader *header) {
     MAGIC_ASSERT(tcp);
 
@@ -1393,27 +1383,11 @@ TCPProcessFlags _tcp_dataProcessing(TCP* tcp, Packet* packet, PacketTCPHeader *h
 
         /* SACK: if not next packet, one was dropped and we need to include this in the selective ACKs */
         if(!isNextPacket) {
-            tcp->send.selectiveACKs = g_list_append(tcp->send.selectiveACKs, GINT_TO_POINTER(header->sequence));
-        } else if(tcp->send.selectiveACKs && g_list_length(tcp->send.selectiveACKs) > 0) {
-            /* find the first gap in SACKs and remove everything before it */
-            GList *iter = g_list_first(tcp->send.selectiveACKs);
-            GList *next = g_list_next(iter);
-
-            gint firstSequence = GPOINTER_TO_INT(iter->data);
-            if(firstSequence <= header->sequence + 1) {
-                while(next) {
-                    gint currSequence = GPOINTER_TO_INT(iter->data);
-                    gint nextSequence = GPOINTER_TO_INT(next->data);
-                    /* check for a gap in sequences */
-                    if(currSequence + 1 < nextSequence && currSequence > header->sequence) {
-                        break;
-                    }
-                    iter = next;
-                    next = g_list_next(iter);
-                }
-
-                tcp->send.selectiveACKs = _tcp_removeSacks(tcp->send.selectiveACKs, GPOINTER_TO_INT(iter->data));
-            }
+            rangeset_add(tcp->send.selectiveACKs, header->sequence);
+        } else {
+            /* the SACKs up to the first gap after this packet are now in order, remove them */
+            guint gap = rangeset_getRangeEnd(tcp->send.selectiveACKs, header->sequence + 1);
+            rangeset_removeBelow(tcp->send.selectiveACKs, gap);
         }
 
         DescriptorStatus s = descriptor_getStatus((Descriptor*) tcp);
@@ -1756,11 +1730,8 @@ void tcp_processPacket(TCP* tcp, Packet* packet) {
     }
 
     /* update the scoreboard and see if any packets have been lost */
-    GList* selectiveACKs = packet_copyTCPSelectiveACKs(packet);
+    RangeSet* selectiveACKs = packet_getTCPSelectiveACKs(packet);
     flags |= scoreboard_update(tcp->retransmit.scoreboard, selectiveACKs, tcp->send.unacked, tcp->send.next);
-    if(selectiveACKs) {
-        g_list_free(selectiveACKs);
-    }
 
     /* update the last time stamp value (RFC 1323) */
     tcp->receive.lastTimestamp = header.timestampValue;
@@ -1799,7 +1770,7 @@ void tcp_processPacket(TCP* tcp, Packet* packet) {
     if(responseFlags != PTCP_NONE) {
         debug("%s <-> %s: sending response control packet",
                 tcp->super.boundString, tcp->super.peerString);
-        Packet* response = _tcp_createPacket(tcp, responseFlags, NULL, 0);
+        Packet* response = _tcp_createPacket(tcp, responseFlags, NULL, 0, 0);
         _tcp_bufferPacketOut(tcp, response);
         _tcp_flush(tcp);
     }
@@ -1863,16 +1834,19 @@ gssize tcp_sendUserData(TCP* tcp, gconstpointer buffer, gsize nBytes, in_addr_t
     gsize space = _tcp_getBufferSpaceOut(tcp);
     gsize remaining = MIN(acceptable, space);
 
-    /* break data into segments and send each in a packet */
+    /* break data into segments and send each in a packet. we copy the data once, and
+     * the packets share it unless the host only sends virtual payloads */
     gsize maxPacketLength = CONFIG_MTU - CONFIG_HEADER_SIZE_TCPIPETH;
     gsize bytesCopied = 0;
+    Payload* payload = (remaining > 0 && !host_usesVirtualPayloads(worker_getActiveHost())) ?
+            payload_new(buffer, remaining) : NULL;
 
     /* create as many packets as needed */
     while(remaining > 0) {
         gsize copyLength = MIN(maxPacketLength, remaining);
 
         /* use helper to create the packet */
-        Packet* packet = _tcp_createPacket(tcp, PTCP_ACK, buffer + bytesCopied, copyLength);
+        Packet* packet = _tcp_createPacket(tcp, PTCP_ACK, payload, bytesCopied, copyLength);
         if(copyLength > 0) {
             /* we are sending more user data */
             tcp->send.end++;
@@ -1885,6 +1859,11 @@ gssize tcp_sendUserData(TCP* tcp, gconstpointer buffer, gsize nBytes, in_addr_t
         bytesCopied += copyLength;
     }
 
+    /* the packets hold their own references */
+    if(payload) {
+        payload_unref(payload);
+    }
+
     debug("%s <-> %s: sending %"G_GSIZE_FORMAT" user bytes", tcp->super.boundString, tcp->super.peerString, bytesCopied);
 
     /* now flush as much as possible out to socket */
@@ -1900,7 +1879,7 @@ static void _tcp_sendWindowUpdate(TCP* tcp, gpointer data) {
             tcp->super.boundString, tcp->super.peerString, tcp->receive.window);
 
     // XXX we may be in trouble if this packet gets dropped
-    Packet* windowUpdate = _tcp_createPacket(tcp, PTCP_ACK, NULL, 0);
+    Packet* windowUpdate = _tcp_createPacket(tcp, PTCP_ACK, NULL, 0, 0);
     _tcp_bufferPacketOut(tcp, windowUpdate);
     _tcp_flush(tcp);
 
@@ -2049,7 +2028,7 @@ void tcp_free(TCP* tcp) {
 
     priorityqueue_free(tcp->throttledOutput);
     priorityqueue_free(tcp->unorderedInput);
-    g_hash_table_destroy(tcp->retransmit.queue);
+    retransmitqueue_free(tcp->retransmit.queue);
     priorityqueue_free(tcp->retransmit.scheduledTimerExpirations);
 
     if(tcp->child) {
@@ -2071,6 +2050,7 @@ void tcp_free(TCP* tcp) {
 
     tcpCongestion_free(tcp->congestion);
     scoreboard_free(tcp->retransmit.scoreboard);
+    rangeset_free(tcp->send.selectiveACKs);
 
     MAGIC_CLEAR(tcp);
     g_free(tcp);
@@ -2095,7 +2075,7 @@ void tcp_close(TCP* tcp) {
 
         case TCPS_SYNRECEIVED:
         case TCPS_SYNSENT: {
-            Packet* reset = _tcp_createPacket(tcp, PTCP_RST, NULL, 0);
+            Packet* reset = _tcp_createPacket(tcp, PTCP_RST, NULL, 0, 0);
             _tcp_bufferPacketOut(tcp, reset);
             _tcp_flush(tcp);
             return;
@@ -2110,7 +2090,7 @@ void tcp_close(TCP* tcp) {
     }
 
     /* send a FIN */
-    Packet* packet = _tcp_createPacket(tcp, PTCP_FIN, NULL, 0);
+    Packet* packet = _tcp_createPacket(tcp, PTCP_FIN, NULL, 0, 0);
 
     /* dont have to worry about space since this has no payload */
     _tcp_bufferPacketOut(tcp, packet);
@@ -2192,9 +2172,9 @@ TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize) {
             priorityqueue_new((GCompareDataFunc)packet_compareTCPSequence, NULL, (GDestroyNotify)packet_unref);
     tcp->unorderedInput =
             priorityqueue_new((GCompareDataFunc)packet_compareTCPSequence, NULL, (GDestroyNotify)packet_unref);
-    tcp->retransmit.queue =
-            g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)packet_unref);
+    tcp->retransmit.queue = retransmitqueue_new();
     tcp->retransmit.scoreboard = scoreboard_new();
+    tcp->send.selectiveACKs = rangeset_new();
     tcp->retransmit.scheduledTimerExpirations =
             priorityqueue_new((GCompareDataFunc)utility_simulationTimeCompare, NULL, g_free);
 
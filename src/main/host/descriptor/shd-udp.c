@@ -69,6 +69,10 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
     gsize remaining = nBytes;
     gsize offset = 0;
 
+    /* the data is copied once and shared by the packets, unless they are virtual */
+    Payload* payload = (nBytes > 0 && !host_usesVirtualPayloads(worker_getActiveHost())) ?
+            payload_new(buffer, nBytes) : NULL;
+
     /* create as many packets as needed */
     while(remaining > 0) {
         gsize copyLength = MIN(maxPacketLength, remaining);
@@ -93,7 +97,8 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
         utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
         /* create the UDP packet */
-        Packet* packet = packet_new(buffer + offset, copyLength);
+        Packet* packet = payload ? packet_newFromPayload(payload, offset, copyLength) :
+                packet_newVirtual(copyLength);
         packet_setUDP(packet, PUDP_NONE, sourceIP, sourcePort, destinationIP, destinationPort);
         packet_addDeliveryStatus(packet, PDS_SND_CREATED);
 
@@ -110,6 +115,10 @@ gssize udp_sendUserData(UDP* udp, gconstpointer buffer, gsize nBytes, in_addr_t
         }
     }
 
+    if(payload) {
+        payload_unref(payload);
+    }
+
     /* update the tracker output buffer stats */
     Tracker* tracker = host_getTracker(worker_getActiveHost());
     Socket* socket = (Socket* )udp;
@@ -17,6 +17,11 @@ struct _Host {
     Address* defaultAddress;
     CPU* cpu;
 
+    /* assigned when connecting to the network, and used to create the interfaces at boot */
+    Address* loopbackAddress;
+    guint64 bwDownKiBps;
+    guint64 bwUpKiBps;
+
     /* the virtual processes this host is running */
     GQueue* processes;
 
@@ -197,6 +202,7 @@ void host_shutdown(Host* host) {
             host->params.hostname, totalExecutionTime);
 
     if(host->defaultAddress) address_unref(host->defaultAddress);
+    if(host->loopbackAddress) address_unref(host->loopbackAddress);
     if(host->params.hostname) g_free(host->params.hostname);
     g_timer_destroy(host->executionTimer);
 }
@@ -248,47 +254,58 @@ GQuark host_getID(Host* host) {
     return host->params.id;
 }
 
-void host_boot(Host* host) {
+guint host_getIndex(Host* host) {
     MAGIC_ASSERT(host);
+    return host->params.index;
+}
 
-    /* get unique virtual address identifiers for each network interface */
-    Address* loopbackAddress = dns_register(worker_getDNS(), host->params.id, host->params.hostname, "127.0.0.1");
-    Address* ethernetAddress = dns_register(worker_getDNS(), host->params.id, host->params.hostname, host->params.ipHint);
-    host->defaultAddress = ethernetAddress;
-    address_ref(host->defaultAddress);
+/* this is called by the slave in the order that hosts are configured, before hosts are
+ * assigned to workers, so that address assignment does not depend on thread scheduling
+ * and so that the scheduler knows where each host is attached to the topology */
+void host_setup(Host* host, DNS* dns, Topology* topology) {
+    MAGIC_ASSERT(host);
 
-    if(!host->dataDirPath) {
-        host->dataDirPath = g_build_filename(worker_getHostsRootPath(), host->params.hostname, NULL);
-        g_mkdir_with_parents(host->dataDirPath, 0775);
-    }
+    /* get unique virtual address identifiers for each network interface */
+    host->loopbackAddress = dns_register(dns, host->params.id, host->params.index,
+            host->params.hostname, "127.0.0.1");
+    host->defaultAddress = dns_register(dns, host->params.id, host->params.index,
+            host->params.hostname, host->params.ipHint);
 
     host->random = random_new(host->params.nodeSeed);
-    host->cpu = cpu_new(host->params.cpuFrequency, host->params.cpuThreshold, host->params.cpuPrecision);
 
     /* connect to topology and get the default bandwidth */
     guint64 bwDownKiBps = 0, bwUpKiBps = 0;
-    topology_attach(worker_getTopology(), ethernetAddress, host->random,
+    topology_attach(topology, host->defaultAddress, host->random,
             host->params.ipHint, host->params.geocodeHint, host->params.typeHint, &bwDownKiBps, &bwUpKiBps);
 
     /* prefer assigned bandwidth if available */
-    if(host->params.requestedBWDownKiBps) {
-        bwDownKiBps = host->params.requestedBWDownKiBps;
-    }
-    if(host->params.requestedBWUpKiBps) {
-        bwUpKiBps = host->params.requestedBWUpKiBps;
+    host->bwDownKiBps = host->params.requestedBWDownKiBps ? host->params.requestedBWDownKiBps : bwDownKiBps;
+    host->bwUpKiBps = host->params.requestedBWUpKiBps ? host->params.requestedBWUpKiBps : bwUpKiBps;
+}
+
+void host_boot(Host* host) {
+    MAGIC_ASSERT(host);
+    utility_assert(host->defaultAddress && host->loopbackAddress);
+
+    if(!host->dataDirPath) {
+        host->dataDirPath = g_build_filename(worker_getHostsRootPath(), host->params.hostname, NULL);
+        g_mkdir_with_parents(host->dataDirPath, 0775);
     }
 
+    host->cpu = cpu_new(host->params.cpuFrequency, host->params.cpuThreshold, host->params.cpuPrecision);
+
     /* virtual addresses and interfaces for managing network I/O */
-    NetworkInterface* loopback = networkinterface_new(loopbackAddress, G_MAXUINT32, G_MAXUINT32,
+    NetworkInterface* loopback = networkinterface_new(host->loopbackAddress, G_MAXUINT32, G_MAXUINT32,
             host->params.logPcap, host->params.pcapDir, host->params.qdisc, host->params.interfaceBufSize);
-    NetworkInterface* ethernet = networkinterface_new(ethernetAddress, bwDownKiBps, bwUpKiBps,
+    NetworkInterface* ethernet = networkinterface_new(host->defaultAddress, host->bwDownKiBps, host->bwUpKiBps,
             host->params.logPcap, host->params.pcapDir, host->params.qdisc, host->params.interfaceBufSize);
 
-    g_hash_table_replace(host->interfaces, GUINT_TO_POINTER((guint)address_toNetworkIP(ethernetAddress)), ethernet);
+    g_hash_table_replace(host->interfaces, GUINT_TO_POINTER((guint)address_toNetworkIP(host->defaultAddress)), ethernet);
     g_hash_table_replace(host->interfaces, GUINT_TO_POINTER((guint)htonl(INADDR_LOOPBACK)), loopback);
 
-    address_unref(loopbackAddress);
-    address_unref(ethernetAddress);
+    /* the interface holds its own reference now */
+    address_unref(host->loopbackAddress);
+    host->loopbackAddress = NULL;
 
     /* must be done after the default IP exists so tracker_heartbeat works */
     host->tracker = tracker_new(host->params.heartbeatInterval, host->params.heartbeatLogLevel, host->params.heartbeatLogInfo);
@@ -303,7 +320,7 @@ void host_boot(Host* host) {
                 "%"G_GUINT64_FORMAT" cpuPrecision",
                 (guint)host->params.id, host->params.hostname, host->params.nodeSeed,
                 address_toHostIPString(host->defaultAddress),
-                bwUpKiBps, bwDownKiBps, host->params.sendBufSize, host->params.recvBufSize,
+                host->bwUpKiBps, host->bwDownKiBps, host->params.sendBufSize, host->params.recvBufSize,
                 host->params.cpuFrequency, host->params.cpuThreshold, host->params.cpuPrecision);
 }
 
@@ -368,6 +385,16 @@ Random* host_getRandom(Host* host) {
     return host->random;
 }
 
+guint64 host_getBandwidthDownKiBps(Host* host) {
+    MAGIC_ASSERT(host);
+    return host->bwDownKiBps;
+}
+
+guint64 host_getBandwidthUpKiBps(Host* host) {
+    MAGIC_ASSERT(host);
+    return host->bwUpKiBps;
+}
+
 gboolean host_autotuneReceiveBuffer(Host* host) {
     MAGIC_ASSERT(host);
     return host->params.autotuneRecvBuf;
@@ -1548,6 +1575,11 @@ gdouble host_getNextPacketPriority(Host* host) {
     return ++(host->packetPriorityCounter);
 }
 
+gboolean host_usesVirtualPayloads(Host* host) {
+    MAGIC_ASSERT(host);
+    return host->params.virtualPayloads;
+}
+
 const gchar* host_getDataPath(Host* host) {
     MAGIC_ASSERT(host);
     return host->dataDirPath;
@@ -16,6 +16,7 @@ typedef struct _Host Host;
 typedef struct _HostParameters HostParameters;
 struct _HostParameters {
     GQuark id;
+    guint index;
     guint nodeSeed;
     gchar* hostname;
     gchar* ipHint;
@@ -32,6 +33,8 @@ struct _HostParameters {
     LogLevel logLevel;
     gboolean logPcap;
     gchar* pcapDir;
+    /* if the packets we send carry only their length instead of the application data */
+    gboolean virtualPayloads;
     QDiscMode qdisc;
     guint64 recvBufSize;
     gboolean autotuneRecvBuf;
@@ -51,6 +54,7 @@ void host_continueExecutionTimer(Host* host);
 void host_stopExecutionTimer(Host* host);
 gdouble host_getElapsedExecutionTime(Host* host);
 
+void host_setup(Host* host, DNS* dns, Topology* topology);
 void host_boot(Host* host);
 void host_shutdown(Host* host);
 
@@ -61,13 +65,17 @@ void host_freeAllApplications(Host* host);
 
 gint host_compare(gconstpointer a, gconstpointer b, gpointer user_data);
 GQuark host_getID(Host* host);
+guint host_getIndex(Host* host);
 gboolean host_isEqual(Host* a, Host* b);
 CPU* host_getCPU(Host* host);
 gchar* host_getName(Host* host);
 Address* host_getDefaultAddress(Host* host);
 in_addr_t host_getDefaultIP(Host* host);
 Random* host_getRandom(Host* host);
+guint64 host_getBandwidthDownKiBps(Host* host);
+guint64 host_getBandwidthUpKiBps(Host* host);
 gdouble host_getNextPacketPriority(Host* host);
+gboolean host_usesVirtualPayloads(Host* host);
 
 gboolean host_autotuneReceiveBuffer(Host* host);
 gboolean host_autotuneSendBuffer(Host* host);
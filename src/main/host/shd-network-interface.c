@@ -189,9 +189,15 @@ static void _networkinterface_capturePacket(NetworkInterface* interface, Packet*
     pcapPacket->headerSize = packet_getHeaderSize(packet);
     pcapPacket->payloadLength = packet_getPayloadLength(packet);
 
+    /* the payload bytes are immutable, so we write them in place unless they are virtual */
+    gboolean isPayloadCopied = FALSE;
     if(pcapPacket->payloadLength > 0) {
-        pcapPacket->payload = g_new0(guchar, pcapPacket->payloadLength);
-        packet_copyPayload(packet, 0, pcapPacket->payload, pcapPacket->payloadLength);
+        pcapPacket->payload = (gpointer) packet_getPayloadData(packet);
+        if(!pcapPacket->payload) {
+            pcapPacket->payload = g_new0(guchar, pcapPacket->payloadLength);
+            packet_copyPayload(packet, 0, pcapPacket->payload, pcapPacket->payloadLength);
+            isPayloadCopied = TRUE;
+        }
     }
 
     PacketTCPHeader tcpHeader;
@@ -215,7 +221,7 @@ static void _networkinterface_capturePacket(NetworkInterface* interface, Packet*
 
     pcapwriter_writePacket(interface->pcap, pcapPacket);
 
-    if(pcapPacket->payloadLength > 0) {
+    if(isPayloadCopied) {
         g_free(pcapPacket->payload);
     }
 
@@ -6,7 +6,12 @@
 
 #include "shadow.h"
 
-/* thread-safe structure representing a data/network packet */
+/* a data/network packet. the sender hands a packet to the receiver through the scheduler,
+ * but may keep its own reference, e.g., in the TCP retransmit queue, so both workers may
+ * use it at the same time. after the handoff the header and payload are only read, and
+ * TCP retransmits a copy rather than changing a packet that may still be in flight. the
+ * reference count and the delivery status are changed by both sides and are atomic, and
+ * the status history is protected by a lock when it is traced. */
 
 typedef struct _PacketLocalHeader PacketLocalHeader;
 struct _PacketLocalHeader {
@@ -26,13 +31,18 @@ struct _PacketUDPHeader {
 };
 
 struct _Packet {
-    GMutex lock;
-    guint referenceCount;
+    volatile gint referenceCount;
 
     enum ProtocolType protocol;
     gpointer header;
-    gpointer payload;
+    /* the part of a shared payload that this packet carries, NULL if it has no payload
+     * or a virtual one */
+    Payload* payload;
+    guint payloadOffset;
     guint payloadLength;
+    /* a virtual payload is not stored, its bytes are generated from the seed when read */
+    gboolean isVirtualPayload;
+    guint32 payloadSeed;
 
     /* tracks application priority so we flush packets from the interface to
      * the wire in the order intended by the application. this is used in
@@ -41,32 +51,103 @@ struct _Packet {
      */
     gdouble priority;
 
-    PacketDeliveryStatusFlags allStatus;
+    /* the PacketDeliveryStatusFlags added so far, changed atomically */
+    volatile guint allStatus;
+    /* the statuses in the order they were added, only if tracing them.
+     * protected by the packetStatusLock */
     GQueue* orderedStatus;
 
     SimulationTime dropNotificationDelay;
 
+    /* the hosts that own the source and destination IPs, resolved once when the packet is
+     * first sent so that resending it needs no address lookups */
+    guint sourceHostIndex;
+    guint destinationHostIndex;
+
     MAGIC_DECLARE;
 };
 
-Packet* packet_new(gconstpointer payload, gsize payloadLength) {
-    Packet* packet = g_new0(Packet, 1);
+/* packets and their headers are created and destroyed at a very high rate, so we
+ * recycle their memory. payloads are recycled by the payload module. */
+typedef enum _PacketPoolType PacketPoolType;
+enum _PacketPoolType {
+    PACKET_POOL_PACKET, PACKET_POOL_HEADER, PACKET_POOL_COUNT,
+};
+
+/* whether packets keep the ordered history of their delivery statuses for debug logging */
+static gboolean packetTracesDeliveryStatus = FALSE;
+/* the history is only kept when debugging, so one lock for all packets is enough */
+static GMutex packetStatusLock;
+
+static ObjectPool* _packet_getPool(PacketPoolType type) {
+    static gsize pools = 0;
+    if(g_once_init_enter(&pools)) {
+        ObjectPool** newPools = g_new0(ObjectPool*, PACKET_POOL_COUNT);
+        newPools[PACKET_POOL_PACKET] = objectpool_new(sizeof(Packet));
+        newPools[PACKET_POOL_HEADER] = objectpool_new(MAX(sizeof(PacketTCPHeader),
+                MAX(sizeof(PacketUDPHeader), sizeof(PacketLocalHeader))));
+        g_once_init_leave(&pools, (gsize)newPools);
+    }
+    return ((ObjectPool**)pools)[type];
+}
+
+static Packet* _packet_new() {
+    Packet* packet = objectpool_alloc0(_packet_getPool(PACKET_POOL_PACKET));
     MAGIC_INIT(packet);
 
-    g_mutex_init(&(packet->lock));
     packet->referenceCount = 1;
+    packet->sourceHostIndex = HOST_INDEX_INVALID;
+    packet->destinationHostIndex = HOST_INDEX_INVALID;
+
+    return packet;
+}
+
+/* the packet refers to payloadLength bytes of the payload starting at payloadOffset,
+ * and holds a reference to the payload until it is freed */
+Packet* packet_newFromPayload(Payload* payload, gsize payloadOffset, gsize payloadLength) {
+    Packet* packet = _packet_new();
 
     if(payload != NULL && payloadLength > 0) {
-        packet->payload = g_malloc0(payloadLength);
-        g_memmove(packet->payload, payload, payloadLength);
-        packet->payloadLength = payloadLength;
-        utility_assert(packet->payload);
+        utility_assert(payloadOffset + payloadLength <= payload_getLength(payload));
+        payload_ref(payload);
+        packet->payload = payload;
+        packet->payloadOffset = (guint) payloadOffset;
+        packet->payloadLength = (guint) payloadLength;
 
         /* application data needs a priority ordering for FIFO onto the wire */
         packet->priority = host_getNextPacketPriority(worker_getActiveHost());
     }
 
-    packet->orderedStatus = g_queue_new();
+    return packet;
+}
+
+Packet* packet_new(gconstpointer payload, gsize payloadLength) {
+    if(payload == NULL || payloadLength == 0) {
+        return _packet_new();
+    }
+
+    Payload* sharedPayload = payload_new(payload, payloadLength);
+    Packet* packet = packet_newFromPayload(sharedPayload, 0, payloadLength);
+    payload_unref(sharedPayload);
+    return packet;
+}
+
+/* packets that only carry a length are used for bulk transfers where the application does
+ * not care about the content. the payload memory is never allocated or copied. */
+Packet* packet_newVirtual(gsize payloadLength) {
+    Packet* packet = _packet_new();
+
+    if(payloadLength > 0) {
+        Host* host = worker_getActiveHost();
+        packet->isVirtualPayload = TRUE;
+        packet->payloadLength = payloadLength;
+
+        /* application data needs a priority ordering for FIFO onto the wire */
+        packet->priority = host_getNextPacketPriority(host);
+
+        /* the priority is unique per packet of the host, and does not use up random numbers */
+        packet->payloadSeed = (((guint32)host_getIndex(host)) * 2654435761u) ^ (guint32)packet->priority;
+    }
 
     return packet;
 }
@@ -74,83 +155,92 @@ Packet* packet_new(gconstpointer payload, gsize payloadLength) {
 static void _packet_free(Packet* packet) {
     MAGIC_ASSERT(packet);
 
-    g_mutex_clear(&(packet->lock));
-
     if(packet->protocol == PTCP) {
         PacketTCPHeader* header = (PacketTCPHeader*)packet->header;
         if(header->selectiveACKs) {
-            g_list_free(header->selectiveACKs);
+            rangeset_free(header->selectiveACKs);
         }
     }
 
     if(packet->header) {
-        g_free(packet->header);
+        objectpool_release(_packet_getPool(PACKET_POOL_HEADER), packet->header);
     }
     if(packet->payload) {
-        g_free(packet->payload);
+        payload_unref(packet->payload);
     }
     if(packet->orderedStatus) {
         g_queue_free(packet->orderedStatus);
     }
 
     MAGIC_CLEAR(packet);
-    g_free(packet);
+    objectpool_release(_packet_getPool(PACKET_POOL_PACKET), packet);
 }
 
-static void _packet_lock(Packet* packet) {
+void packet_ref(Packet* packet) {
     MAGIC_ASSERT(packet);
-    g_mutex_lock(&(packet->lock));
+    g_atomic_int_inc(&(packet->referenceCount));
 }
 
-static void _packet_unlock(Packet* packet) {
+void packet_unref(Packet* packet) {
     MAGIC_ASSERT(packet);
-    g_mutex_unlock(&(packet->lock));
+    if(g_atomic_int_dec_and_test(&(packet->referenceCount))) {
+        packet_addDeliveryStatus(packet, PDS_DESTROYED);
+        _packet_free(packet);
+    }
 }
 
-void packet_ref(Packet* packet) {
-    _packet_lock(packet);
-    (packet->referenceCount)++;
-    _packet_unlock(packet);
-}
+/* returns a new packet with the same headers and payload as the given one, which may still
+ * be in use by another worker. the receiver only changes a packet's delivery status, so only
+ * the parts the sender wrote are copied and the new packet starts without a status. */
+Packet* packet_copy(Packet* packet) {
+    MAGIC_ASSERT(packet);
 
-void packet_unref(Packet* packet) {
-    _packet_lock(packet);
+    Packet* copy = _packet_new();
 
-    (packet->referenceCount)--;
-    if(packet->referenceCount == 0) {
-        _packet_unlock(packet);
-        packet_addDeliveryStatus(packet, PDS_DESTROYED);
-        _packet_free(packet);
-    } else {
-        _packet_unlock(packet);
+    copy->protocol = packet->protocol;
+    if(packet->header) {
+        copy->header = objectpool_alloc(_packet_getPool(PACKET_POOL_HEADER));
+        memcpy(copy->header, packet->header, packet->protocol == PTCP ? sizeof(PacketTCPHeader) :
+                packet->protocol == PUDP ? sizeof(PacketUDPHeader) : sizeof(PacketLocalHeader));
+        if(packet->protocol == PTCP) {
+            PacketTCPHeader* header = copy->header;
+            if(header->selectiveACKs) {
+                header->selectiveACKs = rangeset_copy(header->selectiveACKs);
+            }
+        }
     }
-}
 
-gint packet_compareTCPSequence(Packet* packet1, Packet* packet2, gpointer user_data) {
-    /* packet1 for one worker might be packet2 for another, dont lock both
-     * at once or a deadlock will occur */
-    guint sequence1 = 0, sequence2 = 0;
+    if(packet->payload) {
+        payload_ref(packet->payload);
+        copy->payload = packet->payload;
+    }
+    copy->payloadOffset = packet->payloadOffset;
+    copy->payloadLength = packet->payloadLength;
+    copy->isVirtualPayload = packet->isVirtualPayload;
+    copy->payloadSeed = packet->payloadSeed;
+    copy->priority = packet->priority;
 
-    _packet_lock(packet1);
-    utility_assert(packet1->protocol == PTCP);
-    sequence1 = ((PacketTCPHeader*)(packet1->header))->sequence;
-    _packet_unlock(packet1);
+    copy->dropNotificationDelay = packet->dropNotificationDelay;
+    copy->sourceHostIndex = packet->sourceHostIndex;
+    copy->destinationHostIndex = packet->destinationHostIndex;
 
-    _packet_lock(packet2);
-    utility_assert(packet2->protocol == PTCP);
-    sequence2 = ((PacketTCPHeader*)(packet2->header))->sequence;
-    _packet_unlock(packet2);
+    return copy;
+}
 
+gint packet_compareTCPSequence(Packet* packet1, Packet* packet2, gpointer user_data) {
+    utility_assert(packet1->protocol == PTCP && packet2->protocol == PTCP);
+    guint sequence1 = ((PacketTCPHeader*)(packet1->header))->sequence;
+    guint sequence2 = ((PacketTCPHeader*)(packet2->header))->sequence;
     return sequence1 < sequence2 ? -1 : sequence1 > sequence2 ? 1 : 0;
 }
 
 void packet_setLocal(Packet* packet, enum ProtocolLocalFlags flags,
         gint sourceDescriptorHandle, gint destinationDescriptorHandle, in_port_t port) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(port > 0);
 
-    PacketLocalHeader* header = g_new0(PacketLocalHeader, 1);
+    PacketLocalHeader* header = objectpool_alloc0(_packet_getPool(PACKET_POOL_HEADER));
 
     header->flags = flags;
     header->sourceDescriptorHandle = sourceDescriptorHandle;
@@ -159,17 +249,16 @@ void packet_setLocal(Packet* packet, enum ProtocolLocalFlags flags,
 
     packet->header = header;
     packet->protocol = PLOCAL;
-    _packet_unlock(packet);
 }
 
 void packet_setUDP(Packet* packet, enum ProtocolUDPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
-    PacketUDPHeader* header = g_new0(PacketUDPHeader, 1);
+    PacketUDPHeader* header = objectpool_alloc0(_packet_getPool(PACKET_POOL_HEADER));
 
     header->flags = flags;
     header->sourceIP = sourceIP;
@@ -179,17 +268,16 @@ void packet_setUDP(Packet* packet, enum ProtocolUDPFlags flags,
 
     packet->header = header;
     packet->protocol = PUDP;
-    _packet_unlock(packet);
 }
 
 void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort, guint sequence) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(!(packet->header) && packet->protocol == PNONE);
     utility_assert(sourceIP && sourcePort && destinationIP && destinationPort);
 
-    PacketTCPHeader* header = g_new0(PacketTCPHeader, 1);
+    PacketTCPHeader* header = objectpool_alloc0(_packet_getPool(PACKET_POOL_HEADER));
 
     header->flags = flags;
     header->sourceIP = sourceIP;
@@ -200,56 +288,57 @@ void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
 
     packet->header = header;
     packet->protocol = PTCP;
-    _packet_unlock(packet);
 }
 
-void packet_updateTCP(Packet* packet, guint acknowledgement, GList* selectiveACKs,
+void packet_updateTCP(Packet* packet, guint acknowledgement, RangeSet* selectiveACKs,
         guint window, SimulationTime timestampValue, SimulationTime timestampEcho) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     utility_assert(packet->header && (packet->protocol == PTCP));
 
     PacketTCPHeader* header = (PacketTCPHeader*) packet->header;
 
-    if(selectiveACKs && g_list_length(selectiveACKs) > 0) {
-        /* free the old ack list if it exists */
+    if(selectiveACKs && !rangeset_isEmpty(selectiveACKs)) {
+        /* free the old acks if they exist */
         if(header->selectiveACKs != NULL) {
-            g_list_free(header->selectiveACKs);
+            rangeset_free(header->selectiveACKs);
             header->selectiveACKs = NULL;
         }
 
         /* set the new sacks */
         header->flags |= PTCP_SACK;
-        header->selectiveACKs = g_list_copy(selectiveACKs);
+        header->selectiveACKs = rangeset_copy(selectiveACKs);
     }
 
     header->acknowledgment = acknowledgement;
     header->window = window;
     header->timestampValue = timestampValue;
     header->timestampEcho = timestampEcho;
+}
 
-    _packet_unlock(packet);
+gboolean packet_isVirtualPayload(Packet* packet) {
+    MAGIC_ASSERT(packet);
+    return packet->isVirtualPayload;
 }
 
 guint packet_getPayloadLength(Packet* packet) {
-    /* not locked, read only */
+    MAGIC_ASSERT(packet);
     return packet->payloadLength;
 }
 
 gdouble packet_getPriority(Packet* packet) {
-    /* not locked, read only */
+    MAGIC_ASSERT(packet);
     return packet->priority;
 }
 
 guint packet_getHeaderSize(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
     guint size = packet->protocol == PUDP ? CONFIG_HEADER_SIZE_UDPIPETH :
             packet->protocol == PTCP ? CONFIG_HEADER_SIZE_TCPIPETH : 0;
-    _packet_unlock(packet);
     return size;
 }
 
 in_addr_t packet_getDestinationIP(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_addr_t ip = 0;
 
@@ -276,13 +365,11 @@ in_addr_t packet_getDestinationIP(Packet* packet) {
             break;
         }
     }
-
-    _packet_unlock(packet);
     return ip;
 }
 
 in_addr_t packet_getSourceIP(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_addr_t ip = 0;
 
@@ -309,13 +396,11 @@ in_addr_t packet_getSourceIP(Packet* packet) {
             break;
         }
     }
-
-    _packet_unlock(packet);
     return ip;
 }
 
 in_port_t packet_getSourcePort(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
 
@@ -343,13 +428,41 @@ in_port_t packet_getSourcePort(Packet* packet) {
             break;
         }
     }
-
-    _packet_unlock(packet);
     return port;
 }
 
+/* each 8 byte block of a virtual payload only depends on the seed and the block's offset,
+ * so any part of the payload can be generated without generating what comes before it */
+static void _packet_fillVirtualPayload(guint32 seed, gsize payloadOffset, guchar* buffer, gsize length) {
+    gsize position = 0;
+    while(position < length) {
+        gsize offset = payloadOffset + position;
+
+        /* splitmix64 of the seed and block index */
+        guint64 block = (((guint64)seed) << 32) ^ (guint64)(offset / 8);
+        guint64 z = block + G_GUINT64_CONSTANT(0x9E3779B97F4A7C15);
+        z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+        z = z ^ (z >> 31);
+
+        for(guint byte = (guint)(offset % 8); byte < 8 && position < length; byte++) {
+            buffer[position++] = (guchar)(z >> (8 * byte));
+        }
+    }
+}
+
+/* the packet's payload bytes, or NULL if it has none or they are virtual. the bytes never
+ * change and stay valid while the caller holds a reference to the packet. */
+const guchar* packet_getPayloadData(Packet* packet) {
+    MAGIC_ASSERT(packet);
+    if(!packet->payload) {
+        return NULL;
+    }
+    return payload_getData(packet->payload) + packet->payloadOffset;
+}
+
 guint packet_copyPayload(Packet* packet, gsize payloadOffset, gpointer buffer, gsize bufferLength) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     utility_assert(payloadOffset <= packet->payloadLength);
 
@@ -357,15 +470,18 @@ guint packet_copyPayload(Packet* packet, gsize payloadOffset, gpointer buffer, g
     guint copyLength = MIN(targetLength, bufferLength);
 
     if(copyLength > 0) {
-        g_memmove(buffer, packet->payload + payloadOffset, copyLength);
+        if(packet->isVirtualPayload) {
+            _packet_fillVirtualPayload(packet->payloadSeed, payloadOffset, buffer, copyLength);
+        } else {
+            g_memmove(buffer, payload_getData(packet->payload) + packet->payloadOffset + payloadOffset,
+                    copyLength);
+        }
     }
-
-    _packet_unlock(packet);
     return copyLength;
 }
 
 gint packet_getDestinationAssociationKey(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
     switch (packet->protocol) {
@@ -394,13 +510,11 @@ gint packet_getDestinationAssociationKey(Packet* packet) {
     }
 
     gint key = PROTOCOL_DEMUX_KEY(packet->protocol, port);
-
-    _packet_unlock(packet);
     return key;
 }
 
 gint packet_getSourceAssociationKey(Packet* packet) {
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     in_port_t port = 0;
     switch (packet->protocol) {
@@ -429,27 +543,16 @@ gint packet_getSourceAssociationKey(Packet* packet) {
     }
 
     gint key = PROTOCOL_DEMUX_KEY(packet->protocol, port);
-
-    _packet_unlock(packet);
     return key;
 }
 
-GList* packet_copyTCPSelectiveACKs(Packet* packet) {
-    _packet_lock(packet);
+/* the returned acks belong to the packet and are only valid while holding a reference to it */
+RangeSet* packet_getTCPSelectiveACKs(Packet* packet) {
+    MAGIC_ASSERT(packet);
     utility_assert(packet->protocol == PTCP);
 
     PacketTCPHeader* packetHeader = (PacketTCPHeader*)packet->header;
-
-    /* make sure to do a deep copy of all pointers to avoid concurrency issues */
-    GList* selectiveACKsCopy = NULL;
-    if(packetHeader->selectiveACKs) {
-        /* g_list_copy is shallow, but we store integers in the data pointers, so its OK here */
-        selectiveACKsCopy = g_list_copy(packetHeader->selectiveACKs);
-    }
-
-    _packet_unlock(packet);
-
-    return selectiveACKsCopy;
+    return packetHeader->selectiveACKs;
 }
 
 void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header) {
@@ -457,7 +560,7 @@ void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header) {
         return;
     }
 
-    _packet_lock(packet);
+    MAGIC_ASSERT(packet);
 
     utility_assert(packet->protocol == PTCP);
 
@@ -475,10 +578,8 @@ void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header) {
     header->timestampValue = packetHeader->timestampValue;
     header->timestampEcho = packetHeader->timestampEcho;
 
-    /* don't copy the selective acks list here; use packet_copyTCPSelectiveACKs for that */
+    /* don't copy the selective acks here; use packet_getTCPSelectiveACKs for that */
     header->selectiveACKs = NULL;
-
-    _packet_unlock(packet);
 }
 
 static const gchar* _packet_deliveryStatusToAscii(PacketDeliveryStatusFlags status) {
@@ -509,8 +610,6 @@ static const gchar* _packet_deliveryStatusToAscii(PacketDeliveryStatusFlags stat
 static gchar* _packet_getString(Packet* packet) {
     GString* packetString = g_string_new("");
 
-    //_packet_lock(packet);
-
     switch (packet->protocol) {
         case PLOCAL: {
             PacketLocalHeader* header = packet->header;
@@ -547,28 +646,17 @@ static gchar* _packet_getString(Packet* packet) {
                     destinationIPString, ntohs(header->destinationPort),
                     header->sequence, header->acknowledgment);
 
-            // Instead of printing out entire list of SACK, print out ranges to save space
-            gint firstSack = -1;
-            gint lastSack = -1;
-            for(GList *iter = header->selectiveACKs; iter; iter = g_list_next(iter)) {
-                gint seq = GPOINTER_TO_INT(iter->data);
-                if(firstSack == -1) {
-                    firstSack = seq;
-                } else if(lastSack == -1 || seq == lastSack + 1) {
-                    lastSack = seq;
+            guint nSackRanges = header->selectiveACKs ? rangeset_getNumRanges(header->selectiveACKs) : 0;
+            for(guint i = 0; i < nSackRanges; i++) {
+                guint sackStart = 0, sackEnd = 0;
+                rangeset_getRange(header->selectiveACKs, i, &sackStart, &sackEnd);
+                if(sackEnd - sackStart > 1) {
+                    g_string_append_printf(packetString, "%s%u-%u", i > 0 ? "," : "", sackStart, sackEnd - 1);
                 } else {
-                    g_string_append_printf(packetString, "%d-%d ", firstSack, lastSack);
-                    firstSack = seq;
-                    lastSack = -1;
+                    g_string_append_printf(packetString, "%s%u", i > 0 ? "," : "", sackStart);
                 }
             }
-
-            if(firstSack != -1) {
-                g_string_append_printf(packetString, "%d", firstSack);
-                if(lastSack != -1) {
-                    g_string_append_printf(packetString,"-%d", lastSack);
-                }
-            } else {
+            if(nSackRanges == 0) {
                 g_string_append_printf(packetString, "NA");
             }
 
@@ -603,60 +691,80 @@ static gchar* _packet_getString(Packet* packet) {
     
     g_string_append_printf(packetString, " status=");
 
-    guint statusLength = g_queue_get_length(packet->orderedStatus);
-    for(int i = 0; i < statusLength; i++) {
-        gpointer statusPtr = g_queue_pop_head(packet->orderedStatus);
-        PacketDeliveryStatusFlags status = (PacketDeliveryStatusFlags) GPOINTER_TO_UINT(statusPtr);
+    /* the other side of the handoff may be adding a status right now */
+    g_mutex_lock(&packetStatusLock);
+    GList* statusLink = packet->orderedStatus ? g_queue_peek_head_link(packet->orderedStatus) : NULL;
+    while(statusLink) {
+        PacketDeliveryStatusFlags status = (PacketDeliveryStatusFlags) GPOINTER_TO_UINT(statusLink->data);
+        statusLink = g_list_next(statusLink);
 
-        if(i < statusLength - 1) {
+        if(statusLink) {
             g_string_append_printf(packetString, "%s,", _packet_deliveryStatusToAscii(status));
         } else {
             g_string_append_printf(packetString, "%s", _packet_deliveryStatusToAscii(status));
         }
-
-        g_queue_push_tail(packet->orderedStatus, statusPtr);
     }
+    g_mutex_unlock(&packetStatusLock);
 
-    //_packet_unlock(packet);
     return g_string_free(packetString, FALSE);
 }
 
-void packet_addDeliveryStatus(Packet* packet, PacketDeliveryStatusFlags status) {
-    gboolean skipDebug = worker_isFiltered(LOGLEVEL_DEBUG);
-    gchar* packetStr = NULL;
+void packet_setDeliveryStatusTracing(gboolean isEnabled) {
+    /* set once at startup, before any worker creates packets */
+    packetTracesDeliveryStatus = isEnabled;
+}
 
-    _packet_lock(packet);
-    packet->allStatus |= status;
+void packet_addDeliveryStatus(Packet* packet, PacketDeliveryStatusFlags status) {
+    MAGIC_ASSERT(packet);
+    g_atomic_int_or(&(packet->allStatus), (guint) status);
 
-    if(!skipDebug) {
-        g_queue_push_tail(packet->orderedStatus, GUINT_TO_POINTER(status));
-        packetStr = _packet_getString(packet);
+    /* only keep and log the status history when debug messages can be shown */
+    if(!packetTracesDeliveryStatus || worker_isFiltered(LOGLEVEL_DEBUG)) {
+        return;
     }
 
-    _packet_unlock(packet);
-
-    if(!skipDebug) {
-        message("[%s] %s", _packet_deliveryStatusToAscii(status), packetStr);
+    g_mutex_lock(&packetStatusLock);
+    if(!packet->orderedStatus) {
+        packet->orderedStatus = g_queue_new();
     }
+    g_queue_push_tail(packet->orderedStatus, GUINT_TO_POINTER(status));
+    g_mutex_unlock(&packetStatusLock);
+
+    gchar* packetStr = _packet_getString(packet);
+    message("[%s] %s", _packet_deliveryStatusToAscii(status), packetStr);
+    g_free(packetStr);
 }
 
 PacketDeliveryStatusFlags packet_getDeliveryStatus(Packet* packet) {
-    _packet_lock(packet);
-    PacketDeliveryStatusFlags flags = packet->allStatus;
-    _packet_unlock(packet);
+    MAGIC_ASSERT(packet);
+    PacketDeliveryStatusFlags flags = (PacketDeliveryStatusFlags) g_atomic_int_get((volatile gint*) &(packet->allStatus));
     return flags;
 }
 
 void packet_setDropNotificationDelay(Packet* packet, SimulationTime delay) {
     MAGIC_ASSERT(packet);
-    _packet_lock(packet);
     packet->dropNotificationDelay = delay;
-    _packet_unlock(packet);
 }
 SimulationTime packet_getDropNotificationDelay(Packet* packet) {
     MAGIC_ASSERT(packet);
-    _packet_lock(packet);
     SimulationTime delay = packet->dropNotificationDelay;
-    _packet_unlock(packet);
     return delay;
 }
+
+void packet_setHostIndices(Packet* packet, guint sourceHostIndex, guint destinationHostIndex) {
+    MAGIC_ASSERT(packet);
+    packet->sourceHostIndex = sourceHostIndex;
+    packet->destinationHostIndex = destinationHostIndex;
+}
+
+guint packet_getSourceHostIndex(Packet* packet) {
+    MAGIC_ASSERT(packet);
+    guint hostIndex = packet->sourceHostIndex;
+    return hostIndex;
+}
+
+guint packet_getDestinationHostIndex(Packet* packet) {
+    MAGIC_ASSERT(packet);
+    guint hostIndex = packet->destinationHostIndex;
+    return hostIndex;
+}
@@ -43,16 +43,20 @@ struct _PacketTCPHeader {
     in_port_t destinationPort;
     guint sequence;
     guint acknowledgment;
-    GList* selectiveACKs;
+    /* the out of order sequences the receiver holds, NULL if none */
+    RangeSet* selectiveACKs;
     guint window;
     SimulationTime timestampValue;
     SimulationTime timestampEcho;
 };
 
 Packet* packet_new(gconstpointer payload, gsize payloadLength);
+Packet* packet_newFromPayload(Payload* payload, gsize payloadOffset, gsize payloadLength);
+Packet* packet_newVirtual(gsize payloadLength);
 
 void packet_ref(Packet* packet);
 void packet_unref(Packet* packet);
+Packet* packet_copy(Packet* packet);
 
 void packet_setLocal(Packet* packet, enum ProtocolLocalFlags flags,
         gint sourceDescriptorHandle, gint destinationDescriptorHandle, in_port_t port);
@@ -63,28 +67,35 @@ void packet_setTCP(Packet* packet, enum ProtocolTCPFlags flags,
         in_addr_t sourceIP, in_port_t sourcePort,
         in_addr_t destinationIP, in_port_t destinationPort, guint sequence);
 
-void packet_updateTCP(Packet* packet, guint acknowledgement, GList* selectiveACKs,
+void packet_updateTCP(Packet* packet, guint acknowledgement, RangeSet* selectiveACKs,
         guint window, SimulationTime timestampValue, SimulationTime timestampEcho);
 
 guint packet_getPayloadLength(Packet* packet);
+gboolean packet_isVirtualPayload(Packet* packet);
 gdouble packet_getPriority(Packet* packet);
 guint packet_getHeaderSize(Packet* packet);
 in_addr_t packet_getDestinationIP(Packet* packet);
 in_addr_t packet_getSourceIP(Packet* packet);
 in_port_t packet_getSourcePort(Packet* packet);
+const guchar* packet_getPayloadData(Packet* packet);
 guint packet_copyPayload(Packet* packet, gsize payloadOffset, gpointer buffer, gsize bufferLength);
-GList* packet_copyTCPSelectiveACKs(Packet* packet);
+RangeSet* packet_getTCPSelectiveACKs(Packet* packet);
 void packet_getTCPHeader(Packet* packet, PacketTCPHeader* header);
 gint packet_compareTCPSequence(Packet* packet1, Packet* packet2, gpointer user_data);
 
 gint packet_getDestinationAssociationKey(Packet* packet);
 gint packet_getSourceAssociationKey(Packet* packet);
 
+void packet_setDeliveryStatusTracing(gboolean isEnabled);
 void packet_addDeliveryStatus(Packet* packet, PacketDeliveryStatusFlags status);
 PacketDeliveryStatusFlags packet_getDeliveryStatus(Packet* packet);
 
 void packet_setDropNotificationDelay(Packet* packet, SimulationTime delay);
 SimulationTime packet_getDropNotificationDelay(Packet* packet);
 
+void packet_setHostIndices(Packet* packet, guint sourceHostIndex, guint destinationHostIndex);
+guint packet_getSourceHostIndex(Packet* packet);
+guint packet_getDestinationHostIndex(Packet* packet);
+
 
 #endif /* SHD_PACKET_H_ */
@@ -0,0 +1,66 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+struct _Payload {
+    volatile gint referenceCount;
+    gsize length;
+    MAGIC_DECLARE;
+    /* the bytes follow the struct in the same allocation */
+    guchar data[];
+};
+
+/* most payloads fit in a single packet, and are created and destroyed at a very high
+ * rate, so we recycle their memory. larger payloads are allocated on the heap. */
+static ObjectPool* _payload_getPool() {
+    static gsize pool = 0;
+    if(g_once_init_enter(&pool)) {
+        g_once_init_leave(&pool, (gsize)objectpool_new(sizeof(Payload) + CONFIG_MTU));
+    }
+    return (ObjectPool*)pool;
+}
+
+Payload* payload_new(gconstpointer data, gsize length) {
+    utility_assert(data && length > 0);
+
+    Payload* payload = (length <= CONFIG_MTU) ? objectpool_alloc(_payload_getPool()) :
+            g_malloc(sizeof(Payload) + length);
+    MAGIC_INIT(payload);
+
+    payload->referenceCount = 1;
+    payload->length = length;
+    memcpy(payload->data, data, length);
+
+    return payload;
+}
+
+void payload_ref(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    g_atomic_int_inc(&(payload->referenceCount));
+}
+
+void payload_unref(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    if(g_atomic_int_dec_and_test(&(payload->referenceCount))) {
+        gsize length = payload->length;
+        MAGIC_CLEAR(payload);
+        if(length <= CONFIG_MTU) {
+            objectpool_release(_payload_getPool(), payload);
+        } else {
+            g_free(payload);
+        }
+    }
+}
+
+const guchar* payload_getData(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    return payload->data;
+}
+
+gsize payload_getLength(Payload* payload) {
+    MAGIC_ASSERT(payload);
+    return payload->length;
+}
@@ -0,0 +1,24 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PAYLOAD_H_
+#define SHD_PAYLOAD_H_
+
+#include "shadow.h"
+
+/* An immutable, reference counted block of application data. Packets refer to a part of
+ * a payload instead of owning a copy, so the data of one send call is copied once no
+ * matter how many packets carry it, and retransmitting or capturing a packet reuses the
+ * same bytes. References may be dropped from any thread. */
+typedef struct _Payload Payload;
+
+Payload* payload_new(gconstpointer data, gsize length);
+void payload_ref(Payload* payload);
+void payload_unref(Payload* payload);
+
+const guchar* payload_getData(Payload* payload);
+gsize payload_getLength(Payload* payload);
+
+#endif /* SHD_PAYLOAD_H_ */
@@ -32,14 +32,17 @@ struct _Address {
     gboolean isLocal;
 
     GQuark hostID;
+    /* the dense index of the host, see host_getIndex */
+    guint hostIndex;
     MAGIC_DECLARE;
 };
 
-Address* address_new(GQuark hostID, guint mac, guint32 ip, const gchar* name, gboolean isLocal) {
+Address* address_new(GQuark hostID, guint hostIndex, guint mac, guint32 ip, const gchar* name, gboolean isLocal) {
     Address* address = g_new0(Address, 1);
     MAGIC_INIT(address);
 
     address->hostID = hostID;
+    address->hostIndex = hostIndex;
     address->mac = mac;
     address->ip = ip;
     address->ipString = address_ipToNewString((in_addr_t)ip);
@@ -71,6 +74,11 @@ ShadowID address_getID(Address* address) {
     return (ShadowID) address->hostID;
 }
 
+guint address_getHostIndex(Address* address) {
+    MAGIC_ASSERT(address);
+    return address->hostIndex;
+}
+
 void address_ref(Address* address) {
     MAGIC_ASSERT(address);
     address->referenceCount++;
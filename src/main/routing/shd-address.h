@@ -29,9 +29,10 @@ typedef struct _Address Address;
  *
  * @see address_free()
  */
-Address* address_new(GQuark hostID, guint mac, guint32 ip, const gchar* name, gboolean isLocal);
+Address* address_new(GQuark hostID, guint hostIndex, guint mac, guint32 ip, const gchar* name, gboolean isLocal);
 
 ShadowID address_getID(Address* address);
+guint address_getHostIndex(Address* address);
 void address_ref(Address* address);
 void address_unref(Address* address);
 gboolean address_isLocal(Address* address);
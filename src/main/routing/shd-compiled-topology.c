@@ -0,0 +1,524 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define COMPILED_TOPOLOGY_MAGIC "SHDTOPO"
+#define COMPILED_TOPOLOGY_VERSION 2
+#define COMPILED_TOPOLOGY_BYTE_ORDER 0x01020304
+
+#define COMPILED_TOPOLOGY_FLAG_DIRECTED (1<<0)
+#define COMPILED_TOPOLOGY_FLAG_COMPLETE (1<<1)
+
+/* every section starts on an 8 byte boundary so the arrays can be used in place */
+#define COMPILED_TOPOLOGY_ALIGN(x) (((x) + 7) & ~((guint64)7))
+
+typedef struct _CompiledTopologyHeader CompiledTopologyHeader;
+struct _CompiledTopologyHeader {
+    gchar magic[8];
+    guint32 version;
+    guint32 byteOrder;
+    guint32 flags;
+    guint32 reserved;
+    guint64 nVertices;
+    guint64 nEdges;
+    guint64 nIndexedVertices;
+    guint64 stringTableLength;
+    guint64 fileLength;
+};
+
+typedef struct _CompiledTopologyIPEntry CompiledTopologyIPEntry;
+struct _CompiledTopologyIPEntry {
+    /* in host order, so that sorting keeps equal prefixes next to each other */
+    guint32 ip;
+    guint32 vertexIndex;
+};
+
+/* the byte offset of each section, which only depend on the counts in the header */
+typedef struct _CompiledTopologyLayout CompiledTopologyLayout;
+struct _CompiledTopologyLayout {
+    /* nVertices+1 guint64, the edges leaving vertex v are offsets[v] to offsets[v+1]-1 */
+    guint64 edgeOffsets;
+    /* nEdges guint32 */
+    guint64 edgeTargets;
+    /* nEdges gdouble each */
+    guint64 edgeLatencies;
+    guint64 edgeJitters;
+    guint64 edgePacketLosses;
+    /* 0 where the edge has no bandwidth */
+    guint64 edgeBandwidths;
+    /* nVertices gdouble each */
+    guint64 vertexBandwidthUps;
+    guint64 vertexBandwidthDowns;
+    guint64 vertexPacketLosses;
+    /* nVertices guint32 each, offsets into the string table */
+    guint64 vertexIDs;
+    guint64 vertexTypes;
+    guint64 vertexIPs;
+    guint64 vertexGeocodes;
+    /* nIndexedVertices CompiledTopologyIPEntry */
+    guint64 ipIndex;
+    /* stringTableLength bytes of nul-terminated strings */
+    guint64 stringTable;
+    guint64 end;
+};
+
+static void _compiledtopology_getLayout(const CompiledTopologyHeader* header,
+        CompiledTopologyLayout* layout) {
+    guint64 nV = header->nVertices, nE = header->nEdges;
+    guint64 position = COMPILED_TOPOLOGY_ALIGN(sizeof(CompiledTopologyHeader));
+
+    layout->edgeOffsets = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + ((nV + 1) * sizeof(guint64)));
+    layout->edgeTargets = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + (nE * sizeof(guint32)));
+
+    layout->edgeLatencies = position;
+    position += nE * sizeof(gdouble);
+    layout->edgeJitters = position;
+    position += nE * sizeof(gdouble);
+    layout->edgePacketLosses = position;
+    position += nE * sizeof(gdouble);
+    layout->edgeBandwidths = position;
+    position += nE * sizeof(gdouble);
+
+    layout->vertexBandwidthUps = position;
+    position += nV * sizeof(gdouble);
+    layout->vertexBandwidthDowns = position;
+    position += nV * sizeof(gdouble);
+    layout->vertexPacketLosses = position;
+    position += nV * sizeof(gdouble);
+
+    layout->vertexIDs = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + (nV * sizeof(guint32)));
+    layout->vertexTypes = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + (nV * sizeof(guint32)));
+    layout->vertexIPs = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + (nV * sizeof(guint32)));
+    layout->vertexGeocodes = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + (nV * sizeof(guint32)));
+
+    layout->ipIndex = position;
+    position += header->nIndexedVertices * sizeof(CompiledTopologyIPEntry);
+
+    layout->stringTable = position;
+    position = COMPILED_TOPOLOGY_ALIGN(position + header->stringTableLength);
+
+    layout->end = position;
+}
+
+gboolean compiledtopology_isCompiled(const gchar* path) {
+    utility_assert(path);
+
+    FILE* file = fopen(path, "r");
+    if(!file) {
+        return FALSE;
+    }
+
+    gchar magic[sizeof(COMPILED_TOPOLOGY_MAGIC)];
+    gboolean isCompiled = fread(magic, sizeof(magic), 1, file) == 1 &&
+            memcmp(magic, COMPILED_TOPOLOGY_MAGIC, sizeof(magic)) == 0;
+
+    fclose(file);
+    return isCompiled;
+}
+
+/* writing */
+
+typedef struct _CompiledTopologyStrings CompiledTopologyStrings;
+struct _CompiledTopologyStrings {
+    GString* table;
+    /* string -> offset + 1 (stored as pointer), so that repeated types and geocodes are
+     * only stored once */
+    GHashTable* offsets;
+};
+
+static guint32 _compiledtopology_addString(CompiledTopologyStrings* strings, const gchar* str) {
+    if(!str || !str[0]) {
+        /* the table starts with an empty string */
+        return 0;
+    }
+
+    gpointer offsetPtr = g_hash_table_lookup(strings->offsets, str);
+    if(offsetPtr) {
+        return (guint32) (GPOINTER_TO_UINT(offsetPtr) - 1);
+    }
+
+    guint32 offset = (guint32) strings->table->len;
+    g_string_append_len(strings->table, str, (gssize) strlen(str) + 1);
+    g_hash_table_replace(strings->offsets, g_strdup(str), GUINT_TO_POINTER(offset + 1));
+    return offset;
+}
+
+static gint _compiledtopology_compareIPEntries(gconstpointer a, gconstpointer b) {
+    const CompiledTopologyIPEntry* ea = a;
+    const CompiledTopologyIPEntry* eb = b;
+    if(ea->ip != eb->ip) {
+        return ea->ip < eb->ip ? -1 : 1;
+    }
+    return ea->vertexIndex < eb->vertexIndex ? -1 : (ea->vertexIndex > eb->vertexIndex ? 1 : 0);
+}
+
+gboolean compiledtopology_write(const gchar* path, igraph_t* graph,
+        const CompiledTopologyProperties* properties) {
+    utility_assert(path && graph && properties && properties->vertexIPs);
+
+    CompiledTopologyHeader header;
+    memset(&header, 0, sizeof(CompiledTopologyHeader));
+    memcpy(header.magic, COMPILED_TOPOLOGY_MAGIC, sizeof(header.magic));
+    header.version = COMPILED_TOPOLOGY_VERSION;
+    header.byteOrder = COMPILED_TOPOLOGY_BYTE_ORDER;
+    header.flags = (properties->isDirected ? COMPILED_TOPOLOGY_FLAG_DIRECTED : 0) |
+            (properties->isComplete ? COMPILED_TOPOLOGY_FLAG_COMPLETE : 0);
+    header.nVertices = (guint64) igraph_vcount(graph);
+    header.nEdges = (guint64) igraph_ecount(graph);
+
+    guint64 nV = header.nVertices, nE = header.nEdges;
+
+    /* order the edges by their source vertex, keeping the graphml order among the edges of
+     * each vertex. the loader recreates the edges in this order. */
+    guint64* edgeOffsets = g_new0(guint64, nV + 1);
+    igraph_integer_t* froms = g_new(igraph_integer_t, nE);
+    igraph_integer_t* tos = g_new(igraph_integer_t, nE);
+    for(guint64 e = 0; e < nE; e++) {
+        igraph_edge(graph, (igraph_integer_t)e, &froms[e], &tos[e]);
+        edgeOffsets[froms[e] + 1]++;
+    }
+    for(guint64 v = 0; v < nV; v++) {
+        edgeOffsets[v + 1] += edgeOffsets[v];
+    }
+
+    guint64* next = g_memdup(edgeOffsets, (guint)(nV * sizeof(guint64)));
+    guint32* edgeTargets = g_new(guint32, nE);
+    gdouble* edgeLatencies = g_new(gdouble, nE);
+    gdouble* edgeJitters = g_new(gdouble, nE);
+    gdouble* edgePacketLosses = g_new(gdouble, nE);
+    gdouble* edgeBandwidths = g_new0(gdouble, nE);
+    gboolean hasEdgeBandwidths = igraph_cattribute_has_attr(graph, IGRAPH_ATTRIBUTE_EDGE, "bandwidth");
+    for(guint64 e = 0; e < nE; e++) {
+        guint64 position = next[froms[e]]++;
+        edgeTargets[position] = (guint32) tos[e];
+        edgeLatencies[position] = EAN(graph, "latency", (igraph_integer_t)e);
+        edgeJitters[position] = EAN(graph, "jitter", (igraph_integer_t)e);
+        edgePacketLosses[position] = EAN(graph, "packetloss", (igraph_integer_t)e);
+        if(hasEdgeBandwidths) {
+            gdouble bandwidth = EAN(graph, "bandwidth", (igraph_integer_t)e);
+            edgeBandwidths[position] = bandwidth > 0 ? bandwidth : 0;
+        }
+    }
+    g_free(next);
+    g_free(froms);
+    g_free(tos);
+
+    CompiledTopologyStrings strings;
+    strings.table = g_string_new_len("", 1);
+    strings.offsets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    gdouble* vertexBandwidthUps = g_new(gdouble, nV);
+    gdouble* vertexBandwidthDowns = g_new(gdouble, nV);
+    gdouble* vertexPacketLosses = g_new(gdouble, nV);
+    guint32* vertexIDs = g_new(guint32, nV);
+    guint32* vertexTypes = g_new(guint32, nV);
+    guint32* vertexIPs = g_new(guint32, nV);
+    guint32* vertexGeocodes = g_new(guint32, nV);
+    GArray* ipIndex = g_array_new(FALSE, FALSE, sizeof(CompiledTopologyIPEntry));
+
+    for(guint64 v = 0; v < nV; v++) {
+        igraph_integer_t vertexIndex = (igraph_integer_t) v;
+        vertexBandwidthUps[v] = VAN(graph, "bandwidthup", vertexIndex);
+        vertexBandwidthDowns[v] = VAN(graph, "bandwidthdown", vertexIndex);
+        vertexPacketLosses[v] = VAN(graph, "packetloss", vertexIndex);
+        vertexIDs[v] = _compiledtopology_addString(&strings, VAS(graph, "id", vertexIndex));
+        vertexTypes[v] = _compiledtopology_addString(&strings, VAS(graph, "type", vertexIndex));
+        vertexIPs[v] = _compiledtopology_addString(&strings, VAS(graph, "ip", vertexIndex));
+        vertexGeocodes[v] = _compiledtopology_addString(&strings, VAS(graph, "geocode", vertexIndex));
+
+        in_addr_t ip = properties->vertexIPs[v];
+        if(ip != INADDR_NONE) {
+            CompiledTopologyIPEntry entry = {ntohl(ip), (guint32) v};
+            g_array_append_val(ipIndex, entry);
+        }
+    }
+    g_array_sort(ipIndex, _compiledtopology_compareIPEntries);
+
+    header.nIndexedVertices = (guint64) ipIndex->len;
+    header.stringTableLength = (guint64) strings.table->len;
+
+    CompiledTopologyLayout layout;
+    _compiledtopology_getLayout(&header, &layout);
+    header.fileLength = layout.end;
+
+    /* lay out the whole file in memory so we can write it with a single call */
+    gchar* buffer = g_malloc0(layout.end);
+    memcpy(buffer, &header, sizeof(CompiledTopologyHeader));
+    memcpy(buffer + layout.edgeOffsets, edgeOffsets, (nV + 1) * sizeof(guint64));
+    memcpy(buffer + layout.edgeTargets, edgeTargets, nE * sizeof(guint32));
+    memcpy(buffer + layout.edgeLatencies, edgeLatencies, nE * sizeof(gdouble));
+    memcpy(buffer + layout.edgeJitters, edgeJitters, nE * sizeof(gdouble));
+    memcpy(buffer + layout.edgePacketLosses, edgePacketLosses, nE * sizeof(gdouble));
+    memcpy(buffer + layout.edgeBandwidths, edgeBandwidths, nE * sizeof(gdouble));
+    memcpy(buffer + layout.vertexBandwidthUps, vertexBandwidthUps, nV * sizeof(gdouble));
+    memcpy(buffer + layout.vertexBandwidthDowns, vertexBandwidthDowns, nV * sizeof(gdouble));
+    memcpy(buffer + layout.vertexPacketLosses, vertexPacketLosses, nV * sizeof(gdouble));
+    memcpy(buffer + layout.vertexIDs, vertexIDs, nV * sizeof(guint32));
+    memcpy(buffer + layout.vertexTypes, vertexTypes, nV * sizeof(guint32));
+    memcpy(buffer + layout.vertexIPs, vertexIPs, nV * sizeof(guint32));
+    memcpy(buffer + layout.vertexGeocodes, vertexGeocodes, nV * sizeof(guint32));
+    memcpy(buffer + layout.ipIndex, ipIndex->data, ipIndex->len * sizeof(CompiledTopologyIPEntry));
+    memcpy(buffer + layout.stringTable, strings.table->str, strings.table->len);
+
+    GError* error = NULL;
+    gboolean isSuccess = g_file_set_contents(path, buffer, (gssize) layout.end, &error);
+    if(isSuccess) {
+        message("wrote compiled topology with %"G_GUINT64_FORMAT" vertices and %"G_GUINT64_FORMAT
+                " edges to '%s' (%"G_GUINT64_FORMAT" bytes)", nV, nE, path, layout.end);
+    } else {
+        critical("unable to write compiled topology to '%s': %s", path, error->message);
+        g_error_free(error);
+    }
+
+    g_free(buffer);
+    g_array_free(ipIndex, TRUE);
+    g_hash_table_destroy(strings.offsets);
+    g_string_free(strings.table, TRUE);
+    g_free(vertexGeocodes);
+    g_free(vertexIPs);
+    g_free(vertexTypes);
+    g_free(vertexIDs);
+    g_free(vertexPacketLosses);
+    g_free(vertexBandwidthDowns);
+    g_free(vertexBandwidthUps);
+    g_free(edgeBandwidths);
+    g_free(edgePacketLosses);
+    g_free(edgeJitters);
+    g_free(edgeLatencies);
+    g_free(edgeTargets);
+    g_free(edgeOffsets);
+
+    return isSuccess;
+}
+
+/* reading */
+
+static gboolean _compiledtopology_checkHeader(const gchar* path, const gchar* data, gsize length) {
+    if(length < sizeof(CompiledTopologyHeader)) {
+        critical("compiled topology '%s' is truncated", path);
+        return FALSE;
+    }
+
+    const CompiledTopologyHeader* header = (const CompiledTopologyHeader*) data;
+
+    if(memcmp(header->magic, COMPILED_TOPOLOGY_MAGIC, sizeof(header->magic)) != 0) {
+        critical("'%s' is not a compiled topology", path);
+        return FALSE;
+    }
+    if(header->byteOrder != COMPILED_TOPOLOGY_BYTE_ORDER) {
+        critical("compiled topology '%s' was compiled on a machine with a different byte order", path);
+        return FALSE;
+    }
+    if(header->version != COMPILED_TOPOLOGY_VERSION) {
+        critical("compiled topology '%s' has version %u but we only support version %u, "
+                "please compile it again", path, header->version, (guint)COMPILED_TOPOLOGY_VERSION);
+        return FALSE;
+    }
+
+    CompiledTopologyLayout layout;
+    _compiledtopology_getLayout(header, &layout);
+    if(header->fileLength != length || layout.end != length) {
+        critical("compiled topology '%s' has length %"G_GSIZE_FORMAT" but expected %"G_GUINT64_FORMAT,
+                path, length, layout.end);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* the arrays are used as they are, but a corrupt file must not crash us inside igraph */
+static gboolean _compiledtopology_checkBounds(const gchar* path, const CompiledTopologyHeader* header,
+        const guint64* edgeOffsets, const guint32* edgeTargets, const guint32** stringOffsets,
+        guint nStringOffsets, const CompiledTopologyIPEntry* ipIndex, const gchar* stringTable) {
+    guint64 nV = header->nVertices, nE = header->nEdges;
+
+    if(edgeOffsets[0] != 0 || edgeOffsets[nV] != nE) {
+        critical("compiled topology '%s' has corrupt edge offsets", path);
+        return FALSE;
+    }
+    for(guint64 v = 0; v < nV; v++) {
+        if(edgeOffsets[v] > edgeOffsets[v + 1]) {
+            critical("compiled topology '%s' has corrupt edge offsets", path);
+            return FALSE;
+        }
+    }
+    for(guint64 e = 0; e < nE; e++) {
+        if(edgeTargets[e] >= nV) {
+            critical("compiled topology '%s' has an edge to unknown vertex %u", path, edgeTargets[e]);
+            return FALSE;
+        }
+    }
+
+    if(header->stringTableLength == 0 || stringTable[header->stringTableLength - 1] != '\0') {
+        critical("compiled topology '%s' has a corrupt string table", path);
+        return FALSE;
+    }
+    for(guint i = 0; i < nStringOffsets; i++) {
+        for(guint64 v = 0; v < nV; v++) {
+            if(stringOffsets[i][v] >= header->stringTableLength) {
+                critical("compiled topology '%s' has a corrupt string table", path);
+                return FALSE;
+            }
+        }
+    }
+
+    for(guint64 i = 0; i < header->nIndexedVertices; i++) {
+        if(ipIndex[i].vertexIndex >= nV) {
+            critical("compiled topology '%s' has a corrupt IP index", path);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void _compiledtopology_setNumericAttribute(igraph_t* graph, gboolean isVertex,
+        const gchar* name, const gdouble* values, guint64 n) {
+    /* igraph copies the values straight out of the mapped file */
+    igraph_vector_t view;
+    igraph_vector_view(&view, (const igraph_real_t*) values, (glong) n);
+    if(isVertex) {
+        SETVANV(graph, name, &view);
+    } else {
+        SETEANV(graph, name, &view);
+    }
+}
+
+static void _compiledtopology_setStringAttribute(igraph_t* graph, const gchar* name,
+        const guint32* offsets, guint64 n, const gchar* stringTable) {
+    igraph_strvector_t values;
+    igraph_strvector_init(&values, (glong) n);
+    for(guint64 v = 0; v < n; v++) {
+        igraph_strvector_set(&values, (glong) v, &stringTable[offsets[v]]);
+    }
+    SETVASV(graph, name, &values);
+    igraph_strvector_destroy(&values);
+}
+
+gboolean compiledtopology_read(const gchar* path, igraph_t* graph,
+        CompiledTopologyProperties* properties) {
+    utility_assert(path && graph && properties);
+
+    gint fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        critical("unable to open compiled topology '%s', error %i: %s", path, errno, g_strerror(errno));
+        return FALSE;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) < 0) {
+        critical("unable to stat compiled topology '%s', error %i: %s", path, errno, g_strerror(errno));
+        close(fd);
+        return FALSE;
+    }
+
+    gsize length = (gsize) fileStat.st_size;
+
+    /* we only read the file once to build the graph, igraph keeps its own copy of the arrays */
+    gchar* data = length > 0 ? mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if(data == MAP_FAILED) {
+        critical("unable to map compiled topology '%s', error %i: %s", path, errno, g_strerror(errno));
+        return FALSE;
+    }
+    madvise(data, length, MADV_SEQUENTIAL);
+
+    if(!_compiledtopology_checkHeader(path, data, length)) {
+        munmap(data, length);
+        return FALSE;
+    }
+
+    const CompiledTopologyHeader* header = (const CompiledTopologyHeader*) data;
+    CompiledTopologyLayout layout;
+    _compiledtopology_getLayout(header, &layout);
+
+    guint64 nV = header->nVertices, nE = header->nEdges;
+    const guint64* edgeOffsets = (const guint64*) (data + layout.edgeOffsets);
+    const guint32* edgeTargets = (const guint32*) (data + layout.edgeTargets);
+    const guint32* vertexIDs = (const guint32*) (data + layout.vertexIDs);
+    const guint32* vertexTypes = (const guint32*) (data + layout.vertexTypes);
+    const guint32* vertexIPs = (const guint32*) (data + layout.vertexIPs);
+    const guint32* vertexGeocodes = (const guint32*) (data + layout.vertexGeocodes);
+    const CompiledTopologyIPEntry* ipIndex = (const CompiledTopologyIPEntry*) (data + layout.ipIndex);
+    const gchar* stringTable = data + layout.stringTable;
+
+    const guint32* stringOffsets[] = {vertexIDs, vertexTypes, vertexIPs, vertexGeocodes};
+    if(!_compiledtopology_checkBounds(path, header, edgeOffsets, edgeTargets, stringOffsets,
+            G_N_ELEMENTS(stringOffsets), ipIndex, stringTable)) {
+        munmap(data, length);
+        return FALSE;
+    }
+
+    /* igraph takes the edges as a flat list of vertex pairs */
+    igraph_vector_t edges;
+    igraph_vector_init(&edges, (glong) (2 * nE));
+    for(guint64 v = 0; v < nV; v++) {
+        for(guint64 e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            VECTOR(edges)[2 * e] = (igraph_real_t) v;
+            VECTOR(edges)[(2 * e) + 1] = (igraph_real_t) edgeTargets[e];
+        }
+    }
+
+    igraph_i_set_attribute_table(&igraph_cattribute_table);
+    igraph_bool_t isDirected = (header->flags & COMPILED_TOPOLOGY_FLAG_DIRECTED) ? TRUE : FALSE;
+    gint result = igraph_create(graph, &edges, (igraph_integer_t) nV, isDirected);
+    igraph_vector_destroy(&edges);
+
+    if(result != IGRAPH_SUCCESS) {
+        critical("igraph_create return non-success code %i", result);
+        munmap(data, length);
+        return FALSE;
+    }
+
+    _compiledtopology_setNumericAttribute(graph, FALSE, "latency",
+            (const gdouble*) (data + layout.edgeLatencies), nE);
+    _compiledtopology_setNumericAttribute(graph, FALSE, "jitter",
+            (const gdouble*) (data + layout.edgeJitters), nE);
+    _compiledtopology_setNumericAttribute(graph, FALSE, "packetloss",
+            (const gdouble*) (data + layout.edgePacketLosses), nE);
+    _compiledtopology_setNumericAttribute(graph, FALSE, "bandwidth",
+            (const gdouble*) (data + layout.edgeBandwidths), nE);
+    _compiledtopology_setNumericAttribute(graph, TRUE, "bandwidthup",
+            (const gdouble*) (data + layout.vertexBandwidthUps), nV);
+    _compiledtopology_setNumericAttribute(graph, TRUE, "bandwidthdown",
+            (const gdouble*) (data + layout.vertexBandwidthDowns), nV);
+    _compiledtopology_setNumericAttribute(graph, TRUE, "packetloss",
+            (const gdouble*) (data + layout.vertexPacketLosses), nV);
+
+    _compiledtopology_setStringAttribute(graph, "id", vertexIDs, nV, stringTable);
+    _compiledtopology_setStringAttribute(graph, "type", vertexTypes, nV, stringTable);
+    _compiledtopology_setStringAttribute(graph, "ip", vertexIPs, nV, stringTable);
+    _compiledtopology_setStringAttribute(graph, "geocode", vertexGeocodes, nV, stringTable);
+
+    properties->isDirected = isDirected ? TRUE : FALSE;
+    properties->isComplete = (header->flags & COMPILED_TOPOLOGY_FLAG_COMPLETE) ? TRUE : FALSE;
+
+    /* the ip strings were parsed when the topology was compiled */
+    properties->vertexIPs = g_new(in_addr_t, nV);
+    for(guint64 v = 0; v < nV; v++) {
+        properties->vertexIPs[v] = INADDR_NONE;
+    }
+    for(guint64 i = 0; i < header->nIndexedVertices; i++) {
+        properties->vertexIPs[ipIndex[i].vertexIndex] = htonl(ipIndex[i].ip);
+    }
+
+    message("loaded compiled topology '%s' with %"G_GUINT64_FORMAT" vertices and %"
+            G_GUINT64_FORMAT" edges", path, nV, nE);
+
+    munmap(data, length);
+    return TRUE;
+}
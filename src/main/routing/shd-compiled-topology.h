@@ -0,0 +1,32 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_COMPILED_TOPOLOGY_H_
+#define SHD_COMPILED_TOPOLOGY_H_
+
+#include "shadow.h"
+
+/* A binary form of a validated graphml topology. It holds the edges in compressed sparse
+ * row form, the numeric edge and vertex attributes as flat arrays, the string attributes
+ * in a shared string table, and the points of interest sorted by IP address. Loading it
+ * maps the file into memory and hands the arrays to igraph without any text parsing.
+ *
+ * The file is written in the byte order of the machine that compiled it. */
+
+typedef struct _CompiledTopologyProperties CompiledTopologyProperties;
+struct _CompiledTopologyProperties {
+    gboolean isDirected;
+    gboolean isComplete;
+    /* the parsed 'ip' attribute of each vertex in network order, INADDR_NONE if it has none */
+    in_addr_t* vertexIPs;
+};
+
+gboolean compiledtopology_isCompiled(const gchar* path);
+gboolean compiledtopology_write(const gchar* path, igraph_t* graph,
+        const CompiledTopologyProperties* properties);
+gboolean compiledtopology_read(const gchar* path, igraph_t* graph,
+        CompiledTopologyProperties* properties);
+
+#endif /* SHD_COMPILED_TOPOLOGY_H_ */
@@ -6,6 +6,23 @@
 
 #include "shadow.h"
 
+typedef struct _DNSFrozenEntry DNSFrozenEntry;
+struct _DNSFrozenEntry {
+    /* the ip or the string hash of the name, depending on the table */
+    guint32 key;
+    const gchar* name;
+    /* NULL if the slot is empty */
+    Address* address;
+};
+
+/* an open addressing table with linear probing that never changes after it is built */
+typedef struct _DNSFrozenTable DNSFrozenTable;
+struct _DNSFrozenTable {
+    DNSFrozenEntry* entries;
+    guint32 mask;
+    guint shift;
+};
+
 struct _DNS {
     GMutex lock;
 
@@ -16,6 +33,12 @@ struct _DNS {
     GHashTable* addressByIP;
     GHashTable* addressByName;
 
+    /* once all hosts are registered, the mappings above are copied into these tables which
+     * are read without locking. they hold their own address references. */
+    volatile gint isFrozen;
+    DNSFrozenTable frozenByIP;
+    DNSFrozenTable frozenByName;
+
     MAGIC_DECLARE;
 };
 
@@ -103,9 +126,11 @@ static in_addr_t _dns_generateIP(DNS* dns) {
     return ip;
 }
 
-Address* dns_register(DNS* dns, GQuark id, gchar* name, gchar* requestedIP) {
+Address* dns_register(DNS* dns, GQuark id, guint hostIndex, gchar* name, gchar* requestedIP) {
     MAGIC_ASSERT(dns);
     utility_assert(name);
+    /* the frozen tables can not change */
+    utility_assert(!g_atomic_int_get(&dns->isFrozen));
 
     g_mutex_lock(&dns->lock);
 
@@ -126,7 +151,7 @@ Address* dns_register(DNS* dns, GQuark id, gchar* name, gchar* requestedIP) {
         ip = _dns_generateIP(dns);
     }
 
-    Address* address = address_new(id, mac, (guint32) ip, name, isLocal);
+    Address* address = address_new(id, hostIndex, mac, (guint32) ip, name, isLocal);
 
     /* store the ip/name mappings */
     if(!isLocal) {
@@ -143,6 +168,8 @@ Address* dns_register(DNS* dns, GQuark id, gchar* name, gchar* requestedIP) {
 
 void dns_deregister(DNS* dns, Address* address) {
     MAGIC_ASSERT(dns);
+    /* this only happens while shutting down, so the frozen tables may keep resolving the
+     * address until they are freed with the dns */
     if(!address_isLocal(address)) {
         g_mutex_lock(&dns->lock);
         /* these remove functions will call address_unref as necessary */
@@ -152,9 +179,117 @@ void dns_deregister(DNS* dns, Address* address) {
     }
 }
 
+/* fibonacci hashing, which uses the high bits so that it also spreads out IPs that only
+ * differ in their last octet */
+static guint32 _dns_getSlot(DNSFrozenTable* table, guint32 key) {
+    return (guint32)((key * 2654435769u) >> table->shift) & table->mask;
+}
+
+static void _dns_initFrozenTable(DNSFrozenTable* table, guint nEntries) {
+    /* keep the load factor at most one half so probe sequences stay short */
+    guint bits = 1;
+    while((1u << bits) < 2 * nEntries) {
+        bits++;
+    }
+
+    table->entries = g_new0(DNSFrozenEntry, 1u << bits);
+    table->mask = (1u << bits) - 1;
+    table->shift = 32 - bits;
+}
+
+static void _dns_insertFrozen(DNSFrozenTable* table, guint32 key, const gchar* name, Address* address) {
+    guint32 slot = _dns_getSlot(table, key);
+    while(table->entries[slot].address) {
+        slot = (slot + 1) & table->mask;
+    }
+
+    table->entries[slot].key = key;
+    table->entries[slot].name = name;
+    table->entries[slot].address = address;
+    address_ref(address);
+}
+
+static void _dns_clearFrozenTable(DNSFrozenTable* table) {
+    if(table->entries) {
+        for(guint32 slot = 0; slot <= table->mask; slot++) {
+            if(table->entries[slot].address) {
+                address_unref(table->entries[slot].address);
+            }
+        }
+        g_free(table->entries);
+        table->entries = NULL;
+    }
+}
+
+/* called once all hosts are registered, after which lookups no longer take the lock */
+void dns_freeze(DNS* dns) {
+    MAGIC_ASSERT(dns);
+
+    g_mutex_lock(&dns->lock);
+
+    if(!g_atomic_int_get(&dns->isFrozen)) {
+        _dns_initFrozenTable(&dns->frozenByIP, g_hash_table_size(dns->addressByIP));
+        _dns_initFrozenTable(&dns->frozenByName, g_hash_table_size(dns->addressByName));
+
+        GHashTableIter iter;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&iter, dns->addressByIP);
+        while(g_hash_table_iter_next(&iter, &key, &value)) {
+            _dns_insertFrozen(&dns->frozenByIP, (guint32)GPOINTER_TO_UINT(key), NULL, (Address*)value);
+        }
+
+        g_hash_table_iter_init(&iter, dns->addressByName);
+        while(g_hash_table_iter_next(&iter, &key, &value)) {
+            _dns_insertFrozen(&dns->frozenByName, (guint32)g_str_hash(key), (const gchar*)key, (Address*)value);
+        }
+
+        /* the tables must be complete before anyone sees the flag */
+        g_atomic_int_set(&dns->isFrozen, 1);
+
+        message("froze DNS with %u addresses", g_hash_table_size(dns->addressByIP));
+    }
+
+    g_mutex_unlock(&dns->lock);
+}
+
+static Address* _dns_lookupFrozenIP(DNS* dns, in_addr_t ip) {
+    DNSFrozenTable* table = &dns->frozenByIP;
+    guint32 slot = _dns_getSlot(table, (guint32)ip);
+    while(table->entries[slot].address) {
+        if(table->entries[slot].key == (guint32)ip) {
+            return table->entries[slot].address;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+    return NULL;
+}
+
+static Address* _dns_lookupFrozenName(DNS* dns, const gchar* name) {
+    DNSFrozenTable* table = &dns->frozenByName;
+    guint32 hash = (guint32)g_str_hash(name);
+    guint32 slot = _dns_getSlot(table, hash);
+    while(table->entries[slot].address) {
+        if(table->entries[slot].key == hash && g_str_equal(table->entries[slot].name, name)) {
+            return table->entries[slot].address;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+    return NULL;
+}
+
 Address* dns_resolveIPToAddress(DNS* dns, in_addr_t ip) {
     MAGIC_ASSERT(dns);
-    Address* result = g_hash_table_lookup(dns->addressByIP, GUINT_TO_POINTER(ip));
+
+    Address* result = NULL;
+    if(g_atomic_int_get(&dns->isFrozen)) {
+        result = _dns_lookupFrozenIP(dns, ip);
+    } else {
+        g_mutex_lock(&dns->lock);
+        result = g_hash_table_lookup(dns->addressByIP, GUINT_TO_POINTER(ip));
+        g_mutex_unlock(&dns->lock);
+    }
+
     if(!result) {
         gchar* ipStr = address_ipToNewString(ip);
         info("address for '%s' does not yet exist", ipStr);
@@ -165,7 +300,16 @@ Address* dns_resolveIPToAddress(DNS* dns, in_addr_t ip) {
 
 Address* dns_resolveNameToAddress(DNS* dns, const gchar* name) {
     MAGIC_ASSERT(dns);
-    Address* result = g_hash_table_lookup(dns->addressByName, name);
+
+    Address* result = NULL;
+    if(g_atomic_int_get(&dns->isFrozen)) {
+        result = _dns_lookupFrozenName(dns, name);
+    } else {
+        g_mutex_lock(&dns->lock);
+        result = g_hash_table_lookup(dns->addressByName, name);
+        g_mutex_unlock(&dns->lock);
+    }
+
     if(!result) {
         warning("unable to find address from name '%s'", name);
     }
@@ -193,6 +337,9 @@ void dns_free(DNS* dns) {
     g_hash_table_destroy(dns->addressByIP);
     g_hash_table_destroy(dns->addressByName);
 
+    _dns_clearFrozenTable(&dns->frozenByIP);
+    _dns_clearFrozenTable(&dns->frozenByName);
+
     g_mutex_clear(&(dns->lock));
 
     MAGIC_CLEAR(dns);
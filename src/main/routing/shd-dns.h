@@ -14,8 +14,9 @@ typedef struct _DNS DNS;
 DNS* dns_new();
 void dns_free(DNS* dns);
 
-Address* dns_register(DNS* dns, GQuark id, gchar* name, gchar* requestedIP);
+Address* dns_register(DNS* dns, GQuark id, guint hostIndex, gchar* name, gchar* requestedIP);
 void dns_deregister(DNS* dns, Address* address);
+void dns_freeze(DNS* dns);
 
 Address* dns_resolveIPToAddress(DNS* dns, in_addr_t ip);
 Address* dns_resolveNameToAddress(DNS* dns, const gchar* name);
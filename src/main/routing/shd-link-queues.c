@@ -0,0 +1,131 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+/* the counters of each thread start on their own cache line */
+#define LINK_QUEUES_COUNTERS_PER_LINE 8
+
+typedef struct _LinkQueue LinkQueue;
+struct _LinkQueue {
+    /* the capacity of the link */
+    gdouble bytesPerNanosecond;
+    /* how many bytes the link can hold before it drops */
+    gdouble bufferBytes;
+    /* the bytes still waiting to be sent at the last update */
+    gdouble backlogBytes;
+
+    /* what packets sent over the link during the current round experience */
+    SimulationTime delay;
+    gdouble dropChance;
+};
+
+struct _LinkQueues {
+    LinkQueue* links;
+    guint nLinks;
+
+    /* the bytes each thread sent over each link since the last update, nThreads rows
+     * of stride counters. a thread only ever writes to its own row. */
+    guint64* demands;
+    guint nThreads;
+    guint stride;
+
+    SimulationTime lastUpdateTime;
+
+    MAGIC_DECLARE;
+};
+
+LinkQueues* linkqueues_new(const gdouble* bandwidthsKiBps, guint nLinks, guint nThreads) {
+    utility_assert(bandwidthsKiBps || nLinks == 0);
+
+    LinkQueues* queues = g_new0(LinkQueues, 1);
+    MAGIC_INIT(queues);
+
+    queues->nLinks = nLinks;
+    queues->links = g_new0(LinkQueue, nLinks);
+    for(guint i = 0; i < nLinks; i++) {
+        utility_assert(bandwidthsKiBps[i] > 0);
+        LinkQueue* link = &(queues->links[i]);
+        link->bytesPerNanosecond = (bandwidthsKiBps[i] * 1024.0f) / SIMTIME_ONE_SECOND;
+        link->bufferBytes = link->bytesPerNanosecond * CONFIG_LINK_QUEUE_BUFFER_TIME;
+    }
+
+    queues->nThreads = MAX(1, nThreads);
+    queues->stride = ((nLinks + LINK_QUEUES_COUNTERS_PER_LINE - 1) / LINK_QUEUES_COUNTERS_PER_LINE) *
+            LINK_QUEUES_COUNTERS_PER_LINE;
+    queues->demands = g_new0(guint64, (gsize)queues->nThreads * queues->stride);
+
+    return queues;
+}
+
+void linkqueues_free(LinkQueues* queues) {
+    MAGIC_ASSERT(queues);
+
+    g_free(queues->demands);
+    g_free(queues->links);
+
+    MAGIC_CLEAR(queues);
+    g_free(queues);
+}
+
+void linkqueues_addDemand(LinkQueues* queues, guint threadID, guint linkID, gsize bytes) {
+    MAGIC_ASSERT(queues);
+    utility_assert(threadID < queues->nThreads);
+    utility_assert(linkID < queues->nLinks);
+    queues->demands[((gsize)threadID * queues->stride) + linkID] += (guint64) bytes;
+}
+
+SimulationTime linkqueues_getDelay(LinkQueues* queues, guint linkID) {
+    MAGIC_ASSERT(queues);
+    utility_assert(linkID < queues->nLinks);
+    return queues->links[linkID].delay;
+}
+
+gdouble linkqueues_getDropChance(LinkQueues* queues, guint linkID) {
+    MAGIC_ASSERT(queues);
+    utility_assert(linkID < queues->nLinks);
+    return queues->links[linkID].dropChance;
+}
+
+SimulationTime linkqueues_getLastUpdateTime(LinkQueues* queues) {
+    MAGIC_ASSERT(queues);
+    return queues->lastUpdateTime;
+}
+
+/* drains what was sent since the last update at each link's capacity. this must only be
+ * called while no thread is sending. */
+void linkqueues_update(LinkQueues* queues, SimulationTime now) {
+    MAGIC_ASSERT(queues);
+
+    if(now <= queues->lastUpdateTime) {
+        return;
+    }
+    gdouble elapsed = (gdouble)(now - queues->lastUpdateTime);
+    queues->lastUpdateTime = now;
+
+    for(guint i = 0; i < queues->nLinks; i++) {
+        LinkQueue* link = &(queues->links[i]);
+
+        guint64 demand = 0;
+        for(guint t = 0; t < queues->nThreads; t++) {
+            guint64* counter = &(queues->demands[((gsize)t * queues->stride) + i]);
+            demand += *counter;
+            *counter = 0;
+        }
+
+        gdouble backlog = link->backlogBytes + (gdouble)demand - (link->bytesPerNanosecond * elapsed);
+        backlog = MAX(0, backlog);
+
+        /* if the traffic keeps coming at this rate, the link drops what it can not buffer */
+        link->dropChance = 0;
+        if(backlog > link->bufferBytes) {
+            link->dropChance = MIN(1.0f, (backlog - link->bufferBytes) / (gdouble)demand);
+            backlog = link->bufferBytes;
+        }
+
+        link->backlogBytes = backlog;
+        link->delay = (SimulationTime) (backlog / link->bytesPerNanosecond);
+    }
+}
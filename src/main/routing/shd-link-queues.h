@@ -0,0 +1,27 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_LINK_QUEUES_H_
+#define SHD_LINK_QUEUES_H_
+
+#include "shadow.h"
+
+/* A fluid queue for each bandwidth limited topology edge (link). While a round runs,
+ * each worker thread only adds the bytes it sends over a link to its own counters, and
+ * reads the queueing delay and drop chance that were computed for the round. Between
+ * rounds, the counters are summed and drained at the link capacity to compute the
+ * delay and drop chance of the next round, so the links need no locks. */
+typedef struct _LinkQueues LinkQueues;
+
+LinkQueues* linkqueues_new(const gdouble* bandwidthsKiBps, guint nLinks, guint nThreads);
+void linkqueues_free(LinkQueues* queues);
+
+void linkqueues_addDemand(LinkQueues* queues, guint threadID, guint linkID, gsize bytes);
+SimulationTime linkqueues_getDelay(LinkQueues* queues, guint linkID);
+gdouble linkqueues_getDropChance(LinkQueues* queues, guint linkID);
+SimulationTime linkqueues_getLastUpdateTime(LinkQueues* queues);
+void linkqueues_update(LinkQueues* queues, SimulationTime now);
+
+#endif /* SHD_LINK_QUEUES_H_ */
@@ -0,0 +1,100 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include "shadow.h"
+
+typedef struct _PrefixTrieNode PrefixTrieNode;
+struct _PrefixTrieNode {
+    /* index of the child node for the next bit being 0 or 1, 0 if none. the root is
+     * at index 0 and is never anyone's child. */
+    guint children[2];
+    /* the value of the first address inserted below this node */
+    gint value;
+};
+
+struct _PrefixTrie {
+    /* nodes are stored by index, so growing the array does not invalidate links */
+    GArray* nodes;
+    guint size;
+    MAGIC_DECLARE;
+};
+
+static guint _prefixtrie_addNode(PrefixTrie* trie, gint value) {
+    PrefixTrieNode node;
+    node.children[0] = 0;
+    node.children[1] = 0;
+    node.value = value;
+    g_array_append_val(trie->nodes, node);
+    return trie->nodes->len - 1;
+}
+
+PrefixTrie* prefixtrie_new() {
+    PrefixTrie* trie = g_new0(PrefixTrie, 1);
+    MAGIC_INIT(trie);
+
+    trie->nodes = g_array_new(FALSE, FALSE, sizeof(PrefixTrieNode));
+    _prefixtrie_addNode(trie, -1);
+
+    return trie;
+}
+
+void prefixtrie_free(PrefixTrie* trie) {
+    MAGIC_ASSERT(trie);
+
+    g_array_free(trie->nodes, TRUE);
+
+    MAGIC_CLEAR(trie);
+    g_free(trie);
+}
+
+void prefixtrie_insert(PrefixTrie* trie, in_addr_t ip, gint value) {
+    MAGIC_ASSERT(trie);
+    utility_assert(value >= 0);
+
+    /* walk the bits from most to least significant */
+    guint32 hostIP = ntohl(ip);
+    guint nodeIndex = 0;
+
+    if(g_array_index(trie->nodes, PrefixTrieNode, 0).value < 0) {
+        g_array_index(trie->nodes, PrefixTrieNode, 0).value = value;
+    }
+
+    for(gint bit = 31; bit >= 0; bit--) {
+        guint b = (hostIP >> bit) & 1;
+        guint childIndex = g_array_index(trie->nodes, PrefixTrieNode, nodeIndex).children[b];
+        if(childIndex == 0) {
+            childIndex = _prefixtrie_addNode(trie, value);
+            g_array_index(trie->nodes, PrefixTrieNode, nodeIndex).children[b] = childIndex;
+        }
+        nodeIndex = childIndex;
+    }
+
+    trie->size++;
+}
+
+/* returns -1 if the trie is empty */
+gint prefixtrie_lookupLongestPrefix(PrefixTrie* trie, in_addr_t ip) {
+    MAGIC_ASSERT(trie);
+
+    guint32 hostIP = ntohl(ip);
+    PrefixTrieNode* nodes = (PrefixTrieNode*) trie->nodes->data;
+    guint nodeIndex = 0;
+
+    /* every address below the deepest node we can reach shares the longest prefix */
+    for(gint bit = 31; bit >= 0; bit--) {
+        guint childIndex = nodes[nodeIndex].children[(hostIP >> bit) & 1];
+        if(childIndex == 0) {
+            break;
+        }
+        nodeIndex = childIndex;
+    }
+
+    return nodes[nodeIndex].value;
+}
+
+guint prefixtrie_getSize(PrefixTrie* trie) {
+    MAGIC_ASSERT(trie);
+    return trie->size;
+}
@@ -0,0 +1,23 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_PREFIX_TRIE_H_
+#define SHD_PREFIX_TRIE_H_
+
+#include "shadow.h"
+
+/* A binary radix trie over IPv4 addresses that finds the stored address sharing the
+ * longest prefix with a given address in at most 32 steps. Each address maps to an
+ * integer value; among addresses that match equally well, the one inserted first wins. */
+typedef struct _PrefixTrie PrefixTrie;
+
+PrefixTrie* prefixtrie_new();
+void prefixtrie_free(PrefixTrie* trie);
+
+void prefixtrie_insert(PrefixTrie* trie, in_addr_t ip, gint value);
+gint prefixtrie_lookupLongestPrefix(PrefixTrie* trie, in_addr_t ip);
+guint prefixtrie_getSize(PrefixTrie* trie);
+
+#endif /* SHD_PREFIX_TRIE_H_ */
@@ -6,6 +6,78 @@
 
 #include "shadow.h"
 
+typedef struct _TopologyPathEntry TopologyPathEntry;
+struct _TopologyPathEntry {
+    /* negative if there is no path */
+    gdouble latency;
+    gdouble reliability;
+};
+
+/* a bandwidth limited link on a row's shortest path tree, and the node of the limited
+ * link before it on the path from the row's vertex, or 0 if there is none */
+typedef struct _TopologyPathLink TopologyPathLink;
+struct _TopologyPathLink {
+    guint link;
+    guint previous;
+};
+
+/* a scheduled change to the properties of an edge */
+typedef struct _TopologyEdgeChange TopologyEdgeChange;
+struct _TopologyEdgeChange {
+    SimulationTime time;
+    igraph_integer_t edgeIndex;
+    /* negative if the property does not change */
+    gdouble latency;
+    gdouble packetloss;
+};
+
+/* an edge whose properties were just changed */
+typedef struct _TopologyChangedEdge TopologyChangedEdge;
+struct _TopologyChangedEdge {
+    igraph_integer_t edgeIndex;
+    igraph_integer_t fromVertexIndex;
+    igraph_integer_t toVertexIndex;
+    /* if the latency decreased, paths that did not use the edge may use it now */
+    gboolean isShorter;
+};
+
+/* a path that a thread looked up recently, keyed by host indices */
+typedef struct _TopologyLocalPath TopologyLocalPath;
+struct _TopologyLocalPath {
+    /* HOST_INDEX_INVALID if the slot is empty */
+    guint srcHostIndex;
+    guint dstHostIndex;
+    gdouble latency;
+    gdouble reliability;
+};
+
+/* a direct mapped cache of paths that is private to one thread */
+typedef struct _TopologyLocalCache TopologyLocalCache;
+struct _TopologyLocalCache {
+    /* the paths are only valid for this topology and cache generation */
+    Topology* top;
+    gint generation;
+    TopologyLocalPath paths[CONFIG_TOPOLOGY_LOCAL_CACHE_ENTRIES];
+};
+
+static GPrivate topologyLocalCacheKey = G_PRIVATE_INIT(g_free);
+
+/* in the shortest path tree of a matrix row, the arc that reaches a vertex that was never
+ * settled, and the arc that reaches the row's own vertex */
+#define TOPOLOGY_ARC_NONE G_MAXUINT
+#define TOPOLOGY_ARC_SOURCE (G_MAXUINT-1)
+
+typedef struct _TopologyAdjacency TopologyAdjacency;
+
+/* a set of points of interest that a host may be attached to */
+typedef struct _TopologyAttachBucket TopologyAttachBucket;
+struct _TopologyAttachBucket {
+    /* the vertex indices in vertex order, for random selection */
+    GArray* vertices;
+    /* the vertices with usable IPs, for longest prefix matching */
+    PrefixTrie* trie;
+};
+
 struct _Topology {
     /* the imported igraph graph data - operations on it after initializations
      * MUST be locked in cases where igraph is not thread-safe! */
@@ -23,12 +95,71 @@ struct _Topology {
     GHashTable* virtualIP;
     GRWLock virtualIPLock;
 
+    /* the parsed 'ip' attribute of each vertex, so we only parse the strings once.
+     * this never changes after the graph is loaded. */
+    in_addr_t* vertexIPs;
+
+    /* the points of interest grouped by the attach hints, built once when the graph is
+     * loaded and never changed after, so attaching hosts needs no locks.
+     * the keys are lowercase type, geocode, or type and geocode joined by a newline */
+    TopologyAttachBucket* attachAll;
+    GHashTable* attachByType;
+    GHashTable* attachByGeocode;
+    GHashTable* attachByTypeGeocode;
+    /* IP (stored as pointer) -> GArray of the vertices with exactly that IP */
+    GHashTable* attachByIP;
+
+    /* the vertex each host is attached to, as a gint indexed by host index, or -1.
+     * protected by the virtualIPLock */
+    GArray* hostVertices;
+
+    /* once all hosts are attached, the path between every pair of attached vertices.
+     * these never change after they are built, so reading them needs no locks.
+     * host index->matrix index, or -1 if the host is not attached */
+    gint* hostMatrixIndices;
+    guint hostMatrixIndicesLength;
+    TopologyPathEntry* pathMatrix;
+    guint pathMatrixSize;
+
+    /* if some edges have a bandwidth, the last bandwidth limited arc (link) on the path of
+     * each matrix entry, as the index of a TopologyPathLink in the row's node storage.
+     * paths are walked back through the previous nodes, and node 0 of every row ends
+     * every path. these are NULL if no edge has a bandwidth, and change like the matrix does. */
+    guint* pathLinks;
+    GArray** pathLinkRows;
+    /* the bandwidth of each link in KiB/s */
+    gdouble* linkBandwidths;
+    guint linkCount;
+
+    /* if edges will change, what we keep to recompute the matrix rows that a change affects:
+     * our copy of the graph, the vertex of each row and the row of each vertex (or -1),
+     * and the arc that reaches each vertex in the shortest path tree of each row. the
+     * trees are NULL for complete graphs, or if they would take too much memory. */
+    TopologyAdjacency* matrixAdjacency;
+    guint* matrixVertices;
+    gint* matrixRows;
+    guint* pathTrees;
+    guint pathSearchThreads;
+
+    /* changes to edge properties sorted by time, and the next one that is not applied yet.
+     * these are only used by the thread that runs between rounds. */
+    GArray* edgeChanges;
+    guint nextEdgeChange;
+    /* vertex 'id' -> vertex index + 1 (stored as pointer), built when needed */
+    GHashTable* vertexIDs;
+
     /* cached latencies to avoid excessive shortest path lookups
      * store a cache table for every connected address
      * fromAddress->toAddress->Path* */
     GHashTable* pathCache;
     gdouble minimumPathLatency;
+    /* while edges may still change, the edges used by the cached paths of each source.
+     * fromAddress->set of edge indices */
+    GHashTable* pathCacheEdges;
     GRWLock pathCacheLock;
+    /* incremented whenever cached paths or host attachments change, which makes every
+     * thread drop its local paths on its next lookup */
+    volatile gint pathCacheGeneration;
 
     /******/
     /* START - items protected by a global topology lock */
@@ -52,23 +183,6 @@ struct _Topology {
     MAGIC_DECLARE;
 };
 
-typedef struct _AttachHelper AttachHelper;
-struct _AttachHelper {
-    GQueue* candidatesAll;
-    guint numCandidatesAllIPs;
-    GQueue* candidatesType;
-    guint numCandidatesTypeIPs;
-    GQueue* candidatesCode;
-    guint numCandidatesCodeIPs;
-    GQueue* candidatesTypeCode;
-    guint numCandidatesTypeCodeIPs;
-    gchar* typeHint;
-    gchar* geocodeHint;
-    gchar* ipHint;
-    in_addr_t requestedIP;
-    gboolean foundExactIPMatch;
-};
-
 typedef void (*EdgeNotifyFunc)(Topology* top, igraph_integer_t edgeIndex, gpointer userData);
 typedef void (*VertexNotifyFunc)(Topology* top, igraph_integer_t vertexIndex, gpointer userData);
 
@@ -122,57 +236,121 @@ static gboolean _topology_loadGraph(Topology* top, const gchar* graphPath) {
     return TRUE;
 }
 
-static gboolean _topology_checkGraphProperties(Topology* top) {
+static gboolean _topology_loadCompiledGraph(Topology* top, const gchar* graphPath) {
     MAGIC_ASSERT(top);
-    gint result = 0;
 
-    message("checking graph properties...");
+    CompiledTopologyProperties properties;
+    memset(&properties, 0, sizeof(CompiledTopologyProperties));
 
-    /* IGRAPH_WEAK means the undirected version of the graph is connected
-     * IGRAPH_STRONG means a vertex can reach all others via a directed path
-     * we must be able to send packets in both directions, so we want IGRAPH_STRONG */
-    result = igraph_is_connected(&top->graph, &(top->isConnected), IGRAPH_STRONG);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_is_connected return non-success code %i", result);
-        return FALSE;
+    g_mutex_lock(&(top->topologyLock));
+    _topology_lockGraph(top);
+
+    message("reading compiled topology graph at '%s'...", graphPath);
+    gboolean isSuccess = compiledtopology_read(graphPath, &top->graph, &properties);
+
+    if(isSuccess) {
+        /* the graph was validated when it was compiled */
+        top->isConnected = (igraph_bool_t)TRUE;
+        top->clusterCount = 1;
+        top->isDirected = (igraph_bool_t)properties.isDirected;
+        top->isComplete = (igraph_bool_t)properties.isComplete;
+        top->vertexCount = igraph_vcount(&top->graph);
+        top->edgeCount = igraph_ecount(&top->graph);
+        top->vertexIPs = properties.vertexIPs;
+
+        message("topology graph is %s, %s, and strongly connected with %u %s and %u %s",
+                top->isComplete ? "complete" : "incomplete",
+                top->isDirected ? "directed" : "undirected",
+                (guint)top->vertexCount, top->vertexCount == 1 ? "vertex" : "vertices",
+                (guint)top->edgeCount, top->edgeCount == 1 ? "edge" : "edges");
     }
 
-    igraph_integer_t clusterCount;
-    result = igraph_clusters(&top->graph, NULL, NULL, &(top->clusterCount), IGRAPH_STRONG);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_clusters return non-success code %i", result);
-        return FALSE;
+    _topology_unlockGraph(top);
+    g_mutex_unlock(&(top->topologyLock));
+
+    return isSuccess;
+}
+
+static gboolean _topology_extractVertexIPs(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    _topology_lockGraph(top);
+
+    igraph_integer_t vertexCount = igraph_vcount(&top->graph);
+    top->vertexIPs = g_new(in_addr_t, vertexCount);
+    for(igraph_integer_t vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+        const gchar* ipStr = VAS(&top->graph, "ip", vertexIndex);
+        top->vertexIPs[vertexIndex] = ipStr ? address_stringToIP(ipStr) : INADDR_NONE;
     }
 
-    /* it must be connected */
-    if(!top->isConnected || top->clusterCount > 1) {
-        critical("topology must be but is not strongly connected");
-        return FALSE;
+    _topology_unlockGraph(top);
+
+    return TRUE;
+}
+
+/* a graph is complete if every vertex has an edge to every other vertex. we count the distinct
+ * neighbors of each vertex, which is linear in the size of the graph, instead of computing
+ * the largest clique which is exponential in the worst case. */
+static gboolean _topology_isComplete(Topology* top, gboolean* isComplete) {
+    MAGIC_ASSERT(top);
+
+    igraph_integer_t vertexCount = igraph_vcount(&top->graph);
+    igraph_integer_t edgeCount = igraph_ecount(&top->graph);
+
+    /* most graphs have far too few edges, so we can answer without looking at them */
+    gdouble requiredEdges = ((gdouble)vertexCount) * ((gdouble)(vertexCount - 1));
+    if(!top->isDirected) {
+        requiredEdges /= 2;
+    }
+    if(((gdouble)edgeCount) < requiredEdges) {
+        *isComplete = FALSE;
+        return TRUE;
     }
 
-    top->isDirected = igraph_is_directed(&top->graph);
+    igraph_vector_t neighbors;
+    igraph_vector_init(&neighbors, 0);
 
-    /* the topology is complete if the largest clique includes all vertices */
-    igraph_integer_t largestCliqueSize = 0;
-    result = igraph_clique_number(&top->graph, &largestCliqueSize);
-    if(result != IGRAPH_SUCCESS) {
-        critical("igraph_clique_number return non-success code %i", result);
-        return FALSE;
+    /* the last vertex whose neighbors included each vertex, to skip parallel edges */
+    igraph_integer_t* lastSeenFrom = g_new(igraph_integer_t, vertexCount);
+    for(igraph_integer_t v = 0; v < vertexCount; v++) {
+        lastSeenFrom[v] = -1;
     }
 
-    if(largestCliqueSize == igraph_vcount(&top->graph)) {
-        top->isComplete = (igraph_bool_t)TRUE;
+    gboolean isSuccess = TRUE;
+    *isComplete = TRUE;
+
+    for(igraph_integer_t v = 0; v < vertexCount && *isComplete; v++) {
+        gint result = igraph_neighbors(&top->graph, &neighbors, v, IGRAPH_OUT);
+        if(result != IGRAPH_SUCCESS) {
+            critical("igraph_neighbors return non-success code %i", result);
+            isSuccess = FALSE;
+            break;
+        }
+
+        igraph_integer_t distinctCount = 0;
+        glong n = igraph_vector_size(&neighbors);
+        for(glong i = 0; i < n; i++) {
+            igraph_integer_t u = (igraph_integer_t) VECTOR(neighbors)[i];
+            if(u != v && lastSeenFrom[u] != v) {
+                lastSeenFrom[u] = v;
+                distinctCount++;
+            }
+        }
+
+        if(distinctCount != vertexCount - 1) {
+            *isComplete = FALSE;
+        }
     }
 
-    message("topology graph is %s, %s, and %s with %u %s",
-            top->isComplete ? "complete" : "incomplete",
-            top->isDirected ? "directed" : "undirected",
-            top->isConnected ? "strongly connected" : "disconnected",
-            (guint)top->clusterCount, top->clusterCount == 1 ? "cluster" : "clusters");
+    g_free(lastSeenFrom);
+    igraph_vector_destroy(&neighbors);
 
-    message("checking graph attributes...");
+    return isSuccess;
+}
+
+static void _topology_logGraphAttributes(Topology* top) {
+    MAGIC_ASSERT(top);
 
-    /* now check list of all attributes */
     igraph_strvector_t gnames, vnames, enames;
     igraph_vector_t gtypes, vtypes, etypes;
     igraph_strvector_init(&gnames, 25);
@@ -182,27 +360,26 @@ static gboolean _topology_checkGraphProperties(Topology* top) {
     igraph_strvector_init(&enames, 25);
     igraph_vector_init(&etypes, 25);
 
-    result = igraph_cattribute_list(&top->graph, &gnames, &gtypes, &vnames, &vtypes, &enames, &etypes);
+    gint result = igraph_cattribute_list(&top->graph, &gnames, &gtypes, &vnames, &vtypes, &enames, &etypes);
     if(result != IGRAPH_SUCCESS) {
-        critical("igraph_cattribute_list return non-success code %i", result);
-        return FALSE;
-    }
-
-    gint i = 0;
-    for(i = 0; i < igraph_strvector_size(&gnames); i++) {
-        gchar* name = NULL;
-        igraph_strvector_get(&gnames, (glong) i, &name);
-        debug("found graph attribute '%s'", name);
-    }
-    for(i = 0; i < igraph_strvector_size(&vnames); i++) {
-        gchar* name = NULL;
-        igraph_strvector_get(&vnames, (glong) i, &name);
-        debug("found vertex attribute '%s'", name);
-    }
-    for(i = 0; i < igraph_strvector_size(&enames); i++) {
-        gchar* name = NULL;
-        igraph_strvector_get(&enames, (glong) i, &name);
-        debug("found edge attribute '%s'", name);
+        warning("igraph_cattribute_list return non-success code %i", result);
+    } else {
+        gint i = 0;
+        for(i = 0; i < igraph_strvector_size(&gnames); i++) {
+            gchar* name = NULL;
+            igraph_strvector_get(&gnames, (glong) i, &name);
+            debug("found graph attribute '%s'", name);
+        }
+        for(i = 0; i < igraph_strvector_size(&vnames); i++) {
+            gchar* name = NULL;
+            igraph_strvector_get(&vnames, (glong) i, &name);
+            debug("found vertex attribute '%s'", name);
+        }
+        for(i = 0; i < igraph_strvector_size(&enames); i++) {
+            gchar* name = NULL;
+            igraph_strvector_get(&enames, (glong) i, &name);
+            debug("found edge attribute '%s'", name);
+        }
     }
 
     igraph_strvector_destroy(&gnames);
@@ -211,8 +388,59 @@ static gboolean _topology_checkGraphProperties(Topology* top) {
     igraph_vector_destroy(&vtypes);
     igraph_strvector_destroy(&enames);
     igraph_vector_destroy(&etypes);
+}
+
+static gboolean _topology_checkGraphProperties(Topology* top) {
+    MAGIC_ASSERT(top);
+    gint result = 0;
+
+    message("checking graph properties...");
 
-    message("successfully verified graph attributes");
+    /* IGRAPH_WEAK means the undirected version of the graph is connected
+     * IGRAPH_STRONG means a vertex can reach all others via a directed path
+     * we must be able to send packets in both directions, so we want IGRAPH_STRONG */
+    result = igraph_is_connected(&top->graph, &(top->isConnected), IGRAPH_STRONG);
+    if(result != IGRAPH_SUCCESS) {
+        critical("igraph_is_connected return non-success code %i", result);
+        return FALSE;
+    }
+
+    /* it must be connected */
+    if(!top->isConnected) {
+        /* counting the clusters is only worth the extra pass to explain the error */
+        result = igraph_clusters(&top->graph, NULL, NULL, &(top->clusterCount), IGRAPH_STRONG);
+        if(result == IGRAPH_SUCCESS) {
+            critical("topology must be but is not strongly connected, it has %u clusters",
+                    (guint)top->clusterCount);
+        } else {
+            critical("topology must be but is not strongly connected");
+        }
+        return FALSE;
+    }
+
+    /* a strongly connected graph is a single strongly connected cluster */
+    top->clusterCount = 1;
+
+    top->isDirected = igraph_is_directed(&top->graph);
+
+    gboolean isComplete = FALSE;
+    if(!_topology_isComplete(top, &isComplete)) {
+        return FALSE;
+    }
+    top->isComplete = (igraph_bool_t)isComplete;
+
+    message("topology graph is %s, %s, and %s with %u %s",
+            top->isComplete ? "complete" : "incomplete",
+            top->isDirected ? "directed" : "undirected",
+            top->isConnected ? "strongly connected" : "disconnected",
+            (guint)top->clusterCount, top->clusterCount == 1 ? "cluster" : "clusters");
+
+    /* the attribute list is only informational */
+    if(!logger_shouldFilter(logger_getDefault(), LOGLEVEL_DEBUG)) {
+        message("checking graph attributes...");
+        _topology_logGraphAttributes(top);
+        message("successfully verified graph attributes");
+    }
 
     return TRUE;
 }
@@ -275,15 +503,19 @@ static gboolean _topology_checkGraphVertices(Topology* top) {
 
     message("checking graph vertices...");
 
-    igraph_integer_t vertexCount = _topology_iterateAllVertices(top, _topology_checkGraphVerticesHelperHook, NULL);
-    if(vertexCount < 0) {
-        /* there was some kind of error */
-        return FALSE;
-    }
-
     top->vertexCount = igraph_vcount(&top->graph);
-    if(top->vertexCount != vertexCount) {
-        warning("igraph_vcount %f does not match iterator count %f", top->vertexCount, vertexCount);
+
+    /* the vertex hook only logs the vertex attributes, so skip it unless we would see them */
+    if(!logger_shouldFilter(logger_getDefault(), LOGLEVEL_DEBUG)) {
+        igraph_integer_t vertexCount = _topology_iterateAllVertices(top, _topology_checkGraphVerticesHelperHook, NULL);
+        if(vertexCount < 0) {
+            /* there was some kind of error */
+            return FALSE;
+        }
+
+        if(top->vertexCount != vertexCount) {
+            warning("igraph_vcount %f does not match iterator count %f", top->vertexCount, vertexCount);
+        }
     }
 
     message("%u graph vertices ok", (guint) top->vertexCount);
@@ -433,11 +665,16 @@ static gboolean _topology_extractEdgeWeights(Topology* top) {
 
 static void _topology_clearCache(Topology* top) {
     MAGIC_ASSERT(top);
+    g_atomic_int_inc(&(top->pathCacheGeneration));
     g_rw_lock_writer_lock(&(top->pathCacheLock));
     if(top->pathCache) {
         g_hash_table_destroy(top->pathCache);
         top->pathCache = NULL;
     }
+    if(top->pathCacheEdges) {
+        g_hash_table_destroy(top->pathCacheEdges);
+        top->pathCacheEdges = NULL;
+    }
     g_rw_lock_writer_unlock(&(top->pathCacheLock));
 
     /* lock the read on the shortest path info */
@@ -470,8 +707,14 @@ static Path* _topology_getPathFromCache(Topology* top, igraph_integer_t srcVerte
     return path;
 }
 
+static gboolean _topology_hasPendingEdgeChanges(Topology* top) {
+    return top->nextEdgeChange < top->edgeChanges->len;
+}
+
+/* pathEdges holds the indices of the edges on the path if we need to track them, or is NULL */
 static void _topology_storePathInCache(Topology* top, igraph_integer_t srcVertexIndex,
-        igraph_integer_t dstVertexIndex, igraph_real_t totalLatency, igraph_real_t totalReliability) {
+        igraph_integer_t dstVertexIndex, igraph_real_t totalLatency, igraph_real_t totalReliability,
+        GArray* pathEdges) {
     MAGIC_ASSERT(top);
 
     gdouble latencyMS = (gdouble) totalLatency;
@@ -497,6 +740,22 @@ static void _topology_storePathInCache(Topology* top, igraph_integer_t srcVertex
     /* now cache this sources path to the destination */
     g_hash_table_replace(sourceCache, GINT_TO_POINTER(dstVertexIndex), path);
 
+    /* remember which edges this source depends on, so a change only drops the sources it affects */
+    if(pathEdges) {
+        if(!top->pathCacheEdges) {
+            top->pathCacheEdges = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_hash_table_destroy);
+        }
+        GHashTable* sourceEdges = g_hash_table_lookup(top->pathCacheEdges, GINT_TO_POINTER(srcVertexIndex));
+        if(!sourceEdges) {
+            sourceEdges = g_hash_table_new(g_direct_hash, g_direct_equal);
+            g_hash_table_replace(top->pathCacheEdges, GINT_TO_POINTER(srcVertexIndex), sourceEdges);
+        }
+        for(guint i = 0; i < pathEdges->len; i++) {
+            igraph_integer_t edgeIndex = g_array_index(pathEdges, igraph_integer_t, i);
+            g_hash_table_add(sourceEdges, GINT_TO_POINTER(edgeIndex));
+        }
+    }
+
     /* track the minimum network latency in the entire graph */
     if(top->minimumPathLatency == 0 || latencyMS < top->minimumPathLatency) {
         top->minimumPathLatency = latencyMS;
@@ -505,8 +764,9 @@ static void _topology_storePathInCache(Topology* top, igraph_integer_t srcVertex
 
     g_rw_lock_writer_unlock(&(top->pathCacheLock));
 
-    /* make sure the worker knows the new min latency */
-    if(wasUpdated) {
+    /* make sure the worker knows the new min latency. paths computed before the
+     * workers start are reported with topology_getMinimumPathLatency instead. */
+    if(wasUpdated && worker_isAlive()) {
         worker_updateMinTimeJump(top->minimumPathLatency);
     }
 }
@@ -530,23 +790,33 @@ static igraph_integer_t _topology_getConnectedVertexIndex(Topology* top, Address
     return (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPtr);
 }
 
+/* @warning top->graphLock must be held when calling this function!! */
+static gint _topology_findEdge(Topology* top, igraph_integer_t fromVertexIndex,
+        igraph_integer_t toVertexIndex, igraph_integer_t* edgeIndexOut) {
+#ifndef IGRAPH_VERSION
+    return igraph_get_eid(&top->graph, edgeIndexOut, fromVertexIndex, toVertexIndex, (igraph_bool_t)TRUE);
+#else
+    return igraph_get_eid(&top->graph, edgeIndexOut, fromVertexIndex, toVertexIndex, (igraph_bool_t)TRUE, (igraph_bool_t)TRUE);
+#endif
+}
+
 /* @warning top->graphLock must be held when calling this function!! */
 static gint _topology_getEdgeHelper(Topology* top, igraph_integer_t fromVertexIndex,
-        igraph_integer_t toVertexIndex, igraph_real_t* edgeLatencyOut, igraph_real_t* edgeReliabilityOut) {
+        igraph_integer_t toVertexIndex, igraph_real_t* edgeLatencyOut, igraph_real_t* edgeReliabilityOut,
+        igraph_integer_t* edgeIndexOut) {
     MAGIC_ASSERT(top);
 
     igraph_integer_t edgeIndex = 0;
-
-#ifndef IGRAPH_VERSION
-    gint result = igraph_get_eid(&top->graph, &edgeIndex, fromVertexIndex, toVertexIndex, (igraph_bool_t)TRUE);
-#else
-    gint result = igraph_get_eid(&top->graph, &edgeIndex, fromVertexIndex, toVertexIndex, (igraph_bool_t)TRUE, (igraph_bool_t)TRUE);
-#endif
+    gint result = _topology_findEdge(top, fromVertexIndex, toVertexIndex, &edgeIndex);
 
     if(result != IGRAPH_SUCCESS) {
         return result;
     }
 
+    if(edgeIndexOut) {
+        *edgeIndexOut = edgeIndex;
+    }
+
     /* get edge properties from graph */
     if(edgeLatencyOut) {
         *edgeLatencyOut = EAN(&top->graph, "latency", edgeIndex);
@@ -583,6 +853,8 @@ static gboolean _topology_computeSourcePathsHelper(Topology* top, igraph_integer
     const gchar* dstIDStr = NULL;
     const gchar* srcIDStr = NULL;
     GString* pathString = g_string_new(NULL);
+    GArray* pathEdges = _topology_hasPendingEdgeChanges(top) ?
+            g_array_new(FALSE, FALSE, sizeof(igraph_integer_t)) : NULL;
 
     glong nVertices = igraph_vector_size(resultPathVertices);
 
@@ -628,13 +900,21 @@ static gboolean _topology_computeSourcePathsHelper(Topology* top, igraph_integer
 
             igraph_real_t edgeLatency = 0, edgeReliability = 0;
 
-            result = _topology_getEdgeHelper(top, fromVertexIndex, toVertexIndex, &edgeLatency, &edgeReliability);
+            result = _topology_getEdgeHelper(top, fromVertexIndex, toVertexIndex, &edgeLatency,
+                    &edgeReliability, &edgeIndex);
             if(result != IGRAPH_SUCCESS) {
                 _topology_unlockGraph(top);
                 critical("igraph_get_eid return non-success code %i for edge between "
                          "%s (%i) and %s (%i)", result, fromIDStr, (gint) fromVertexIndex, toIDStr, (gint) toVertexIndex);
+                g_string_free(pathString, TRUE);
+                if(pathEdges) {
+                    g_array_free(pathEdges, TRUE);
+                }
                 return FALSE;
             }
+            if(pathEdges) {
+                g_array_append_val(pathEdges, edgeIndex);
+            }
 
             /* accumulate path attributes */
             totalLatency += edgeLatency;
@@ -665,7 +945,11 @@ static gboolean _topology_computeSourcePathsHelper(Topology* top, igraph_integer
     g_string_free(pathString, TRUE);
 
     /* cache the latency and reliability we just computed */
-    _topology_storePathInCache(top, srcVertexIndex, dstVertexIndex, totalLatency, totalReliability);
+    _topology_storePathInCache(top, srcVertexIndex, dstVertexIndex, totalLatency, totalReliability, pathEdges);
+
+    if(pathEdges) {
+        g_array_free(pathEdges, TRUE);
+    }
 
     return TRUE;
 }
@@ -857,7 +1141,7 @@ static gboolean _topology_lookupPath(Topology* top, igraph_integer_t srcVertexIn
     totalReliability *= (1.0f - VAN(&top->graph, "packetloss", srcVertexIndex));
     totalReliability *= (1.0f - VAN(&top->graph, "packetloss", dstVertexIndex));
 
-    gint result = _topology_getEdgeHelper(top, srcVertexIndex, dstVertexIndex, &edgeLatency, &edgeReliability);
+    gint result = _topology_getEdgeHelper(top, srcVertexIndex, dstVertexIndex, &edgeLatency, &edgeReliability, NULL);
     if(result != IGRAPH_SUCCESS) {
         _topology_unlockGraph(top);
         critical("igraph_get_eid return non-success code %i for edge between "
@@ -870,31 +1154,104 @@ static gboolean _topology_lookupPath(Topology* top, igraph_integer_t srcVertexIn
     totalLatency += edgeLatency;
     totalReliability *= edgeReliability;
 
-    /* cache the latency and reliability we just computed */
-    _topology_storePathInCache(top, srcVertexIndex, dstVertexIndex, totalLatency, totalReliability);
+    /* cache the latency and reliability we just computed. in complete graphs, a changed
+     * edge only affects the path between its own vertices, so we need not track it */
+    _topology_storePathInCache(top, srcVertexIndex, dstVertexIndex, totalLatency, totalReliability, NULL);
 
     return TRUE;
 }
 
 
-static gboolean _topology_getPathEntry(Topology* top, Address* srcAddress, Address* dstAddress,
+/* loopback addresses share their host's index but are never attached to the topology */
+static guint _topology_getAddressHostIndex(Address* address) {
+    return address_isLocal(address) ? HOST_INDEX_INVALID : address_getHostIndex(address);
+}
+
+static igraph_integer_t _topology_getHostVertexIndex(Topology* top, guint hostIndex) {
+    igraph_integer_t vertexIndex = -1;
+    g_rw_lock_reader_lock(&(top->virtualIPLock));
+    if(hostIndex < top->hostVertices->len) {
+        vertexIndex = (igraph_integer_t) g_array_index(top->hostVertices, gint, hostIndex);
+    }
+    g_rw_lock_reader_unlock(&(top->virtualIPLock));
+    return vertexIndex;
+}
+
+/* returns the slot of this thread's local cache where the path between the hosts belongs */
+static TopologyLocalPath* _topology_getLocalPathSlot(Topology* top, guint srcHostIndex, guint dstHostIndex) {
+    TopologyLocalCache* cache = g_private_get(&topologyLocalCacheKey);
+    if(!cache) {
+        cache = g_new0(TopologyLocalCache, 1);
+        g_private_set(&topologyLocalCacheKey, cache);
+    }
+
+    /* the generation only changes while no worker is looking up paths */
+    gint generation = g_atomic_int_get(&(top->pathCacheGeneration));
+    if(cache->top != top || cache->generation != generation) {
+        for(guint i = 0; i < CONFIG_TOPOLOGY_LOCAL_CACHE_ENTRIES; i++) {
+            cache->paths[i].srcHostIndex = HOST_INDEX_INVALID;
+        }
+        cache->top = top;
+        cache->generation = generation;
+    }
+
+    guint slot = ((srcHostIndex * 2654435761u) ^ dstHostIndex) & (CONFIG_TOPOLOGY_LOCAL_CACHE_ENTRIES - 1);
+    return &(cache->paths[slot]);
+}
+
+static gboolean _topology_getLocalPath(TopologyLocalPath* localPath, guint srcHostIndex,
+        guint dstHostIndex, gdouble* latency, gdouble* reliability) {
+    if(localPath->srcHostIndex != srcHostIndex || localPath->dstHostIndex != dstHostIndex) {
+        return FALSE;
+    }
+    if(latency) {
+        *latency = localPath->latency;
+    }
+    if(reliability) {
+        *reliability = localPath->reliability;
+    }
+    return TRUE;
+}
+
+static void _topology_setLocalPath(TopologyLocalPath* localPath, guint srcHostIndex,
+        guint dstHostIndex, gdouble latency, gdouble reliability) {
+    localPath->srcHostIndex = srcHostIndex;
+    localPath->dstHostIndex = dstHostIndex;
+    localPath->latency = latency;
+    localPath->reliability = reliability;
+}
+
+/* the precomputed matrix answers without taking any locks */
+static gboolean _topology_getMatrixEntry(Topology* top, guint srcHostIndex, guint dstHostIndex,
         gdouble* latency, gdouble* reliability) {
-    MAGIC_ASSERT(top);
+    if(!top->pathMatrix || srcHostIndex >= top->hostMatrixIndicesLength ||
+            dstHostIndex >= top->hostMatrixIndicesLength) {
+        return FALSE;
+    }
 
-    /* get connected points */
-    igraph_integer_t srcVertexIndex = _topology_getConnectedVertexIndex(top, srcAddress);
-    if(srcVertexIndex < 0) {
-        critical("invalid vertex %i, source address %s is not connected to topology",
-                (gint)srcVertexIndex, address_toString(srcAddress));
+    gint srcIndex = top->hostMatrixIndices[srcHostIndex];
+    gint dstIndex = top->hostMatrixIndices[dstHostIndex];
+    if(srcIndex < 0 || dstIndex < 0) {
         return FALSE;
     }
-    igraph_integer_t dstVertexIndex = _topology_getConnectedVertexIndex(top, dstAddress);
-    if(dstVertexIndex < 0) {
-        critical("invalid vertex %i, destination address %s is not connected to topology",
-                (gint)dstVertexIndex, address_toString(dstAddress));
+
+    TopologyPathEntry* entry = &(top->pathMatrix[(srcIndex * top->pathMatrixSize) + dstIndex]);
+    if(entry->latency < 0) {
+        /* fall back to the cache, which logs the error if there is no path */
         return FALSE;
     }
 
+    if(latency) {
+        *latency = entry->latency;
+    }
+    if(reliability) {
+        *reliability = entry->reliability;
+    }
+    return TRUE;
+}
+
+static gboolean _topology_getVertexPathEntry(Topology* top, igraph_integer_t srcVertexIndex,
+        igraph_integer_t dstVertexIndex, gdouble* latency, gdouble* reliability) {
     /* check for a cache hit */
     Path* path = _topology_getPathFromCache(top, srcVertexIndex, dstVertexIndex);
     if(!path && !top->isDirected) {
@@ -925,10 +1282,8 @@ static gboolean _topology_getPathEntry(Topology* top, Address* srcAddress, Addre
         const gchar* dstIDStr = VAS(&top->graph, "id", dstVertexIndex);
         _topology_unlockGraph(top);
 
-        error("unable to find path between node %s at %s (vertex %i) "
-                "and node %s at %s (vertex %i)",
-                address_toString(srcAddress), srcIDStr, (gint)srcVertexIndex,
-                address_toString(dstAddress), dstIDStr, (gint)dstVertexIndex);
+        error("unable to find path between node %s (vertex %i) and node %s (vertex %i)",
+                srcIDStr, (gint)srcVertexIndex, dstIDStr, (gint)dstVertexIndex);
         return FALSE;
     }
 
@@ -941,6 +1296,56 @@ static gboolean _topology_getPathEntry(Topology* top, Address* srcAddress, Addre
     return TRUE;
 }
 
+static gboolean _topology_getPathEntry(Topology* top, Address* srcAddress, Address* dstAddress,
+        gdouble* latency, gdouble* reliability) {
+    MAGIC_ASSERT(top);
+
+    guint srcHostIndex = _topology_getAddressHostIndex(srcAddress);
+    guint dstHostIndex = _topology_getAddressHostIndex(dstAddress);
+    if(_topology_getMatrixEntry(top, srcHostIndex, dstHostIndex, latency, reliability)) {
+        return TRUE;
+    }
+
+    /* most hosts talk to few peers, so we probably looked this path up before */
+    TopologyLocalPath* localPath = NULL;
+    if(srcHostIndex != HOST_INDEX_INVALID && dstHostIndex != HOST_INDEX_INVALID) {
+        localPath = _topology_getLocalPathSlot(top, srcHostIndex, dstHostIndex);
+        if(_topology_getLocalPath(localPath, srcHostIndex, dstHostIndex, latency, reliability)) {
+            return TRUE;
+        }
+    }
+
+    /* get connected points */
+    igraph_integer_t srcVertexIndex = _topology_getConnectedVertexIndex(top, srcAddress);
+    if(srcVertexIndex < 0) {
+        critical("invalid vertex %i, source address %s is not connected to topology",
+                (gint)srcVertexIndex, address_toString(srcAddress));
+        return FALSE;
+    }
+    igraph_integer_t dstVertexIndex = _topology_getConnectedVertexIndex(top, dstAddress);
+    if(dstVertexIndex < 0) {
+        critical("invalid vertex %i, destination address %s is not connected to topology",
+                (gint)dstVertexIndex, address_toString(dstAddress));
+        return FALSE;
+    }
+
+    gdouble pathLatency = 0, pathReliability = 0;
+    if(!_topology_getVertexPathEntry(top, srcVertexIndex, dstVertexIndex, &pathLatency, &pathReliability)) {
+        return FALSE;
+    }
+    if(localPath) {
+        _topology_setLocalPath(localPath, srcHostIndex, dstHostIndex, pathLatency, pathReliability);
+    }
+
+    if(latency) {
+        *latency = pathLatency;
+    }
+    if(reliability) {
+        *reliability = pathReliability;
+    }
+    return TRUE;
+}
+
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress) {
     MAGIC_ASSERT(top);
     gdouble latency = 0;
@@ -961,136 +1366,1163 @@ gdouble topology_getReliability(Topology* top, Address* srcAddress, Address* dst
     }
 }
 
-gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAddress) {
+/* looks up both path properties at once. returns FALSE if there is no path. */
+gboolean topology_getPathInfo(Topology* top, Address* srcAddress, Address* dstAddress,
+        gdouble* latency, gdouble* reliability) {
     MAGIC_ASSERT(top);
-    return topology_getLatency(top, srcAddress, dstAddress) > -1;
+    return _topology_getPathEntry(top, srcAddress, dstAddress, latency, reliability);
 }
 
-static void _topology_findAttachmentVertexHelperHook(Topology* top, igraph_integer_t vertexIndex, AttachHelper* ah) {
+/* like topology_getPathInfo, but for the hosts with the given host indices */
+gboolean topology_getPathInfoByHostIndex(Topology* top, guint srcHostIndex, guint dstHostIndex,
+        gdouble* latency, gdouble* reliability) {
     MAGIC_ASSERT(top);
-    utility_assert(ah);
 
-    /* @warning: make sure we hold the graph lock when iterating with this helper
-     * @todo: this could be made much more efficient */
+    if(_topology_getMatrixEntry(top, srcHostIndex, dstHostIndex, latency, reliability)) {
+        return TRUE;
+    }
 
-    const gchar* idStr = VAS(&top->graph, "id", vertexIndex);
+    /* most hosts talk to few peers, so we probably looked this path up before */
+    TopologyLocalPath* localPath = _topology_getLocalPathSlot(top, srcHostIndex, dstHostIndex);
+    if(_topology_getLocalPath(localPath, srcHostIndex, dstHostIndex, latency, reliability)) {
+        return TRUE;
+    }
 
-    if(g_strstr_len(idStr, (gssize)-1, "poi")) {
-        /* first check the IP address */
-        const gchar* ipStr = VAS(&top->graph, "ip", vertexIndex);
-        in_addr_t vertexIP = address_stringToIP(ipStr);
+    igraph_integer_t srcVertexIndex = _topology_getHostVertexIndex(top, srcHostIndex);
+    if(srcVertexIndex < 0) {
+        critical("invalid vertex %i, source host %u is not connected to topology",
+                (gint)srcVertexIndex, srcHostIndex);
+        return FALSE;
+    }
+    igraph_integer_t dstVertexIndex = _topology_getHostVertexIndex(top, dstHostIndex);
+    if(dstVertexIndex < 0) {
+        critical("invalid vertex %i, destination host %u is not connected to topology",
+                (gint)dstVertexIndex, dstHostIndex);
+        return FALSE;
+    }
 
-        gboolean vertexHasUsableIP = FALSE;
-        if(vertexIP != INADDR_NONE && vertexIP != INADDR_ANY) {
-            vertexHasUsableIP = TRUE;
-        }
-
-        /* check for exact IP address match */
-        if(ah->ipHint && ah->requestedIP != INADDR_NONE && ah->requestedIP != INADDR_ANY) {
-            if(vertexIP == ah->requestedIP) {
-                if(!ah->foundExactIPMatch) {
-                    /* first time we found a match, clear all queues to make sure we only
-                     * select from the matching IP vertices */
-                    g_queue_clear(ah->candidatesAll);
-                    g_queue_clear(ah->candidatesType);
-                    g_queue_clear(ah->candidatesCode);
-                    g_queue_clear(ah->candidatesTypeCode);
-                }
-                ah->foundExactIPMatch = TRUE;
-                g_queue_push_tail(ah->candidatesAll, GINT_TO_POINTER(vertexIndex));
-                if(vertexHasUsableIP) {
-                    ah->numCandidatesAllIPs++;
+    gdouble pathLatency = 0, pathReliability = 0;
+    if(!_topology_getVertexPathEntry(top, srcVertexIndex, dstVertexIndex, &pathLatency, &pathReliability)) {
+        return FALSE;
+    }
+    _topology_setLocalPath(localPath, srcHostIndex, dstHostIndex, pathLatency, pathReliability);
+
+    if(latency) {
+        *latency = pathLatency;
+    }
+    if(reliability) {
+        *reliability = pathReliability;
+    }
+    return TRUE;
+}
+
+/* fills links with the ids of the bandwidth limited links on the path between the hosts,
+ * from the destination back to the source. links is left empty if the path crosses none. */
+void topology_getPathLinks(Topology* top, guint srcHostIndex, guint dstHostIndex, GArray* links) {
+    MAGIC_ASSERT(top);
+    utility_assert(links);
+
+    g_array_set_size(links, 0);
+
+    if(!top->pathLinks || srcHostIndex >= top->hostMatrixIndicesLength ||
+            dstHostIndex >= top->hostMatrixIndicesLength) {
+        return;
+    }
+
+    gint srcIndex = top->hostMatrixIndices[srcHostIndex];
+    gint dstIndex = top->hostMatrixIndices[dstHostIndex];
+    if(srcIndex < 0 || dstIndex < 0) {
+        return;
+    }
+
+    const TopologyPathLink* nodes = (const TopologyPathLink*) top->pathLinkRows[srcIndex]->data;
+    guint node = top->pathLinks[(srcIndex * top->pathMatrixSize) + dstIndex];
+    while(node != 0) {
+        g_array_append_val(links, nodes[node].link);
+        node = nodes[node].previous;
+    }
+}
+
+guint topology_getLinkCount(Topology* top) {
+    MAGIC_ASSERT(top);
+    return top->linkCount;
+}
+
+/* the bandwidths of the links in KiB/s, indexed by link id */
+const gdouble* topology_getLinkBandwidths(Topology* top) {
+    MAGIC_ASSERT(top);
+    return top->linkBandwidths;
+}
+
+gdouble topology_getMinimumPathLatency(Topology* top) {
+    MAGIC_ASSERT(top);
+    g_rw_lock_reader_lock(&(top->pathCacheLock));
+    gdouble minLatency = top->minimumPathLatency;
+    g_rw_lock_reader_unlock(&(top->pathCacheLock));
+    return minLatency;
+}
+
+/* fills the nPartitions x nPartitions matrix latencies with the lowest latency of any path
+ * from a host in the row partition to a host in the column partition, or with a negative
+ * value if there is no such path. hostPartitions holds the partition plus one of each host
+ * by host index, or 0 if the host has none. returns FALSE if the paths are not precomputed. */
+gboolean topology_getPartitionLatencies(Topology* top, const guint* hostPartitions, guint nHosts,
+        guint nPartitions, gdouble* latencies) {
+    MAGIC_ASSERT(top);
+    utility_assert(nPartitions > 0 && latencies);
+
+    if(!top->pathMatrix) {
+        return FALSE;
+    }
+
+    guint n = top->pathMatrixSize;
+
+    /* many hosts share a vertex, so list the partitions with hosts at each row once */
+    gboolean* isMember = g_new0(gboolean, (gsize)n * nPartitions);
+    guint nMembers = 0;
+    for(guint hostIndex = 0; hostIndex < MIN(nHosts, top->hostMatrixIndicesLength); hostIndex++) {
+        gint row = top->hostMatrixIndices[hostIndex];
+        guint partition = hostPartitions[hostIndex];
+        if(row < 0 || partition == 0) {
+            continue;
+        }
+        utility_assert(partition <= nPartitions);
+        gboolean* member = &(isMember[((gsize)row * nPartitions) + partition - 1]);
+        if(!*member) {
+            *member = TRUE;
+            nMembers++;
+        }
+    }
+
+    guint* memberOffsets = g_new(guint, n + 1);
+    guint* members = g_new(guint, MAX(nMembers, 1));
+    memberOffsets[0] = 0;
+    for(guint row = 0; row < n; row++) {
+        guint next = memberOffsets[row];
+        for(guint partition = 0; partition < nPartitions; partition++) {
+            if(isMember[((gsize)row * nPartitions) + partition]) {
+                members[next++] = partition;
+            }
+        }
+        memberOffsets[row + 1] = next;
+    }
+    g_free(isMember);
+
+    for(guint i = 0; i < nPartitions * nPartitions; i++) {
+        latencies[i] = -1;
+    }
+
+    /* the closest host of each partition from the current row */
+    gdouble* rowLatencies = g_new(gdouble, nPartitions);
+
+    for(guint row = 0; row < n; row++) {
+        if(memberOffsets[row] == memberOffsets[row + 1]) {
+            continue;
+        }
+
+        for(guint partition = 0; partition < nPartitions; partition++) {
+            rowLatencies[partition] = -1;
+        }
+
+        TopologyPathEntry* entries = &(top->pathMatrix[(gsize)row * n]);
+        for(guint col = 0; col < n; col++) {
+            gdouble latency = entries[col].latency;
+            if(latency < 0) {
+                continue;
+            }
+            for(guint i = memberOffsets[col]; i < memberOffsets[col + 1]; i++) {
+                gdouble* closest = &(rowLatencies[members[i]]);
+                if(*closest < 0 || latency < *closest) {
+                    *closest = latency;
                 }
             }
         }
 
-        /* if it matches the requested IP exactly, we ignore other the filters */
-        if(ah->foundExactIPMatch) {
-            return;
+        for(guint i = memberOffsets[row]; i < memberOffsets[row + 1]; i++) {
+            gdouble* partitionLatencies = &(latencies[members[i] * nPartitions]);
+            for(guint partition = 0; partition < nPartitions; partition++) {
+                gdouble latency = rowLatencies[partition];
+                if(latency >= 0 && (partitionLatencies[partition] < 0 || latency < partitionLatencies[partition])) {
+                    partitionLatencies[partition] = latency;
+                }
+            }
         }
+    }
 
-        const gchar* typeStr = VAS(&top->graph, "type", vertexIndex);
-        const gchar* geocodeStr = VAS(&top->graph, "geocode", vertexIndex);
+    g_free(rowLatencies);
+    g_free(members);
+    g_free(memberOffsets);
+
+    return TRUE;
+}
+
+/* a private read-only copy of the graph in compressed sparse row form, so that
+ * several threads can run dijkstra at the same time without the graph lock */
+struct _TopologyAdjacency {
+    guint nVertices;
+    /* the outgoing edges of vertex v are at positions offsets[v] to offsets[v+1]-1 */
+    guint* offsets;
+    guint* sources;
+    guint* targets;
+    gdouble* latencies;
+    gdouble* reliabilities;
+    /* one minus the packet loss of each vertex */
+    gdouble* vertexReliabilities;
+    /* the arcs of each edge, at 2*edge and 2*edge+1, or TOPOLOGY_ARC_NONE */
+    guint* edgeArcs;
+    /* the link of each arc or -1, NULL if no edge has a bandwidth. each direction of
+     * an undirected edge is its own link. */
+    gint* arcLinks;
+    gdouble* linkBandwidths;
+    guint nLinks;
+};
+
+/* returns the id of a new link with the given bandwidth, or -1 if it is not limited */
+static gint _topology_addAdjacencyLink(TopologyAdjacency* adj, gdouble bandwidth) {
+    if(!(bandwidth > 0)) {
+        return -1;
+    }
+    adj->linkBandwidths[adj->nLinks] = bandwidth;
+    return (gint) adj->nLinks++;
+}
+
+static TopologyAdjacency* _topology_copyAdjacency(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    _topology_lockGraph(top);
+    g_rw_lock_reader_lock(&(top->edgeWeightsLock));
+
+    guint nVertices = (guint) igraph_vcount(&top->graph);
+    guint nEdges = (guint) igraph_ecount(&top->graph);
+
+    igraph_integer_t* froms = g_new(igraph_integer_t, nEdges);
+    igraph_integer_t* tos = g_new(igraph_integer_t, nEdges);
+
+    TopologyAdjacency* adj = g_new0(TopologyAdjacency, 1);
+    adj->nVertices = nVertices;
+    adj->offsets = g_new0(guint, nVertices + 1);
+    adj->vertexReliabilities = g_new(gdouble, nVertices);
+
+    for(guint v = 0; v < nVertices; v++) {
+        adj->vertexReliabilities[v] = 1.0f - VAN(&top->graph, "packetloss", (igraph_integer_t)v);
+    }
+
+    /* count the out degree of every vertex, undirected edges go both ways */
+    for(guint e = 0; e < nEdges; e++) {
+        igraph_edge(&top->graph, (igraph_integer_t)e, &froms[e], &tos[e]);
+        adj->offsets[froms[e] + 1]++;
+        if(!top->isDirected && froms[e] != tos[e]) {
+            adj->offsets[tos[e] + 1]++;
+        }
+    }
+    for(guint v = 0; v < nVertices; v++) {
+        adj->offsets[v + 1] += adj->offsets[v];
+    }
+
+    guint nArcs = adj->offsets[nVertices];
+    adj->sources = g_new(guint, nArcs);
+    adj->targets = g_new(guint, nArcs);
+    adj->latencies = g_new(gdouble, nArcs);
+    adj->reliabilities = g_new(gdouble, nArcs);
+    adj->edgeArcs = g_new(guint, 2 * nEdges);
+
+    gboolean hasBandwidths = igraph_cattribute_has_attr(&top->graph, IGRAPH_ATTRIBUTE_EDGE, "bandwidth");
+    if(hasBandwidths) {
+        adj->arcLinks = g_new(gint, nArcs);
+        adj->linkBandwidths = g_new(gdouble, nArcs);
+    }
+
+    /* fill in edge order, so each vertex lists its edges with the lowest ids first */
+    guint* next = g_memdup(adj->offsets, nVertices * sizeof(guint));
+    for(guint e = 0; e < nEdges; e++) {
+        gdouble latency = (gdouble) igraph_vector_e(top->edgeWeights, (glong)e);
+        gdouble reliability = 1.0f - EAN(&top->graph, "packetloss", (igraph_integer_t)e);
+
+        guint arc = next[froms[e]]++;
+        adj->sources[arc] = (guint) froms[e];
+        adj->targets[arc] = (guint) tos[e];
+        adj->latencies[arc] = latency;
+        adj->reliabilities[arc] = reliability;
+        adj->edgeArcs[2 * e] = arc;
+        adj->edgeArcs[(2 * e) + 1] = TOPOLOGY_ARC_NONE;
+
+        /* missing and non-positive bandwidths mean the edge is not limited */
+        gdouble bandwidth = hasBandwidths ? EAN(&top->graph, "bandwidth", (igraph_integer_t)e) : 0;
+        if(hasBandwidths) {
+            adj->arcLinks[arc] = _topology_addAdjacencyLink(adj, bandwidth);
+        }
+
+        if(!top->isDirected && froms[e] != tos[e]) {
+            arc = next[tos[e]]++;
+            adj->sources[arc] = (guint) tos[e];
+            adj->targets[arc] = (guint) froms[e];
+            adj->latencies[arc] = latency;
+            adj->reliabilities[arc] = reliability;
+            adj->edgeArcs[(2 * e) + 1] = arc;
+            if(hasBandwidths) {
+                adj->arcLinks[arc] = _topology_addAdjacencyLink(adj, bandwidth);
+            }
+        }
+    }
+
+    g_rw_lock_reader_unlock(&(top->edgeWeightsLock));
+    _topology_unlockGraph(top);
+
+    g_free(next);
+    g_free(froms);
+    g_free(tos);
+
+    return adj;
+}
+
+static void _topology_freeAdjacency(TopologyAdjacency* adj) {
+    g_free(adj->offsets);
+    g_free(adj->sources);
+    g_free(adj->targets);
+    g_free(adj->latencies);
+    g_free(adj->reliabilities);
+    g_free(adj->vertexReliabilities);
+    g_free(adj->edgeArcs);
+    g_free(adj->arcLinks);
+    g_free(adj->linkBandwidths);
+    g_free(adj);
+}
+
+/* the state of one thread computing rows of the path matrix */
+typedef struct _TopologyPathSearch TopologyPathSearch;
+struct _TopologyPathSearch {
+    Topology* top;
+    TopologyAdjacency* adj;
+    /* the vertex of each matrix index, and the matrix index of each vertex or -1 */
+    const guint* vertices;
+    const gint* matrixIndices;
+    /* the rows to compute, or NULL for all of them. shared by all threads, the position
+     * of the next row that needs computing */
+    const guint* rows;
+    guint nRows;
+    volatile gint* nextRow;
+
+    /* private dijkstra state */
+    gdouble* distances;
+    gdouble* pathReliabilities;
+    gboolean* isSettled;
+    guint* parentArcs;
+    /* the node of the last link on the path to each settled vertex in the row's node storage */
+    guint* vertexLinks;
+    gint* directArcs;
+    gdouble* heapDistances;
+    guint* heapVertices;
+    guint heapSize;
+
+    gdouble minLatency;
+};
+
+static void _topology_heapPush(TopologyPathSearch* search, gdouble distance, guint vertex) {
+    guint i = search->heapSize++;
+    while(i > 0) {
+        guint parent = (i - 1) / 2;
+        if(search->heapDistances[parent] <= distance) {
+            break;
+        }
+        search->heapDistances[i] = search->heapDistances[parent];
+        search->heapVertices[i] = search->heapVertices[parent];
+        i = parent;
+    }
+    search->heapDistances[i] = distance;
+    search->heapVertices[i] = vertex;
+}
+
+static guint _topology_heapPop(TopologyPathSearch* search) {
+    guint top = search->heapVertices[0];
+    guint n = --search->heapSize;
+    gdouble distance = search->heapDistances[n];
+    guint vertex = search->heapVertices[n];
+
+    guint i = 0;
+    while(TRUE) {
+        guint child = (2 * i) + 1;
+        if(child >= n) {
+            break;
+        }
+        if(child + 1 < n && search->heapDistances[child + 1] < search->heapDistances[child]) {
+            child++;
+        }
+        if(distance <= search->heapDistances[child]) {
+            break;
+        }
+        search->heapDistances[i] = search->heapDistances[child];
+        search->heapVertices[i] = search->heapVertices[child];
+        i = child;
+    }
+    search->heapDistances[i] = distance;
+    search->heapVertices[i] = vertex;
+
+    return top;
+}
+
+static void _topology_setMatrixEntry(TopologyPathSearch* search, guint row, guint col,
+        gdouble latency, gdouble reliability) {
+    TopologyPathEntry* entry = &(search->top->pathMatrix[(row * search->top->pathMatrixSize) + col]);
+    entry->latency = latency;
+    entry->reliability = reliability;
+    search->minLatency = MIN(search->minLatency, latency);
+}
+
+/* appends a node for the arc's link after the node parentNode to the row's node storage,
+ * and returns the new node. parentNode is returned as is if the arc is not limited. */
+static guint _topology_appendPathLink(TopologyPathSearch* search, guint row, guint parentNode,
+        guint arc) {
+    gint link = search->adj->arcLinks[arc];
+    if(link < 0) {
+        return parentNode;
+    }
+
+    GArray* nodes = search->top->pathLinkRows[row];
+    TopologyPathLink pathLink = {(guint) link, parentNode};
+    g_array_append_val(nodes, pathLink);
 
-        gboolean typeMatches = ah->typeHint && !g_ascii_strcasecmp(typeStr, ah->typeHint);
-        gboolean codeMatches = ah->geocodeHint && !g_ascii_strcasecmp(geocodeStr, ah->geocodeHint);
+    return nodes->len - 1;
+}
+
+static void _topology_setPathLinks(TopologyPathSearch* search, guint row, guint col, guint node) {
+    search->top->pathLinks[(row * search->top->pathMatrixSize) + col] = node;
+}
 
-        g_queue_push_tail(ah->candidatesAll, GINT_TO_POINTER(vertexIndex));
-        if(vertexHasUsableIP) {
-            ah->numCandidatesAllIPs++;
+/* a path from a vertex to itself uses a self loop if there is one, see
+ * _topology_computeSourcePathsHelper */
+static void _topology_computeSelfPath(TopologyPathSearch* search, guint row, guint src) {
+    TopologyAdjacency* adj = search->adj;
+    gdouble latency = 1.0, reliability = adj->vertexReliabilities[src];
+
+    for(guint arc = adj->offsets[src]; arc < adj->offsets[src + 1]; arc++) {
+        if(adj->targets[arc] == src) {
+            latency = adj->latencies[arc];
+            reliability *= adj->reliabilities[arc];
+            if(search->top->pathLinks) {
+                _topology_setPathLinks(search, row, row, _topology_appendPathLink(search, row, 0, arc));
+            }
+            break;
         }
-        if(typeMatches && ah->candidatesType) {
-            g_queue_push_tail(ah->candidatesType, GINT_TO_POINTER(vertexIndex));
-            if(vertexHasUsableIP) {
-                ah->numCandidatesTypeIPs++;
+    }
+
+    _topology_setMatrixEntry(search, row, row, latency, reliability);
+}
+
+/* complete graphs use the direct edge as the path, see _topology_lookupPath */
+static void _topology_computeDirectPaths(TopologyPathSearch* search, guint row) {
+    TopologyAdjacency* adj = search->adj;
+    guint src = search->vertices[row];
+
+    /* remember the first edge to each neighbor, like igraph_get_eid */
+    for(guint arc = adj->offsets[src + 1]; arc > adj->offsets[src]; arc--) {
+        search->directArcs[adj->targets[arc - 1]] = (gint)(arc - 1);
+    }
+
+    for(guint col = 0; col < search->top->pathMatrixSize; col++) {
+        guint dst = search->vertices[col];
+        gint arc = search->directArcs[dst];
+        if(arc >= 0) {
+            gdouble reliability = adj->vertexReliabilities[src] * adj->vertexReliabilities[dst] *
+                    adj->reliabilities[arc];
+            _topology_setMatrixEntry(search, row, col, adj->latencies[arc], reliability);
+            if(search->top->pathLinks) {
+                _topology_setPathLinks(search, row, col, _topology_appendPathLink(search, row, 0, (guint)arc));
             }
         }
-        if(codeMatches && ah->candidatesCode) {
-            g_queue_push_tail(ah->candidatesCode, GINT_TO_POINTER(vertexIndex));
-            if(vertexHasUsableIP) {
-                ah->numCandidatesCodeIPs++;
+    }
+
+    for(guint arc = adj->offsets[src]; arc < adj->offsets[src + 1]; arc++) {
+        search->directArcs[adj->targets[arc]] = -1;
+    }
+}
+
+/* dijkstra from the row's vertex until all attached vertices are settled, see
+ * _topology_computeSourcePathsHelper for how loss is accumulated */
+static void _topology_computeShortestPaths(TopologyPathSearch* search, guint row) {
+    TopologyAdjacency* adj = search->adj;
+    guint src = search->vertices[row];
+
+    /* remember the tree if we will need to know which edges the row depends on */
+    guint* tree = search->top->pathTrees ?
+            &(search->top->pathTrees[(gsize)row * adj->nVertices]) : NULL;
+
+    for(guint v = 0; v < adj->nVertices; v++) {
+        search->distances[v] = G_MAXDOUBLE;
+        search->isSettled[v] = FALSE;
+        if(tree) {
+            tree[v] = TOPOLOGY_ARC_NONE;
+        }
+    }
+
+    search->heapSize = 0;
+    search->distances[src] = 0;
+    search->pathReliabilities[src] = adj->vertexReliabilities[src];
+    search->parentArcs[src] = TOPOLOGY_ARC_SOURCE;
+    _topology_heapPush(search, 0, src);
+
+    _topology_computeSelfPath(search, row, src);
+    guint nRemaining = search->top->pathMatrixSize - 1;
+
+    while(search->heapSize > 0 && nRemaining > 0) {
+        guint u = _topology_heapPop(search);
+        if(search->isSettled[u]) {
+            continue;
+        }
+        search->isSettled[u] = TRUE;
+        if(tree) {
+            tree[u] = search->parentArcs[u];
+        }
+
+        /* a vertex's links are the links of its parent, plus the arc from the parent */
+        if(search->top->pathLinks) {
+            guint arc = search->parentArcs[u];
+            search->vertexLinks[u] = (u == src) ? 0 :
+                    _topology_appendPathLink(search, row, search->vertexLinks[adj->sources[arc]], arc);
+        }
+
+        gint col = search->matrixIndices[u];
+        if(col >= 0 && u != src) {
+            gdouble latency = search->distances[u] > 0 ? search->distances[u] : 1.0;
+            gdouble reliability = search->pathReliabilities[u] * adj->vertexReliabilities[u];
+            _topology_setMatrixEntry(search, row, (guint)col, latency, reliability);
+            if(search->top->pathLinks) {
+                _topology_setPathLinks(search, row, (guint)col, search->vertexLinks[u]);
             }
+            nRemaining--;
         }
-        if(typeMatches && codeMatches && ah->candidatesTypeCode) {
-            g_queue_push_tail(ah->candidatesTypeCode, GINT_TO_POINTER(vertexIndex));
-            if(vertexHasUsableIP) {
-                ah->numCandidatesTypeCodeIPs++;
+
+        for(guint arc = adj->offsets[u]; arc < adj->offsets[u + 1]; arc++) {
+            guint v = adj->targets[arc];
+            gdouble distance = search->distances[u] + adj->latencies[arc];
+            if(!search->isSettled[v] && distance < search->distances[v]) {
+                search->distances[v] = distance;
+                search->pathReliabilities[v] = search->pathReliabilities[u] * adj->reliabilities[arc];
+                search->parentArcs[v] = arc;
+                _topology_heapPush(search, distance, v);
             }
         }
     }
 }
 
-static igraph_integer_t* _topology_getLongestPrefixMatch(Topology* top, GQueue* vertexSet, in_addr_t ip) {
+static gpointer _topology_runPathSearch(TopologyPathSearch* search) {
+    TopologyAdjacency* adj = search->adj;
+    guint nArcs = adj->offsets[adj->nVertices];
+
+    search->distances = g_new(gdouble, adj->nVertices);
+    search->pathReliabilities = g_new(gdouble, adj->nVertices);
+    search->isSettled = g_new(gboolean, adj->nVertices);
+    search->parentArcs = g_new(guint, adj->nVertices);
+    search->vertexLinks = g_new0(guint, adj->nVertices);
+    search->directArcs = g_new(gint, adj->nVertices);
+    for(guint v = 0; v < adj->nVertices; v++) {
+        search->directArcs[v] = -1;
+    }
+    /* every arc pushes at most one entry, plus the source */
+    search->heapDistances = g_new(gdouble, nArcs + 1);
+    search->heapVertices = g_new(guint, nArcs + 1);
+    search->minLatency = G_MAXDOUBLE;
+
+    guint nRows = search->rows ? search->nRows : search->top->pathMatrixSize;
+    guint position;
+    while((position = (guint) g_atomic_int_add(search->nextRow, 1)) < nRows) {
+        guint row = search->rows ? search->rows[position] : position;
+
+        /* entries we do not set have no path */
+        TopologyPathEntry* entries = &(search->top->pathMatrix[row * search->top->pathMatrixSize]);
+        for(guint col = 0; col < search->top->pathMatrixSize; col++) {
+            entries[col].latency = -1;
+            entries[col].reliability = 0;
+        }
+        if(search->top->pathLinks) {
+            memset(&(search->top->pathLinks[row * search->top->pathMatrixSize]), 0,
+                    search->top->pathMatrixSize * sizeof(guint));
+            g_array_set_size(search->top->pathLinkRows[row], 1);
+        }
+
+        if(search->top->isComplete) {
+            _topology_computeDirectPaths(search, row);
+        } else {
+            _topology_computeShortestPaths(search, row);
+        }
+    }
+
+    g_free(search->distances);
+    g_free(search->pathReliabilities);
+    g_free(search->isSettled);
+    g_free(search->parentArcs);
+    g_free(search->vertexLinks);
+    g_free(search->directArcs);
+    g_free(search->heapDistances);
+    g_free(search->heapVertices);
+
+    return NULL;
+}
+
+/* computes the given rows of the path matrix, or all of them if rows is NULL, using
+ * nThreads threads. returns the minimum latency of the computed paths. */
+static gdouble _topology_runPathSearches(Topology* top, TopologyAdjacency* adj, const guint* vertices,
+        const gint* matrixIndices, const guint* rows, guint nRows, guint nThreads) {
+    nThreads = MAX(1, MIN(nThreads, nRows));
+
+    /* each thread takes the next row that nobody computed yet, and only writes to that row */
+    volatile gint nextRow = 0;
+    TopologyPathSearch* searches = g_new0(TopologyPathSearch, nThreads);
+    GThread** threads = g_new0(GThread*, nThreads);
+
+    for(guint i = 0; i < nThreads; i++) {
+        searches[i].top = top;
+        searches[i].adj = adj;
+        searches[i].vertices = vertices;
+        searches[i].matrixIndices = matrixIndices;
+        searches[i].rows = rows;
+        searches[i].nRows = nRows;
+        searches[i].nextRow = &nextRow;
+        /* we do our share of the work in this thread */
+        if(i > 0) {
+            threads[i] = g_thread_new("topology-paths", (GThreadFunc)_topology_runPathSearch, &searches[i]);
+        }
+    }
+    _topology_runPathSearch(&searches[0]);
+
+    gdouble minLatency = G_MAXDOUBLE;
+    for(guint i = 0; i < nThreads; i++) {
+        if(threads[i]) {
+            g_thread_join(threads[i]);
+        }
+        minLatency = MIN(minLatency, searches[i].minLatency);
+    }
+
+    g_free(threads);
+    g_free(searches);
+
+    return minLatency;
+}
+
+/* this is what storing the paths in the cache would have done */
+static void _topology_reduceMinimumPathLatency(Topology* top, gdouble minLatency) {
+    g_rw_lock_writer_lock(&(top->pathCacheLock));
+    if(minLatency < G_MAXDOUBLE && (top->minimumPathLatency == 0 || minLatency < top->minimumPathLatency)) {
+        top->minimumPathLatency = minLatency;
+    }
+    g_rw_lock_writer_unlock(&(top->pathCacheLock));
+}
+
+/* computes the paths between all attached vertices using nThreads threads, so that lookups
+ * no longer need locks. this must be called after all hosts are attached and before any
+ * worker runs. */
+void topology_precomputePaths(Topology* top, guint nThreads) {
     MAGIC_ASSERT(top);
-    utility_assert(vertexSet);
+    utility_assert(top->pathMatrix == NULL);
+
+    /* hosts are often attached to the same vertices, so we only need a row for each vertex */
+    GHashTable* vertexToIndex = g_hash_table_new(g_direct_hash, g_direct_equal);
+    top->hostMatrixIndicesLength = top->hostVertices->len;
+    top->hostMatrixIndices = g_new(gint, top->hostMatrixIndicesLength);
+
+    for(guint hostIndex = 0; hostIndex < top->hostVertices->len; hostIndex++) {
+        gint vertex = g_array_index(top->hostVertices, gint, hostIndex);
+        if(vertex < 0) {
+            top->hostMatrixIndices[hostIndex] = -1;
+            continue;
+        }
+        gpointer indexPtr = g_hash_table_lookup(vertexToIndex, GINT_TO_POINTER(vertex));
+        if(!indexPtr) {
+            indexPtr = GUINT_TO_POINTER(g_hash_table_size(vertexToIndex) + 1);
+            g_hash_table_replace(vertexToIndex, GINT_TO_POINTER(vertex), indexPtr);
+        }
+        top->hostMatrixIndices[hostIndex] = GPOINTER_TO_INT(indexPtr) - 1;
+    }
 
-    /* @warning: this empties the candidate queue */
+    guint n = g_hash_table_size(vertexToIndex);
+    if(n == 0 || n > CONFIG_TOPOLOGY_MATRIX_MAX_VERTICES) {
+        if(n > 0) {
+            message("not precomputing paths between %u attached vertices, the limit is %u; "
+                    "paths will be computed on demand", n, (guint)CONFIG_TOPOLOGY_MATRIX_MAX_VERTICES);
+            if(igraph_cattribute_has_attr(&top->graph, IGRAPH_ATTRIBUTE_EDGE, "bandwidth")) {
+                warning("edge bandwidths are only modeled for precomputed paths and will be ignored");
+            }
+        }
+        g_hash_table_destroy(vertexToIndex);
+        g_free(top->hostMatrixIndices);
+        top->hostMatrixIndices = NULL;
+        top->hostMatrixIndicesLength = 0;
+        return;
+    }
 
-    in_addr_t bestMatch = 0;
-    in_addr_t bestIP = 0;
-    igraph_integer_t* bestVertexIndexPtr = GINT_TO_POINTER(-1);
+    GTimer* timer = g_timer_new();
+    TopologyAdjacency* adj = _topology_copyAdjacency(top);
+
+    guint* vertices = g_new(guint, n);
+    gint* matrixIndices = g_new(gint, adj->nVertices);
+    for(guint v = 0; v < adj->nVertices; v++) {
+        matrixIndices[v] = -1;
+    }
+    GHashTableIter iter;
+    gpointer vertexKey, indexValue;
+    g_hash_table_iter_init(&iter, vertexToIndex);
+    while(g_hash_table_iter_next(&iter, &vertexKey, &indexValue)) {
+        guint index = GPOINTER_TO_UINT(indexValue) - 1;
+        vertices[index] = (guint) GPOINTER_TO_INT(vertexKey);
+        matrixIndices[vertices[index]] = (gint) index;
+    }
+    g_hash_table_destroy(vertexToIndex);
+
+    top->pathMatrixSize = n;
+    top->pathMatrix = g_new(TopologyPathEntry, n * n);
+
+    /* the searches record which links each path crosses */
+    if(adj->nLinks > 0) {
+        top->linkCount = adj->nLinks;
+        top->linkBandwidths = g_memdup(adj->linkBandwidths, adj->nLinks * sizeof(gdouble));
+        top->pathLinks = g_new0(guint, n * n);
+        top->pathLinkRows = g_new(GArray*, n);
+        for(guint row = 0; row < n; row++) {
+            top->pathLinkRows[row] = g_array_new(FALSE, TRUE, sizeof(TopologyPathLink));
+            g_array_set_size(top->pathLinkRows[row], 1);
+        }
+        message("modeling queues on %u bandwidth limited links", top->linkCount);
+    }
 
-    while(!g_queue_is_empty(vertexSet)) {
-        igraph_integer_t* vertexIndexPtr = g_queue_pop_head(vertexSet);
-        igraph_integer_t vertexIndex = (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPtr);
-        _topology_lockGraph(top);
-        const gchar* ipStr = VAS(&top->graph, "ip", vertexIndex);
-        _topology_unlockGraph(top);
-        in_addr_t vertexIP = address_stringToIP(ipStr);
+    /* if edges will change, the trees tell us which rows a change affects */
+    gboolean keepSearchState = _topology_hasPendingEdgeChanges(top);
+    if(keepSearchState && !top->isComplete) {
+        guint64 nTreeEntries = ((guint64)n) * adj->nVertices;
+        if(nTreeEntries <= CONFIG_TOPOLOGY_PATH_TREE_MAX_ENTRIES) {
+            top->pathTrees = g_new(guint, nTreeEntries);
+        } else {
+            message("not storing %"G_GUINT64_FORMAT" shortest path tree entries, the limit is %u; "
+                    "all paths will be recomputed when an edge changes",
+                    nTreeEntries, (guint)CONFIG_TOPOLOGY_PATH_TREE_MAX_ENTRIES);
+        }
+    }
+
+    nThreads = MAX(1, MIN(nThreads, n));
+    message("precomputing paths between %u attached vertices using %u threads", n, nThreads);
+
+    gdouble minLatency = _topology_runPathSearches(top, adj, vertices, matrixIndices, NULL, n, nThreads);
+    _topology_reduceMinimumPathLatency(top, minLatency);
 
-        in_addr_t match = (vertexIP & ip);
-        if(match > bestMatch) {
-            bestMatch = match;
-            bestIP = vertexIP;
-            bestVertexIndexPtr = vertexIndexPtr;
+    g_mutex_lock(&top->topologyLock);
+    top->shortestPathTotalTime += g_timer_elapsed(timer, NULL);
+    top->shortestPathCount += n;
+    g_mutex_unlock(&top->topologyLock);
+
+    message("precomputed %u paths in %f seconds", n * n, g_timer_elapsed(timer, NULL));
+
+    g_timer_destroy(timer);
+
+    if(keepSearchState) {
+        top->matrixAdjacency = adj;
+        top->matrixVertices = vertices;
+        top->matrixRows = matrixIndices;
+        top->pathSearchThreads = nThreads;
+    } else {
+        g_free(matrixIndices);
+        g_free(vertices);
+        _topology_freeAdjacency(adj);
+    }
+}
+
+static igraph_integer_t _topology_findVertexByID(Topology* top, const gchar* vertexID) {
+    _topology_lockGraph(top);
+    if(!top->vertexIDs) {
+        top->vertexIDs = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        igraph_integer_t nVertices = igraph_vcount(&top->graph);
+        for(igraph_integer_t v = 0; v < nVertices; v++) {
+            const gchar* idStr = VAS(&top->graph, "id", v);
+            g_hash_table_replace(top->vertexIDs, g_strdup(idStr), GINT_TO_POINTER(v + 1));
         }
     }
+    _topology_unlockGraph(top);
 
-    return bestVertexIndexPtr;
+    return (igraph_integer_t) GPOINTER_TO_INT(g_hash_table_lookup(top->vertexIDs, vertexID)) - 1;
 }
 
-static igraph_integer_t _topology_findAttachmentVertex(Topology* top, Random* randomSourcePool,
-        in_addr_t nodeIP, gchar* ipHint, gchar* geocodeHint, gchar* typeHint) {
+/* schedules a change to the latency and/or packet loss of the edge between the vertices
+ * with the given ids. a negative value leaves the property unchanged. changes must be
+ * scheduled before the paths are precomputed. */
+gboolean topology_scheduleEdgeChange(Topology* top, SimulationTime time, const gchar* sourceID,
+        const gchar* targetID, gdouble latency, gdouble packetloss) {
     MAGIC_ASSERT(top);
+    utility_assert(sourceID && targetID);
+    utility_assert(top->pathMatrix == NULL);
+
+    igraph_integer_t srcVertexIndex = _topology_findVertexByID(top, sourceID);
+    igraph_integer_t dstVertexIndex = _topology_findVertexByID(top, targetID);
+    if(srcVertexIndex < 0 || dstVertexIndex < 0) {
+        critical("unable to schedule topology change, the topology has no vertex with id '%s'",
+                srcVertexIndex < 0 ? sourceID : targetID);
+        return FALSE;
+    }
+
+    TopologyEdgeChange change;
+    change.time = time;
+    change.latency = latency;
+    change.packetloss = packetloss;
+
+    _topology_lockGraph(top);
+    gint result = _topology_findEdge(top, srcVertexIndex, dstVertexIndex, &change.edgeIndex);
+    _topology_unlockGraph(top);
+
+    if(result != IGRAPH_SUCCESS) {
+        critical("unable to schedule topology change, there is no edge from '%s' to '%s'",
+                sourceID, targetID);
+        return FALSE;
+    }
+
+    /* changes are usually given in order, so searching from the end is quick. changes at
+     * the same time are applied in the order they were scheduled. */
+    guint position = top->edgeChanges->len;
+    while(position > 0 && g_array_index(top->edgeChanges, TopologyEdgeChange, position - 1).time > time) {
+        position--;
+    }
+    g_array_insert_val(top->edgeChanges, position, change);
+
+    return TRUE;
+}
+
+/* the time of the next change that is not applied yet, or SIMTIME_INVALID if there is none */
+SimulationTime topology_getNextEdgeChangeTime(Topology* top) {
+    MAGIC_ASSERT(top);
+    if(_topology_hasPendingEdgeChanges(top)) {
+        return g_array_index(top->edgeChanges, TopologyEdgeChange, top->nextEdgeChange).time;
+    } else {
+        return SIMTIME_INVALID;
+    }
+}
+
+/* drops the cached paths that may have used the changed edges
+ * @warning top->pathCacheLock must be held for writing */
+static void _topology_invalidateCachedPaths(Topology* top, GArray* changedEdges) {
+    /* the threads do not know which of their local paths used the edges */
+    g_atomic_int_inc(&(top->pathCacheGeneration));
+
+    if(!top->pathCache) {
+        return;
+    }
+
+    for(guint i = 0; i < changedEdges->len; i++) {
+        TopologyChangedEdge* changed = &g_array_index(changedEdges, TopologyChangedEdge, i);
+
+        if(top->isComplete) {
+            /* paths are direct edges, so only the path between the edge's own vertices changes */
+            GHashTable* sourceCache = g_hash_table_lookup(top->pathCache, GINT_TO_POINTER(changed->fromVertexIndex));
+            if(sourceCache) {
+                g_hash_table_remove(sourceCache, GINT_TO_POINTER(changed->toVertexIndex));
+            }
+            sourceCache = g_hash_table_lookup(top->pathCache, GINT_TO_POINTER(changed->toVertexIndex));
+            if(sourceCache) {
+                g_hash_table_remove(sourceCache, GINT_TO_POINTER(changed->fromVertexIndex));
+            }
+        } else if(changed->isShorter || !top->pathCacheEdges) {
+            /* any source could prefer the shorter edge now */
+            g_hash_table_remove_all(top->pathCache);
+            if(top->pathCacheEdges) {
+                g_hash_table_remove_all(top->pathCacheEdges);
+            }
+            return;
+        } else {
+            /* only the sources whose paths used the edge are affected */
+            GHashTableIter iter;
+            gpointer sourceKey, edgesValue;
+            g_hash_table_iter_init(&iter, top->pathCacheEdges);
+            while(g_hash_table_iter_next(&iter, &sourceKey, &edgesValue)) {
+                if(g_hash_table_contains(edgesValue, GINT_TO_POINTER(changed->edgeIndex))) {
+                    g_hash_table_remove(top->pathCache, sourceKey);
+                    g_hash_table_iter_remove(&iter);
+                }
+            }
+        }
+    }
+}
+
+/* the length of the tree path from the row's vertex to the given settled vertex */
+static gdouble _topology_getTreeDistance(TopologyAdjacency* adj, const guint* tree, guint vertex) {
+    gdouble distance = 0;
+    while(tree[vertex] != TOPOLOGY_ARC_SOURCE) {
+        guint arc = tree[vertex];
+        distance += adj->latencies[arc];
+        vertex = adj->sources[arc];
+    }
+    return distance;
+}
+
+static gboolean _topology_isMatrixRowAffected(Topology* top, guint row, GArray* changedArcs,
+        GArray* shorterArcs) {
+    TopologyAdjacency* adj = top->matrixAdjacency;
+    guint src = top->matrixVertices[row];
+
+    if(top->isComplete) {
+        /* rows only use the edges that leave their own vertex */
+        for(guint i = 0; i < changedArcs->len; i++) {
+            if(adj->sources[g_array_index(changedArcs, guint, i)] == src) {
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+
+    if(!top->pathTrees) {
+        /* we could not afford to remember which edges the row uses */
+        return TRUE;
+    }
+    const guint* tree = &(top->pathTrees[(gsize)row * adj->nVertices]);
+
+    /* a changed arc in the tree changes the paths to everything below it */
+    for(guint i = 0; i < changedArcs->len; i++) {
+        guint arc = g_array_index(changedArcs, guint, i);
+        guint u = adj->sources[arc], v = adj->targets[arc];
+        if(u == v ? u == src : tree[v] == arc) {
+            return TRUE;
+        }
+    }
+
+    /* none of the tree changed, so tree distances are still the shortest. a shorter arc
+     * outside of the tree matters only if it is now a shortcut to its target. */
+    for(guint i = 0; i < shorterArcs->len; i++) {
+        guint arc = g_array_index(shorterArcs, guint, i);
+        guint u = adj->sources[arc], v = adj->targets[arc];
+        if(u == v || tree[u] == TOPOLOGY_ARC_NONE) {
+            /* the search stopped before reaching u, so u is further than every attached vertex */
+            continue;
+        }
+        if(tree[v] == TOPOLOGY_ARC_NONE) {
+            return TRUE;
+        }
+        if(_topology_getTreeDistance(adj, tree, u) + adj->latencies[arc] <
+                _topology_getTreeDistance(adj, tree, v)) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* recomputes only the rows of the path matrix whose paths may use the changed edges */
+static void _topology_recomputeMatrixPaths(Topology* top, GArray* changedEdges) {
+    TopologyAdjacency* adj = top->matrixAdjacency;
+    utility_assert(adj);
+
+    GArray* changedArcs = g_array_new(FALSE, FALSE, sizeof(guint));
+    GArray* shorterArcs = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    /* bring our copy of the graph up to date */
+    _topology_lockGraph(top);
+    for(guint i = 0; i < changedEdges->len; i++) {
+        TopologyChangedEdge* changed = &g_array_index(changedEdges, TopologyChangedEdge, i);
+        gdouble latency = EAN(&top->graph, "latency", changed->edgeIndex);
+        gdouble reliability = 1.0f - EAN(&top->graph, "packetloss", changed->edgeIndex);
+
+        for(guint j = 0; j < 2; j++) {
+            guint arc = adj->edgeArcs[(2 * changed->edgeIndex) + j];
+            if(arc != TOPOLOGY_ARC_NONE) {
+                adj->latencies[arc] = latency;
+                adj->reliabilities[arc] = reliability;
+                g_array_append_val(changedArcs, arc);
+                if(changed->isShorter) {
+                    g_array_append_val(shorterArcs, arc);
+                }
+            }
+        }
+    }
+    _topology_unlockGraph(top);
+
+    GArray* rows = g_array_new(FALSE, FALSE, sizeof(guint));
+    for(guint row = 0; row < top->pathMatrixSize; row++) {
+        if(_topology_isMatrixRowAffected(top, row, changedArcs, shorterArcs)) {
+            g_array_append_val(rows, row);
+        }
+    }
+
+    if(rows->len > 0) {
+        GTimer* timer = g_timer_new();
+
+        gdouble minLatency = _topology_runPathSearches(top, adj, top->matrixVertices, top->matrixRows,
+                (const guint*)rows->data, rows->len, top->pathSearchThreads);
+        _topology_reduceMinimumPathLatency(top, minLatency);
+
+        g_mutex_lock(&top->topologyLock);
+        top->shortestPathTotalTime += g_timer_elapsed(timer, NULL);
+        top->shortestPathCount += rows->len;
+        g_mutex_unlock(&top->topologyLock);
+
+        message("recomputed %u of %u path matrix rows in %f seconds", rows->len,
+                top->pathMatrixSize, g_timer_elapsed(timer, NULL));
+        g_timer_destroy(timer);
+    }
+
+    g_array_free(rows, TRUE);
+    g_array_free(changedArcs, TRUE);
+    g_array_free(shorterArcs, TRUE);
+}
+
+/* applies the scheduled edge changes that are due at the given time, and recomputes the
+ * paths they affect. this must only be called while no other thread uses the topology,
+ * i.e. between rounds. */
+void topology_applyEdgeChanges(Topology* top, SimulationTime now) {
+    MAGIC_ASSERT(top);
+
+    GArray* changedEdges = g_array_new(FALSE, FALSE, sizeof(TopologyChangedEdge));
+
+    _topology_lockGraph(top);
+    g_rw_lock_writer_lock(&(top->edgeWeightsLock));
+
+    while(_topology_hasPendingEdgeChanges(top)) {
+        TopologyEdgeChange* change = &g_array_index(top->edgeChanges, TopologyEdgeChange, top->nextEdgeChange);
+        if(change->time > now) {
+            break;
+        }
+        top->nextEdgeChange++;
+
+        TopologyChangedEdge changed;
+        changed.edgeIndex = change->edgeIndex;
+        igraph_edge(&top->graph, change->edgeIndex, &changed.fromVertexIndex, &changed.toVertexIndex);
+
+        gdouble oldLatency = EAN(&top->graph, "latency", change->edgeIndex);
+        gdouble oldPacketLoss = EAN(&top->graph, "packetloss", change->edgeIndex);
+        gdouble newLatency = change->latency >= 0 ? change->latency : oldLatency;
+        gdouble newPacketLoss = change->packetloss >= 0 ? change->packetloss : oldPacketLoss;
+        changed.isShorter = newLatency < oldLatency;
+
+        SETEAN(&top->graph, "latency", change->edgeIndex, newLatency);
+        SETEAN(&top->graph, "packetloss", change->edgeIndex, newPacketLoss);
+        igraph_vector_set(top->edgeWeights, (glong)change->edgeIndex, newLatency);
+
+        message("changed edge %s-->%s from latency %f and packetloss %f to latency %f and packetloss %f",
+                VAS(&top->graph, "id", changed.fromVertexIndex), VAS(&top->graph, "id", changed.toVertexIndex),
+                oldLatency, oldPacketLoss, newLatency, newPacketLoss);
+
+        g_array_append_val(changedEdges, changed);
+    }
+
+    g_rw_lock_writer_unlock(&(top->edgeWeightsLock));
+    _topology_unlockGraph(top);
+
+    if(changedEdges->len > 0) {
+        g_rw_lock_writer_lock(&(top->pathCacheLock));
+        _topology_invalidateCachedPaths(top, changedEdges);
+        g_rw_lock_writer_unlock(&(top->pathCacheLock));
+
+        if(top->pathMatrix) {
+            _topology_recomputeMatrixPaths(top, changedEdges);
+        }
+    }
+
+    /* nothing will change anymore, so we no longer need to track what the paths use */
+    if(!_topology_hasPendingEdgeChanges(top) && top->matrixAdjacency) {
+        _topology_freeAdjacency(top->matrixAdjacency);
+        top->matrixAdjacency = NULL;
+        g_free(top->pathTrees);
+        top->pathTrees = NULL;
+    }
+
+    g_array_free(changedEdges, TRUE);
+}
+
+gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAddress) {
+    MAGIC_ASSERT(top);
+    return topology_getLatency(top, srcAddress, dstAddress) > -1;
+}
+
+static TopologyAttachBucket* _topology_newAttachBucket() {
+    TopologyAttachBucket* bucket = g_new0(TopologyAttachBucket, 1);
+    bucket->vertices = g_array_new(FALSE, FALSE, sizeof(igraph_integer_t));
+    bucket->trie = prefixtrie_new();
+    return bucket;
+}
+
+static void _topology_freeAttachBucket(TopologyAttachBucket* bucket) {
+    g_array_free(bucket->vertices, TRUE);
+    prefixtrie_free(bucket->trie);
+    g_free(bucket);
+}
+
+static void _topology_addToAttachBucket(Topology* top, GHashTable* buckets, gchar* key,
+        igraph_integer_t vertexIndex) {
+    TopologyAttachBucket* bucket = g_hash_table_lookup(buckets, key);
+    if(!bucket) {
+        bucket = _topology_newAttachBucket();
+        g_hash_table_replace(buckets, key, bucket);
+    } else {
+        g_free(key);
+    }
+
+    g_array_append_val(bucket->vertices, vertexIndex);
+
+    in_addr_t vertexIP = top->vertexIPs[vertexIndex];
+    if(vertexIP != INADDR_NONE && vertexIP != INADDR_ANY) {
+        prefixtrie_insert(bucket->trie, vertexIP, (gint)vertexIndex);
+    }
+}
+
+/* group the points of interest by the hints used to attach hosts to them */
+static gboolean _topology_buildAttachIndex(Topology* top) {
+    MAGIC_ASSERT(top);
+
+    top->attachAll = _topology_newAttachBucket();
+    top->attachByType = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)_topology_freeAttachBucket);
+    top->attachByGeocode = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)_topology_freeAttachBucket);
+    top->attachByTypeGeocode = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify)_topology_freeAttachBucket);
+    top->attachByIP = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+            (GDestroyNotify)g_array_unref);
 
-    igraph_integer_t vertexIndex = (igraph_integer_t) -1;
-    igraph_integer_t* vertexIndexPtr = GINT_TO_POINTER(-1);
-
-    AttachHelper* ah = g_new0(AttachHelper, 1);
-    ah->geocodeHint = geocodeHint;
-    ah->ipHint = ipHint;
-    ah->typeHint = typeHint;
-    ah->requestedIP = ipHint ? address_stringToIP(ipHint) : INADDR_NONE;
-    ah->candidatesAll = g_queue_new();
-    ah->candidatesCode = g_queue_new();
-    ah->candidatesType = g_queue_new();
-    ah->candidatesTypeCode = g_queue_new();
-
-    /* go through the vertices to see which ones match our hint filters */
     _topology_lockGraph(top);
-    _topology_iterateAllVertices(top, (VertexNotifyFunc) _topology_findAttachmentVertexHelperHook, ah);
+
+    igraph_integer_t vertexCount = igraph_vcount(&top->graph);
+    for(igraph_integer_t vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++) {
+        const gchar* idStr = VAS(&top->graph, "id", vertexIndex);
+        if(!g_strstr_len(idStr, (gssize)-1, "poi")) {
+            continue;
+        }
+
+        /* the hints are matched without regard to case */
+        gchar* typeStr = g_ascii_strdown(VAS(&top->graph, "type", vertexIndex), -1);
+        gchar* geocodeStr = g_ascii_strdown(VAS(&top->graph, "geocode", vertexIndex), -1);
+
+        g_array_append_val(top->attachAll->vertices, vertexIndex);
+        in_addr_t vertexIP = top->vertexIPs[vertexIndex];
+        if(vertexIP != INADDR_NONE && vertexIP != INADDR_ANY) {
+            prefixtrie_insert(top->attachAll->trie, vertexIP, (gint)vertexIndex);
+        }
+
+        _topology_addToAttachBucket(top, top->attachByTypeGeocode,
+                g_strconcat(typeStr, "\n", geocodeStr, NULL), vertexIndex);
+        _topology_addToAttachBucket(top, top->attachByType, typeStr, vertexIndex);
+        _topology_addToAttachBucket(top, top->attachByGeocode, geocodeStr, vertexIndex);
+
+        GArray* sameIP = g_hash_table_lookup(top->attachByIP, GUINT_TO_POINTER(vertexIP));
+        if(!sameIP) {
+            sameIP = g_array_new(FALSE, FALSE, sizeof(igraph_integer_t));
+            g_hash_table_replace(top->attachByIP, GUINT_TO_POINTER(vertexIP), sameIP);
+        }
+        g_array_append_val(sameIP, vertexIndex);
+    }
+
     _topology_unlockGraph(top);
 
+    message("indexed %u points of interest by %u types, %u geocodes, and %u IP addresses",
+            top->attachAll->vertices->len, g_hash_table_size(top->attachByType),
+            g_hash_table_size(top->attachByGeocode), g_hash_table_size(top->attachByIP));
+
+    return TRUE;
+}
+
+static TopologyAttachBucket* _topology_lookupAttachBucket(GHashTable* buckets, const gchar* key) {
+    gchar* lowerKey = g_ascii_strdown(key, -1);
+    TopologyAttachBucket* bucket = g_hash_table_lookup(buckets, lowerKey);
+    g_free(lowerKey);
+    return bucket;
+}
+
+static igraph_integer_t _topology_findAttachmentVertex(Topology* top, Random* randomSourcePool,
+        in_addr_t nodeIP, gchar* ipHint, gchar* geocodeHint, gchar* typeHint) {
+    MAGIC_ASSERT(top);
+
+    in_addr_t requestedIP = ipHint ? address_stringToIP(ipHint) : INADDR_NONE;
+
     /* the logic here is to try and find the most specific match following the hints.
      * we always use exact IP hint matches, and otherwise use it to select the best possible
      * match from the final set of candidates. the type and geocode hints are used to filter
@@ -1098,60 +2530,54 @@ static igraph_integer_t _topology_findAttachmentVertex(Topology* top, Random* ra
      * type-only filtered set. if the type-only set is empty, we fall back to the geocode-only
      * filtered set. if that is empty, we stick with the complete vertex set.
      */
-    GQueue* candidates = NULL;
-    gboolean useLongestPrefixMatching = FALSE;
-
-    if(g_queue_get_length(ah->candidatesTypeCode) > 0) {
-        candidates = ah->candidatesTypeCode;
-        useLongestPrefixMatching = (ipHint && ah->numCandidatesTypeCodeIPs > 0);
-    } else if(g_queue_get_length(ah->candidatesType) > 0) {
-        candidates = ah->candidatesType;
-        useLongestPrefixMatching = (ipHint && ah->numCandidatesTypeIPs > 0);
-    } else if(g_queue_get_length(ah->candidatesCode) > 0) {
-        candidates = ah->candidatesCode;
-        useLongestPrefixMatching = (ipHint && ah->numCandidatesCodeIPs > 0);
-    } else {
-        candidates = ah->candidatesAll;
-        useLongestPrefixMatching = (ipHint && ah->numCandidatesAllIPs > 0);
+    GArray* candidates = NULL;
+    PrefixTrie* trie = NULL;
+
+    if(requestedIP != INADDR_NONE && requestedIP != INADDR_ANY) {
+        candidates = g_hash_table_lookup(top->attachByIP, GUINT_TO_POINTER(requestedIP));
+    }
+
+    if(!candidates) {
+        TopologyAttachBucket* bucket = NULL;
+
+        if(typeHint && geocodeHint) {
+            gchar* key = g_strconcat(typeHint, "\n", geocodeHint, NULL);
+            bucket = _topology_lookupAttachBucket(top->attachByTypeGeocode, key);
+            g_free(key);
+        }
+        if(!bucket && typeHint) {
+            bucket = _topology_lookupAttachBucket(top->attachByType, typeHint);
+        }
+        if(!bucket && geocodeHint) {
+            bucket = _topology_lookupAttachBucket(top->attachByGeocode, geocodeHint);
+        }
+        if(!bucket) {
+            bucket = top->attachAll;
+        }
+
+        candidates = bucket->vertices;
+        trie = bucket->trie;
     }
 
-    guint numCandidates = g_queue_get_length(candidates);
+    guint numCandidates = candidates->len;
     utility_assert(numCandidates > 0);
 
+    igraph_integer_t vertexIndex = (igraph_integer_t) -1;
+
     /* if our candidate list has vertices with non-zero IPs, use longest prefix matching
      * to select the closest one to the requested IP; otherwise, grab a random candidate */
-    if(useLongestPrefixMatching && !ah->foundExactIPMatch) {
-        vertexIndexPtr = _topology_getLongestPrefixMatch(top, candidates, ah->requestedIP);
+    if(ipHint && trie && prefixtrie_getSize(trie) > 0) {
+        vertexIndex = (igraph_integer_t) prefixtrie_lookupLongestPrefix(trie, requestedIP);
     } else {
         gdouble randomDouble = random_nextDouble(randomSourcePool);
         gint indexRange = numCandidates - 1;
         gint chosenIndex = (gint) round((gdouble)(indexRange * randomDouble));
-        while(chosenIndex >= 0) {
-            vertexIndexPtr = g_queue_pop_head(candidates);
-            chosenIndex--;
-        }
+        vertexIndex = g_array_index(candidates, igraph_integer_t, chosenIndex);
     }
 
     /* make sure the vertex we found is legitimate */
-    utility_assert(vertexIndexPtr != GINT_TO_POINTER(-1));
-    vertexIndex = (igraph_integer_t) GPOINTER_TO_INT(vertexIndexPtr);
     utility_assert(vertexIndex > (igraph_integer_t) -1);
 
-    /* clean up */
-    if(ah->candidatesAll) {
-        g_queue_free(ah->candidatesAll);
-    }
-    if(ah->candidatesCode) {
-        g_queue_free(ah->candidatesCode);
-    }
-    if(ah->candidatesType) {
-        g_queue_free(ah->candidatesType);
-    }
-    if(ah->candidatesTypeCode) {
-        g_queue_free(ah->candidatesTypeCode);
-    }
-    g_free(ah);
-
     return vertexIndex;
 }
 
@@ -1167,6 +2593,15 @@ void topology_attach(Topology* top, Address* address, Random* randomSourcePool,
     /* attach it, i.e. store the mapping so we can route later */
     g_rw_lock_writer_lock(&(top->virtualIPLock));
     g_hash_table_replace(top->virtualIP, GUINT_TO_POINTER(nodeIP), GINT_TO_POINTER(vertexIndex));
+    guint hostIndex = _topology_getAddressHostIndex(address);
+    if(hostIndex != HOST_INDEX_INVALID) {
+        while(top->hostVertices->len <= hostIndex) {
+            gint unattached = -1;
+            g_array_append_val(top->hostVertices, unattached);
+        }
+        g_array_index(top->hostVertices, gint, hostIndex) = (gint) vertexIndex;
+    }
+    g_atomic_int_inc(&(top->pathCacheGeneration));
     g_rw_lock_writer_unlock(&(top->virtualIPLock));
 
     _topology_lockGraph(top);
@@ -1197,9 +2632,181 @@ void topology_detach(Topology* top, Address* address) {
 
     g_rw_lock_writer_lock(&(top->virtualIPLock));
     g_hash_table_remove(top->virtualIP, GUINT_TO_POINTER(ip));
+    guint hostIndex = _topology_getAddressHostIndex(address);
+    if(hostIndex < top->hostVertices->len) {
+        g_array_index(top->hostVertices, gint, hostIndex) = -1;
+    }
+    g_atomic_int_inc(&(top->pathCacheGeneration));
     g_rw_lock_writer_unlock(&(top->virtualIPLock));
 }
 
+typedef struct _PartitionEdge PartitionEdge;
+struct _PartitionEdge {
+    igraph_integer_t fromVertexIndex;
+    igraph_integer_t toVertexIndex;
+    igraph_real_t latency;
+};
+
+static gint _topology_comparePartitionEdges(gconstpointer a, gconstpointer b) {
+    const PartitionEdge* ea = a;
+    const PartitionEdge* eb = b;
+    return (ea->latency < eb->latency) ? -1 : (ea->latency > eb->latency) ? 1 : 0;
+}
+
+static gint _topology_findPartitionRoot(gint* parents, gint vertexIndex) {
+    /* union-find with path halving */
+    while(parents[vertexIndex] != vertexIndex) {
+        parents[vertexIndex] = parents[parents[vertexIndex]];
+        vertexIndex = parents[vertexIndex];
+    }
+    return vertexIndex;
+}
+
+static guint _topology_getLightestPartition(gdouble* partitionWeights, guint nPartitions) {
+    guint lightest = 0;
+    for(guint i = 1; i < nPartitions; i++) {
+        if(partitionWeights[i] < partitionWeights[lightest]) {
+            lightest = i;
+        }
+    }
+    return lightest;
+}
+
+static gint _topology_compareClusterWeights(gconstpointer a, gconstpointer b, gpointer userData) {
+    gdouble* weights = userData;
+    gdouble wa = weights[GPOINTER_TO_INT(a)];
+    gdouble wb = weights[GPOINTER_TO_INT(b)];
+    /* heaviest first */
+    return (wa > wb) ? -1 : (wa < wb) ? 1 : 0;
+}
+
+guint* topology_partition(Topology* top, Address** addresses, gdouble* weights,
+        guint nAddresses, guint nPartitions) {
+    MAGIC_ASSERT(top);
+    utility_assert(nPartitions > 0);
+
+    guint* assignments = g_new0(guint, MAX(nAddresses, 1));
+    if(nAddresses == 0 || nPartitions == 1) {
+        return assignments;
+    }
+
+    g_mutex_lock(&(top->topologyLock));
+    gint vertexCount = (gint) top->vertexCount;
+    gint edgeCount = (gint) top->edgeCount;
+    g_mutex_unlock(&(top->topologyLock));
+
+    /* the attached vertex of every address, or -1 if it is not attached */
+    gint* addressVertices = g_new(gint, nAddresses);
+    gdouble* vertexWeights = g_new0(gdouble, vertexCount);
+    gdouble totalWeight = 0;
+
+    for(guint i = 0; i < nAddresses; i++) {
+        addressVertices[i] = (gint) _topology_getConnectedVertexIndex(top, addresses[i]);
+        if(addressVertices[i] >= 0) {
+            vertexWeights[addressVertices[i]] += weights[i];
+        }
+        totalWeight += weights[i];
+    }
+
+    /* sort the edges so that we consider the closest vertices first */
+    PartitionEdge* edges = g_new(PartitionEdge, MAX(edgeCount, 1));
+    _topology_lockGraph(top);
+    g_rw_lock_reader_lock(&(top->edgeWeightsLock));
+    for(gint i = 0; i < edgeCount; i++) {
+        igraph_edge(&top->graph, (igraph_integer_t) i, &(edges[i].fromVertexIndex), &(edges[i].toVertexIndex));
+        edges[i].latency = VECTOR(*(top->edgeWeights))[i];
+    }
+    g_rw_lock_reader_unlock(&(top->edgeWeightsLock));
+    _topology_unlockGraph(top);
+
+    qsort(edges, (size_t) edgeCount, sizeof(PartitionEdge), _topology_comparePartitionEdges);
+
+    /* greedily merge the vertices at the ends of the shortest edges into clusters,
+     * as long as no cluster grows beyond the weight that one partition should carry.
+     * this is Kruskal's algorithm with a capacity constraint. */
+    gdouble capacity = totalWeight / (gdouble) nPartitions;
+    gint* parents = g_new(gint, vertexCount);
+    for(gint i = 0; i < vertexCount; i++) {
+        parents[i] = i;
+    }
+
+    for(gint i = 0; i < edgeCount; i++) {
+        gint a = _topology_findPartitionRoot(parents, (gint) edges[i].fromVertexIndex);
+        gint b = _topology_findPartitionRoot(parents, (gint) edges[i].toVertexIndex);
+        if(a != b && vertexWeights[a] + vertexWeights[b] <= capacity) {
+            parents[b] = a;
+            vertexWeights[a] += vertexWeights[b];
+            vertexWeights[b] = 0;
+        }
+    }
+
+    /* collect the addresses of each cluster, keyed by the cluster root */
+    GHashTable* clusters = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, (GDestroyNotify)g_queue_free);
+    for(guint i = 0; i < nAddresses; i++) {
+        if(addressVertices[i] >= 0) {
+            gint root = _topology_findPartitionRoot(parents, addressVertices[i]);
+            GQueue* members = g_hash_table_lookup(clusters, GINT_TO_POINTER(root));
+            if(!members) {
+                members = g_queue_new();
+                g_hash_table_replace(clusters, GINT_TO_POINTER(root), members);
+            }
+            g_queue_push_tail(members, GUINT_TO_POINTER(i));
+        }
+    }
+
+    /* assign the heaviest clusters first, each to the currently lightest partition.
+     * a single vertex with more weight than a partition should carry is split up. */
+    GQueue* roots = g_queue_new();
+    GList* keys = g_hash_table_get_keys(clusters);
+    for(GList* item = keys; item != NULL; item = g_list_next(item)) {
+        g_queue_insert_sorted(roots, item->data, _topology_compareClusterWeights, vertexWeights);
+    }
+    g_list_free(keys);
+
+    gdouble* partitionWeights = g_new0(gdouble, nPartitions);
+
+    while(!g_queue_is_empty(roots)) {
+        gint root = GPOINTER_TO_INT(g_queue_pop_head(roots));
+        GQueue* members = g_hash_table_lookup(clusters, GINT_TO_POINTER(root));
+        gboolean split = vertexWeights[root] > capacity ? TRUE : FALSE;
+        guint partition = _topology_getLightestPartition(partitionWeights, nPartitions);
+
+        for(GList* item = g_queue_peek_head_link(members); item != NULL; item = g_list_next(item)) {
+            guint i = GPOINTER_TO_UINT(item->data);
+            if(split) {
+                partition = _topology_getLightestPartition(partitionWeights, nPartitions);
+            }
+            assignments[i] = partition;
+            partitionWeights[partition] += weights[i];
+        }
+    }
+
+    /* unattached addresses have no locality, so they just balance the load */
+    for(guint i = 0; i < nAddresses; i++) {
+        if(addressVertices[i] < 0) {
+            guint partition = _topology_getLightestPartition(partitionWeights, nPartitions);
+            assignments[i] = partition;
+            partitionWeights[partition] += weights[i];
+        }
+    }
+
+    for(guint i = 0; i < nPartitions; i++) {
+        info("topology partition %u has total weight %f of %f", i, partitionWeights[i], totalWeight);
+    }
+    message("partitioned %u addresses into %u partitions using %u topology clusters",
+            nAddresses, nPartitions, g_hash_table_size(clusters));
+
+    g_free(partitionWeights);
+    g_queue_free(roots);
+    g_hash_table_destroy(clusters);
+    g_free(parents);
+    g_free(edges);
+    g_free(vertexWeights);
+    g_free(addressVertices);
+
+    return assignments;
+}
+
 void topology_free(Topology* top) {
     MAGIC_ASSERT(top);
 
@@ -1209,9 +2816,40 @@ void topology_free(Topology* top) {
         g_hash_table_destroy(top->virtualIP);
         top->virtualIP = NULL;
     }
+    if(top->hostVertices) {
+        g_array_free(top->hostVertices, TRUE);
+        top->hostVertices = NULL;
+    }
     g_rw_lock_writer_unlock(&(top->virtualIPLock));
     g_rw_lock_clear(&(top->virtualIPLock));
 
+    if(top->pathMatrix) {
+        g_free(top->hostMatrixIndices);
+        g_free(top->pathMatrix);
+    }
+    if(top->pathLinks) {
+        for(guint row = 0; row < top->pathMatrixSize; row++) {
+            g_array_free(top->pathLinkRows[row], TRUE);
+        }
+        g_free(top->pathLinkRows);
+        g_free(top->pathLinks);
+        g_free(top->linkBandwidths);
+    }
+    if(top->matrixAdjacency) {
+        _topology_freeAdjacency(top->matrixAdjacency);
+    }
+    if(top->pathTrees) {
+        g_free(top->pathTrees);
+    }
+    if(top->matrixVertices) {
+        g_free(top->matrixVertices);
+        g_free(top->matrixRows);
+    }
+    g_array_free(top->edgeChanges, TRUE);
+    if(top->vertexIDs) {
+        g_hash_table_destroy(top->vertexIDs);
+    }
+
     /* this functions grabs and releases the pathCache write lock */
     _topology_clearCache(top);
     g_rw_lock_clear(&(top->pathCacheLock));
@@ -1226,6 +2864,17 @@ void topology_free(Topology* top) {
     g_rw_lock_writer_unlock(&(top->edgeWeightsLock));
     g_rw_lock_clear(&(top->edgeWeightsLock));
 
+    if(top->attachAll) {
+        _topology_freeAttachBucket(top->attachAll);
+        g_hash_table_destroy(top->attachByType);
+        g_hash_table_destroy(top->attachByGeocode);
+        g_hash_table_destroy(top->attachByTypeGeocode);
+        g_hash_table_destroy(top->attachByIP);
+    }
+    if(top->vertexIPs) {
+        g_free(top->vertexIPs);
+    }
+
     /* clear the graph */
     _topology_lockGraph(top);
     igraph_destroy(&(top->graph));
@@ -1244,6 +2893,8 @@ Topology* topology_new(const gchar* graphPath) {
     MAGIC_INIT(top);
 
     top->virtualIP = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+    top->hostVertices = g_array_new(FALSE, FALSE, sizeof(gint));
+    top->edgeChanges = g_array_new(FALSE, FALSE, sizeof(TopologyEdgeChange));
 
     _topology_initGraphLock(&(top->graphLock));
     g_mutex_init(&(top->topologyLock));
@@ -1252,12 +2903,37 @@ Topology* topology_new(const gchar* graphPath) {
     g_rw_lock_init(&(top->pathCacheLock));
 
     /* first read in the graph and make sure its formed correctly,
-     * then setup our edge weights for shortest path */
-    if(!_topology_loadGraph(top, graphPath) || !_topology_checkGraph(top) ||
-            !_topology_extractEdgeWeights(top)) {
+     * then setup our edge weights for shortest path. compiled graphs
+     * were already checked when they were compiled. */
+    gboolean isLoaded = FALSE;
+    if(compiledtopology_isCompiled(graphPath)) {
+        isLoaded = _topology_loadCompiledGraph(top, graphPath);
+    } else {
+        isLoaded = _topology_loadGraph(top, graphPath) && _topology_checkGraph(top) &&
+                _topology_extractVertexIPs(top);
+    }
+
+    if(!isLoaded || !_topology_buildAttachIndex(top) || !_topology_extractEdgeWeights(top)) {
         topology_free(top);
         return NULL;
     }
 
     return top;
 }
+
+gboolean topology_compile(Topology* top, const gchar* compiledPath) {
+    MAGIC_ASSERT(top);
+    utility_assert(compiledPath);
+
+    CompiledTopologyProperties properties;
+    memset(&properties, 0, sizeof(CompiledTopologyProperties));
+    properties.isDirected = top->isDirected ? TRUE : FALSE;
+    properties.isComplete = top->isComplete ? TRUE : FALSE;
+    properties.vertexIPs = top->vertexIPs;
+
+    _topology_lockGraph(top);
+    gboolean isSuccess = compiledtopology_write(compiledPath, &top->graph, &properties);
+    _topology_unlockGraph(top);
+
+    return isSuccess;
+}
@@ -13,6 +13,7 @@ typedef struct _Topology Topology;
 
 Topology* topology_new(const gchar* graphPath);
 void topology_free(Topology* top);
+gboolean topology_compile(Topology* top, const gchar* compiledPath);
 
 void topology_attach(Topology* top, Address* address, Random* randomSourcePool,
         gchar* ipHint, gchar* geocodeHint, gchar* typeHint, guint64* bwDownOut, guint64* bwUpOut);
@@ -20,5 +21,22 @@ void topology_detach(Topology* top, Address* address);
 gboolean topology_isRoutable(Topology* top, Address* srcAddress, Address* dstAddress);
 gdouble topology_getLatency(Topology* top, Address* srcAddress, Address* dstAddress);
 gdouble topology_getReliability(Topology* top, Address* srcAddress, Address* dstAddress);
+gboolean topology_getPathInfo(Topology* top, Address* srcAddress, Address* dstAddress,
+        gdouble* latency, gdouble* reliability);
+gboolean topology_getPathInfoByHostIndex(Topology* top, guint srcHostIndex, guint dstHostIndex,
+        gdouble* latency, gdouble* reliability);
+void topology_getPathLinks(Topology* top, guint srcHostIndex, guint dstHostIndex, GArray* links);
+guint topology_getLinkCount(Topology* top);
+const gdouble* topology_getLinkBandwidths(Topology* top);
+gdouble topology_getMinimumPathLatency(Topology* top);
+gboolean topology_getPartitionLatencies(Topology* top, const guint* hostPartitions, guint nHosts,
+        guint nPartitions, gdouble* latencies);
+void topology_precomputePaths(Topology* top, guint nThreads);
+gboolean topology_scheduleEdgeChange(Topology* top, SimulationTime time, const gchar* sourceID,
+        const gchar* targetID, gdouble latency, gdouble packetloss);
+SimulationTime topology_getNextEdgeChangeTime(Topology* top);
+void topology_applyEdgeChanges(Topology* top, SimulationTime now);
+guint* topology_partition(Topology* top, Address** addresses, gdouble* weights,
+        guint nAddresses, guint nPartitions);
 
 #endif /* SHD_TOPOLOGY_H_ */
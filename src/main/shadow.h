@@ -70,12 +70,16 @@ typedef struct _Process Process;
 #include "core/support/shd-examples.h"
 #include "core/support/shd-options.h"
 #include "utility/shd-utility.h"
+#include "utility/shd-object-pool.h"
+#include "utility/shd-range-set.h"
 #include "core/work/shd-task.h"
 #include "core/work/shd-event.h"
+#include "core/work/shd-event-queue.h"
 #include "core/work/shd-message.h"
 #include "host/shd-protocol.h"
 #include "host/descriptor/shd-descriptor.h"
 #include "core/support/shd-configuration.h"
+#include "host/shd-payload.h"
 #include "host/shd-packet.h"
 #include "host/shd-cpu.h"
 #include "utility/shd-pcap-writer.h"
@@ -85,11 +89,18 @@ typedef struct _Process Process;
 #include "utility/shd-priority-queue.h"
 #include "utility/shd-async-priority-queue.h"
 #include "utility/shd-count-down-latch.h"
+#include "utility/shd-round-barrier.h"
+#include "utility/shd-work-stealing-deque.h"
+#include "utility/shd-mpsc-queue.h"
 #include "utility/shd-random.h"
 
 #include "routing/shd-address.h"
 #include "routing/shd-dns.h"
+#include "routing/shd-link-queues.h"
 #include "routing/shd-path.h"
+#include "routing/shd-prefix-trie.h"
+#include "routing/shd-compiled-topology.h"
+#include "routing/shd-topology.h"
 
 #include "host/descriptor/shd-epoll.h"
 #include "host/descriptor/shd-timer.h"
@@ -102,15 +113,15 @@ typedef struct _Process Process;
 #include "host/descriptor/shd-tcp-reno.h"
 #include "host/descriptor/shd-tcp-cubic.h"
 #include "host/descriptor/shd-tcp-scoreboard.h"
+#include "host/descriptor/shd-tcp-retransmit-queue.h"
 #include "host/descriptor/shd-udp.h"
 #include "host/shd-process.h"
 #include "host/shd-network-interface.h"
 #include "host/shd-tracker.h"
 #include "host/shd-host.h"
 
-#include "routing/shd-topology.h"
-
 #include "core/scheduler/shd-scheduler-policy.h"
+#include "core/scheduler/shd-scheduler-lookahead.h"
 #include "core/scheduler/shd-scheduler.h"
 #include "core/shd-master.h"
 #include "core/shd-slave.h"
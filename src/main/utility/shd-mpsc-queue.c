@@ -0,0 +1,92 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+
+#include "shd-utility.h"
+#include "shd-mpsc-queue.h"
+
+typedef struct _MPSCQueueNode MPSCQueueNode;
+struct _MPSCQueueNode {
+    gpointer data;
+    MPSCQueueNode* next;
+};
+
+/* the producers push onto the head of a singly linked list with a CAS, and the consumer
+ * swaps out the entire list at once. producers never remove nodes, so the CAS does not
+ * suffer from the ABA problem. */
+struct _MPSCQueue {
+    MPSCQueueNode* volatile head;
+    GDestroyNotify freeFunc;
+};
+
+MPSCQueue* mpscqueue_new(GDestroyNotify freeFunc) {
+    MPSCQueue* q = g_new0(MPSCQueue, 1);
+    q->freeFunc = freeFunc;
+    return q;
+}
+
+void mpscqueue_free(MPSCQueue* q) {
+    utility_assert(q);
+    MPSCQueueNode* node = __atomic_exchange_n(&(q->head), NULL, __ATOMIC_ACQUIRE);
+    while(node != NULL) {
+        MPSCQueueNode* next = node->next;
+        if(q->freeFunc) {
+            q->freeFunc(node->data);
+        }
+        g_slice_free(MPSCQueueNode, node);
+        node = next;
+    }
+    g_free(q);
+}
+
+gboolean mpscqueue_isEmpty(MPSCQueue* q) {
+    utility_assert(q);
+    return __atomic_load_n(&(q->head), __ATOMIC_RELAXED) == NULL ? TRUE : FALSE;
+}
+
+void mpscqueue_push(MPSCQueue* q, gpointer data) {
+    utility_assert(q);
+
+    MPSCQueueNode* node = g_slice_new(MPSCQueueNode);
+    node->data = data;
+    node->next = __atomic_load_n(&(q->head), __ATOMIC_RELAXED);
+
+    /* on failure, the CAS reloads the current head into node->next */
+    while(!__atomic_compare_exchange_n(&(q->head), &(node->next), node, TRUE,
+            __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+guint mpscqueue_drain(MPSCQueue* q, GFunc func, gpointer userData) {
+    utility_assert(q);
+    utility_assert(func);
+
+    /* quick check so that we don't dirty the cache line when there is nothing to do */
+    if(__atomic_load_n(&(q->head), __ATOMIC_RELAXED) == NULL) {
+        return 0;
+    }
+
+    MPSCQueueNode* node = __atomic_exchange_n(&(q->head), NULL, __ATOMIC_ACQUIRE);
+
+    /* the list is in reverse push order, flip it */
+    MPSCQueueNode* reversed = NULL;
+    while(node != NULL) {
+        MPSCQueueNode* next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+
+    guint count = 0;
+    while(reversed != NULL) {
+        MPSCQueueNode* next = reversed->next;
+        func(reversed->data, userData);
+        g_slice_free(MPSCQueueNode, reversed);
+        reversed = next;
+        count++;
+    }
+
+    return count;
+}
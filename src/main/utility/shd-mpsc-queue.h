@@ -0,0 +1,21 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_MPSC_QUEUE_H_
+#define SHD_MPSC_QUEUE_H_
+
+/* A lock-free multi-producer/single-consumer queue. Any thread may push, but
+ * only a single thread at a time may drain the queue. Draining takes all items
+ * that were pushed so far in one atomic step, and visits them in push order. */
+typedef struct _MPSCQueue MPSCQueue;
+
+MPSCQueue* mpscqueue_new(GDestroyNotify freeFunc);
+void mpscqueue_free(MPSCQueue* q);
+
+gboolean mpscqueue_isEmpty(MPSCQueue* q);
+void mpscqueue_push(MPSCQueue* q, gpointer data);
+guint mpscqueue_drain(MPSCQueue* q, GFunc func, gpointer userData);
+
+#endif /* SHD_MPSC_QUEUE_H_ */
@@ -0,0 +1,207 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "shd-utility.h"
+#include "shd-object-pool.h"
+
+/* the number of objects moved between a thread cache and the shared pool at once,
+ * which is also the number of objects carved out of each newly allocated slab */
+#define OBJECTPOOL_BATCH_SIZE 64
+/* the maximum number of pools that may exist at once */
+#define OBJECTPOOL_MAX_POOLS 32
+
+/* a free object is overlaid with this struct. the first free object of each
+ * batch also links to the next batch and records the batch length. */
+typedef struct _ObjectPoolItem ObjectPoolItem;
+struct _ObjectPoolItem {
+    ObjectPoolItem* next;
+    ObjectPoolItem* nextBatch;
+    gsize batchLength;
+};
+
+struct _ObjectPool {
+    gsize objectSize;
+    guint index;
+    /* protects the batches and slabs */
+    GMutex lock;
+    ObjectPoolItem* batches;
+    GSList* slabs;
+};
+
+typedef struct _ObjectPoolCache ObjectPoolCache;
+struct _ObjectPoolCache {
+    ObjectPool* pool;
+    ObjectPoolItem* head;
+    gsize length;
+};
+
+typedef struct _ObjectPoolThreadCaches ObjectPoolThreadCaches;
+struct _ObjectPoolThreadCaches {
+    ObjectPoolCache caches[OBJECTPOOL_MAX_POOLS];
+};
+
+static void _objectpool_flushThreadCaches(ObjectPoolThreadCaches* threadCaches);
+
+/* each thread keeps one cache for every pool */
+static GPrivate threadCachesKey = G_PRIVATE_INIT((GDestroyNotify)_objectpool_flushThreadCaches);
+
+/* pool indices are never reused, since thread caches may still refer to them */
+static volatile gint nextPoolIndex = 0;
+
+ObjectPool* objectpool_new(gsize objectSize) {
+    gint index = g_atomic_int_add(&nextPoolIndex, 1);
+    if(index >= OBJECTPOOL_MAX_POOLS) {
+        utility_assert(index < OBJECTPOOL_MAX_POOLS);
+        return NULL;
+    }
+
+    ObjectPool* pool = g_new0(ObjectPool, 1);
+
+    /* free objects must hold an item, and we keep objects pointer-aligned */
+    gsize alignment = 2 * sizeof(gpointer);
+    objectSize = MAX(objectSize, sizeof(ObjectPoolItem));
+    pool->objectSize = ((objectSize + alignment - 1) / alignment) * alignment;
+    pool->index = (guint)index;
+    g_mutex_init(&(pool->lock));
+
+    return pool;
+}
+
+/* all objects must have been released, and no thread may use the pool anymore */
+void objectpool_free(ObjectPool* pool) {
+    utility_assert(pool);
+    g_slist_free_full(pool->slabs, g_free);
+    g_mutex_clear(&(pool->lock));
+    g_free(pool);
+}
+
+/* returns a list of exactly length items from the front of the cache */
+static ObjectPoolItem* _objectpool_detach(ObjectPoolCache* cache, gsize length) {
+    utility_assert(length > 0 && length <= cache->length);
+
+    ObjectPoolItem* first = cache->head;
+    ObjectPoolItem* last = first;
+    for(gsize i = 1; i < length; i++) {
+        last = last->next;
+    }
+
+    cache->head = last->next;
+    cache->length -= length;
+
+    last->next = NULL;
+    first->batchLength = length;
+    return first;
+}
+
+static void _objectpool_pushBatch(ObjectPool* pool, ObjectPoolItem* batch) {
+    g_mutex_lock(&(pool->lock));
+    batch->nextBatch = pool->batches;
+    pool->batches = batch;
+    g_mutex_unlock(&(pool->lock));
+}
+
+static void _objectpool_flushThreadCaches(ObjectPoolThreadCaches* threadCaches) {
+    if(!threadCaches) {
+        return;
+    }
+
+    /* give all of the objects cached by the exiting thread back to their pools */
+    for(guint i = 0; i < OBJECTPOOL_MAX_POOLS; i++) {
+        ObjectPoolCache* cache = &(threadCaches->caches[i]);
+        while(cache->length > 0) {
+            ObjectPoolItem* batch = _objectpool_detach(cache, MIN(cache->length, OBJECTPOOL_BATCH_SIZE));
+            _objectpool_pushBatch(cache->pool, batch);
+        }
+    }
+
+    g_free(threadCaches);
+}
+
+static ObjectPoolCache* _objectpool_getCache(ObjectPool* pool) {
+    ObjectPoolThreadCaches* threadCaches = g_private_get(&threadCachesKey);
+    if(!threadCaches) {
+        threadCaches = g_new0(ObjectPoolThreadCaches, 1);
+        g_private_set(&threadCachesKey, threadCaches);
+    }
+
+    ObjectPoolCache* cache = &(threadCaches->caches[pool->index]);
+    cache->pool = pool;
+    return cache;
+}
+
+static void _objectpool_refill(ObjectPool* pool, ObjectPoolCache* cache) {
+    utility_assert(cache->length == 0);
+
+    /* first try to reuse a batch that another thread released */
+    g_mutex_lock(&(pool->lock));
+    ObjectPoolItem* batch = pool->batches;
+    if(batch) {
+        pool->batches = batch->nextBatch;
+    }
+    g_mutex_unlock(&(pool->lock));
+
+    if(batch) {
+        cache->head = batch;
+        cache->length = batch->batchLength;
+        return;
+    }
+
+    /* none available, carve a new batch out of a new slab */
+    guint8* slab = g_malloc(pool->objectSize * OBJECTPOOL_BATCH_SIZE);
+
+    g_mutex_lock(&(pool->lock));
+    pool->slabs = g_slist_prepend(pool->slabs, slab);
+    g_mutex_unlock(&(pool->lock));
+
+    for(gsize i = 0; i < OBJECTPOOL_BATCH_SIZE; i++) {
+        ObjectPoolItem* item = (ObjectPoolItem*)(slab + (i * pool->objectSize));
+        item->next = cache->head;
+        cache->head = item;
+    }
+    cache->length = OBJECTPOOL_BATCH_SIZE;
+}
+
+gpointer objectpool_alloc(ObjectPool* pool) {
+    utility_assert(pool);
+
+    ObjectPoolCache* cache = _objectpool_getCache(pool);
+    if(cache->length == 0) {
+        _objectpool_refill(pool, cache);
+    }
+
+    ObjectPoolItem* item = cache->head;
+    cache->head = item->next;
+    cache->length--;
+
+    return item;
+}
+
+gpointer objectpool_alloc0(ObjectPool* pool) {
+    gpointer object = objectpool_alloc(pool);
+    memset(object, 0, pool->objectSize);
+    return object;
+}
+
+void objectpool_release(ObjectPool* pool, gpointer object) {
+    utility_assert(pool);
+    if(!object) {
+        return;
+    }
+
+    ObjectPoolCache* cache = _objectpool_getCache(pool);
+
+    ObjectPoolItem* item = object;
+    item->next = cache->head;
+    cache->head = item;
+    cache->length++;
+
+    /* keep some objects around for this thread, but don't hoard them */
+    if(cache->length >= 2 * OBJECTPOOL_BATCH_SIZE) {
+        _objectpool_pushBatch(pool, _objectpool_detach(cache, OBJECTPOOL_BATCH_SIZE));
+    }
+}
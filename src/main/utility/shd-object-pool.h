@@ -0,0 +1,22 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_OBJECT_POOL_H_
+#define SHD_OBJECT_POOL_H_
+
+/* A thread-caching free-list allocator for small fixed-size objects. Each thread
+ * allocates from and releases to its own private cache without locking; objects
+ * move between a thread cache and the shared pool in batches, so objects that are
+ * allocated on one thread and released on another are recycled cheaply. */
+typedef struct _ObjectPool ObjectPool;
+
+ObjectPool* objectpool_new(gsize objectSize);
+void objectpool_free(ObjectPool* pool);
+
+gpointer objectpool_alloc(ObjectPool* pool);
+gpointer objectpool_alloc0(ObjectPool* pool);
+void objectpool_release(ObjectPool* pool, gpointer object);
+
+#endif /* SHD_OBJECT_POOL_H_ */
@@ -0,0 +1,131 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+
+#include "shd-utility.h"
+#include "shd-range-set.h"
+
+typedef struct _Range Range;
+struct _Range {
+    guint start;
+    guint end;
+};
+
+struct _RangeSet {
+    GArray* ranges;
+};
+
+RangeSet* rangeset_new() {
+    RangeSet* set = g_slice_new(RangeSet);
+    set->ranges = g_array_new(FALSE, FALSE, sizeof(Range));
+    return set;
+}
+
+RangeSet* rangeset_copy(RangeSet* set) {
+    utility_assert(set);
+    RangeSet* copy = g_slice_new(RangeSet);
+    copy->ranges = g_array_sized_new(FALSE, FALSE, sizeof(Range), set->ranges->len);
+    g_array_append_vals(copy->ranges, set->ranges->data, set->ranges->len);
+    return copy;
+}
+
+void rangeset_free(RangeSet* set) {
+    utility_assert(set);
+    g_array_free(set->ranges, TRUE);
+    g_slice_free(RangeSet, set);
+}
+
+/* returns the index of the first range that ends after value, or the number of ranges */
+guint rangeset_find(RangeSet* set, guint value) {
+    utility_assert(set);
+
+    guint low = 0, high = set->ranges->len;
+    while(low < high) {
+        guint middle = low + (high - low) / 2;
+        if(g_array_index(set->ranges, Range, middle).end <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void rangeset_add(RangeSet* set, guint value) {
+    utility_assert(set && value < G_MAXUINT);
+
+    guint index = rangeset_find(set, value);
+    Range* next = index < set->ranges->len ? &g_array_index(set->ranges, Range, index) : NULL;
+    Range* previous = index > 0 ? &g_array_index(set->ranges, Range, index - 1) : NULL;
+
+    if(next && next->start <= value) {
+        /* already in the set */
+        return;
+    }
+
+    if(previous && previous->end == value) {
+        previous->end++;
+        if(next && next->start == previous->end) {
+            /* the value filled the gap between two ranges */
+            previous->end = next->end;
+            g_array_remove_index(set->ranges, index);
+        }
+    } else if(next && next->start == value + 1) {
+        next->start = value;
+    } else {
+        Range range = {value, value + 1};
+        g_array_insert_val(set->ranges, index, range);
+    }
+}
+
+/* removes all values less than the given one */
+void rangeset_removeBelow(RangeSet* set, guint value) {
+    utility_assert(set);
+
+    guint index = rangeset_find(set, value);
+    if(index > 0) {
+        g_array_remove_range(set->ranges, 0, index);
+    }
+    if(set->ranges->len > 0) {
+        Range* first = &g_array_index(set->ranges, Range, 0);
+        first->start = MAX(first->start, value);
+    }
+}
+
+gboolean rangeset_isEmpty(RangeSet* set) {
+    utility_assert(set);
+    return set->ranges->len == 0;
+}
+
+/* returns the end of the range holding value, or value itself if it is not in the set */
+guint rangeset_getRangeEnd(RangeSet* set, guint value) {
+    utility_assert(set);
+
+    guint index = rangeset_find(set, value);
+    if(index < set->ranges->len) {
+        Range* range = &g_array_index(set->ranges, Range, index);
+        if(range->start <= value) {
+            return range->end;
+        }
+    }
+    return value;
+}
+
+guint rangeset_getNumRanges(RangeSet* set) {
+    utility_assert(set);
+    return set->ranges->len;
+}
+
+void rangeset_getRange(RangeSet* set, guint index, guint* start, guint* end) {
+    utility_assert(set && index < set->ranges->len);
+    Range* range = &g_array_index(set->ranges, Range, index);
+    if(start) {
+        *start = range->start;
+    }
+    if(end) {
+        *end = range->end;
+    }
+}
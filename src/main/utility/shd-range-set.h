@@ -0,0 +1,33 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_RANGE_SET_H_
+#define SHD_RANGE_SET_H_
+
+#include <glib.h>
+
+/**
+ * A set of unsigned integers stored as sorted, non-overlapping, non-adjacent
+ * ranges [start, end). Adding a value merges it into its neighboring ranges,
+ * so a set of mostly consecutive values stays small and lookups are a binary
+ * search over the ranges.
+ */
+
+typedef struct _RangeSet RangeSet;
+
+RangeSet* rangeset_new();
+RangeSet* rangeset_copy(RangeSet* set);
+void rangeset_free(RangeSet* set);
+
+void rangeset_add(RangeSet* set, guint value);
+void rangeset_removeBelow(RangeSet* set, guint value);
+
+gboolean rangeset_isEmpty(RangeSet* set);
+guint rangeset_getRangeEnd(RangeSet* set, guint value);
+guint rangeset_find(RangeSet* set, guint value);
+guint rangeset_getNumRanges(RangeSet* set);
+void rangeset_getRange(RangeSet* set, guint index, guint* start, guint* end);
+
+#endif /* SHD_RANGE_SET_H_ */
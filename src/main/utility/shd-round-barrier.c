@@ -0,0 +1,125 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "shd-utility.h"
+#include "shd-round-barrier.h"
+
+/* how many times we check the barrier before going to sleep, if we spin at all */
+#define ROUNDBARRIER_SPIN_COUNT 4096
+
+/* This is a sense-reversing barrier: the last thread to arrive resets the count and
+ * flips the sense, which releases every thread that saw the old sense on arrival.
+ * The count is reset before the flip, so released threads may immediately use the
+ * barrier again. Sleepers are counted so that the syscall to wake them up is only
+ * made when somebody actually went to sleep. */
+struct _RoundBarrier {
+    gint nThreads;
+    /* how many times to check the barrier before going to sleep */
+    gint spinCount;
+    /* the number of threads that have not arrived yet in this round */
+    volatile gint remaining;
+    /* flipped every time the barrier opens */
+    volatile gint sense;
+    /* the number of threads sleeping on the sense */
+    volatile gint nSleepers;
+    /* non-zero while a thread is sleeping in roundbarrier_awaitOthers */
+    volatile gint isWaitingForOthers;
+};
+
+static void _roundbarrier_futexWait(volatile gint* address, gint value) {
+    /* returns immediately if the value already changed, and spurious wakeups are fine
+     * because our callers check the value again in a loop */
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void _roundbarrier_futexWake(volatile gint* address, gint nWaiters) {
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, nWaiters, NULL, NULL, 0);
+}
+
+static void _roundbarrier_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause");
+#endif
+}
+
+RoundBarrier* roundbarrier_new(guint nThreads) {
+    utility_assert(nThreads > 0);
+    RoundBarrier* barrier = g_new0(RoundBarrier, 1);
+    barrier->nThreads = (gint)nThreads;
+    barrier->remaining = (gint)nThreads;
+    /* spinning only helps if the thread we are waiting for can run at the same time */
+    glong nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    barrier->spinCount = (nCPUs > 0 && nThreads <= (guint)nCPUs) ? ROUNDBARRIER_SPIN_COUNT : 0;
+    return barrier;
+}
+
+void roundbarrier_free(RoundBarrier* barrier) {
+    utility_assert(barrier);
+    g_free(barrier);
+}
+
+void roundbarrier_await(RoundBarrier* barrier) {
+    utility_assert(barrier);
+
+    /* must be read before we arrive, or the barrier could open before we look */
+    gint sense = __atomic_load_n(&(barrier->sense), __ATOMIC_ACQUIRE);
+
+    gint remaining = __atomic_sub_fetch(&(barrier->remaining), 1, __ATOMIC_SEQ_CST);
+    utility_assert(remaining >= 0);
+
+    if(remaining == 0) {
+        /* we are last, open the barrier */
+        __atomic_store_n(&(barrier->remaining), barrier->nThreads, __ATOMIC_RELAXED);
+        __atomic_store_n(&(barrier->sense), !sense, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&(barrier->nSleepers), __ATOMIC_SEQ_CST) > 0) {
+            _roundbarrier_futexWake(&(barrier->sense), INT_MAX);
+        }
+        return;
+    }
+
+    if(remaining == 1 && __atomic_load_n(&(barrier->isWaitingForOthers), __ATOMIC_SEQ_CST)) {
+        /* only the thread in awaitOthers is missing now */
+        _roundbarrier_futexWake(&(barrier->remaining), 1);
+    }
+
+    for(gint i = 0; i < barrier->spinCount; i++) {
+        if(__atomic_load_n(&(barrier->sense), __ATOMIC_ACQUIRE) != sense) {
+            return;
+        }
+        _roundbarrier_relax();
+    }
+
+    __atomic_add_fetch(&(barrier->nSleepers), 1, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&(barrier->sense), __ATOMIC_SEQ_CST) == sense) {
+        _roundbarrier_futexWait(&(barrier->sense), sense);
+    }
+    __atomic_sub_fetch(&(barrier->nSleepers), 1, __ATOMIC_SEQ_CST);
+}
+
+/* waits until all other threads arrived at the barrier, without arriving ourselves.
+ * the others stay parked until we call roundbarrier_await. */
+void roundbarrier_awaitOthers(RoundBarrier* barrier) {
+    utility_assert(barrier);
+
+    for(gint i = 0; i < barrier->spinCount; i++) {
+        if(__atomic_load_n(&(barrier->remaining), __ATOMIC_ACQUIRE) == 1) {
+            return;
+        }
+        _roundbarrier_relax();
+    }
+
+    __atomic_store_n(&(barrier->isWaitingForOthers), 1, __ATOMIC_SEQ_CST);
+    gint remaining;
+    while((remaining = __atomic_load_n(&(barrier->remaining), __ATOMIC_SEQ_CST)) != 1) {
+        _roundbarrier_futexWait(&(barrier->remaining), remaining);
+    }
+    __atomic_store_n(&(barrier->isWaitingForOthers), 0, __ATOMIC_RELAXED);
+}
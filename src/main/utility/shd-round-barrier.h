@@ -0,0 +1,22 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_ROUND_BARRIER_H_
+#define SHD_ROUND_BARRIER_H_
+
+/* A reusable barrier for a fixed number of threads. Waiting threads first spin for
+ * a short while, since in short rounds the other threads usually arrive quickly,
+ * and then sleep on a futex. Unlike a CountDownLatch, it does not need to be
+ * reset between rounds. One thread may also wait for all of the others to arrive
+ * without releasing them, so it can prepare the next round while they are parked. */
+typedef struct _RoundBarrier RoundBarrier;
+
+RoundBarrier* roundbarrier_new(guint nThreads);
+void roundbarrier_free(RoundBarrier* barrier);
+
+void roundbarrier_await(RoundBarrier* barrier);
+void roundbarrier_awaitOthers(RoundBarrier* barrier);
+
+#endif /* SHD_ROUND_BARRIER_H_ */
@@ -0,0 +1,162 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <glib.h>
+
+#include "shd-utility.h"
+#include "shd-work-stealing-deque.h"
+
+/* This follows "Correct and Efficient Work-Stealing for Weak Memory Models"
+ * (Le et al., PPoPP 2013). The indices grow monotonically and are never reset,
+ * so we use 64-bit counters to make sure they never wrap during a simulation. */
+
+typedef struct _WorkStealingBuffer WorkStealingBuffer;
+struct _WorkStealingBuffer {
+    gint64 capacity;
+    gpointer items[];
+};
+
+struct _WorkStealingDeque {
+    /* next index that a thief will take */
+    volatile gint64 top;
+    /* next index that the owner will push into */
+    volatile gint64 bottom;
+    /* the current circular buffer, replaced by the owner when it fills up */
+    WorkStealingBuffer* volatile buffer;
+    /* old buffers that thieves may still be reading, freed with the deque */
+    GSList* retiredBuffers;
+};
+
+static WorkStealingBuffer* _workstealingbuffer_new(gint64 capacity) {
+    WorkStealingBuffer* buffer = g_malloc0(sizeof(WorkStealingBuffer) + (capacity * sizeof(gpointer)));
+    buffer->capacity = capacity;
+    return buffer;
+}
+
+static gpointer _workstealingbuffer_get(WorkStealingBuffer* buffer, gint64 index) {
+    return __atomic_load_n(&(buffer->items[index & (buffer->capacity - 1)]), __ATOMIC_RELAXED);
+}
+
+static void _workstealingbuffer_put(WorkStealingBuffer* buffer, gint64 index, gpointer data) {
+    __atomic_store_n(&(buffer->items[index & (buffer->capacity - 1)]), data, __ATOMIC_RELAXED);
+}
+
+WorkStealingDeque* workstealingdeque_new(gsize initialCapacity) {
+    /* the buffer capacity must be a power of 2 so we can mask instead of mod */
+    gint64 capacity = 16;
+    while((gsize)capacity < initialCapacity) {
+        capacity *= 2;
+    }
+
+    WorkStealingDeque* deque = g_new0(WorkStealingDeque, 1);
+    deque->buffer = _workstealingbuffer_new(capacity);
+    return deque;
+}
+
+void workstealingdeque_free(WorkStealingDeque* deque) {
+    utility_assert(deque);
+    g_slist_free_full(deque->retiredBuffers, g_free);
+    g_free(deque->buffer);
+    g_free(deque);
+}
+
+gsize workstealingdeque_getLength(WorkStealingDeque* deque) {
+    utility_assert(deque);
+    gint64 b = __atomic_load_n(&(deque->bottom), __ATOMIC_SEQ_CST);
+    gint64 t = __atomic_load_n(&(deque->top), __ATOMIC_SEQ_CST);
+    return (b > t) ? (gsize)(b - t) : 0;
+}
+
+gboolean workstealingdeque_isEmpty(WorkStealingDeque* deque) {
+    return workstealingdeque_getLength(deque) == 0 ? TRUE : FALSE;
+}
+
+/* only called by the owner */
+static WorkStealingBuffer* _workstealingdeque_grow(WorkStealingDeque* deque,
+        WorkStealingBuffer* oldBuffer, gint64 top, gint64 bottom) {
+    WorkStealingBuffer* newBuffer = _workstealingbuffer_new(oldBuffer->capacity * 2);
+    for(gint64 i = top; i < bottom; i++) {
+        _workstealingbuffer_put(newBuffer, i, _workstealingbuffer_get(oldBuffer, i));
+    }
+
+    /* thieves that loaded the old buffer pointer may still read from it */
+    deque->retiredBuffers = g_slist_prepend(deque->retiredBuffers, oldBuffer);
+    __atomic_store_n(&(deque->buffer), newBuffer, __ATOMIC_RELEASE);
+    return newBuffer;
+}
+
+void workstealingdeque_push(WorkStealingDeque* deque, gpointer data) {
+    utility_assert(deque);
+    utility_assert(data);
+
+    gint64 b = __atomic_load_n(&(deque->bottom), __ATOMIC_RELAXED);
+    gint64 t = __atomic_load_n(&(deque->top), __ATOMIC_ACQUIRE);
+    WorkStealingBuffer* buffer = __atomic_load_n(&(deque->buffer), __ATOMIC_RELAXED);
+
+    if(b - t > buffer->capacity - 1) {
+        buffer = _workstealingdeque_grow(deque, buffer, t, b);
+    }
+
+    _workstealingbuffer_put(buffer, b, data);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&(deque->bottom), b + 1, __ATOMIC_RELAXED);
+}
+
+gpointer workstealingdeque_pop(WorkStealingDeque* deque) {
+    utility_assert(deque);
+
+    gint64 b = __atomic_load_n(&(deque->bottom), __ATOMIC_RELAXED) - 1;
+    WorkStealingBuffer* buffer = __atomic_load_n(&(deque->buffer), __ATOMIC_RELAXED);
+    __atomic_store_n(&(deque->bottom), b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    gint64 t = __atomic_load_n(&(deque->top), __ATOMIC_RELAXED);
+
+    gpointer data = NULL;
+
+    if(t <= b) {
+        /* non-empty */
+        data = _workstealingbuffer_get(buffer, b);
+        if(t == b) {
+            /* this is the last item, we race against the thieves for it */
+            if(!__atomic_compare_exchange_n(&(deque->top), &t, t + 1, FALSE,
+                    __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                /* a thief won */
+                data = NULL;
+            }
+            __atomic_store_n(&(deque->bottom), b + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        /* empty, restore the bottom index */
+        __atomic_store_n(&(deque->bottom), b + 1, __ATOMIC_RELAXED);
+    }
+
+    return data;
+}
+
+gpointer workstealingdeque_steal(WorkStealingDeque* deque) {
+    utility_assert(deque);
+
+    while(TRUE) {
+        gint64 t = __atomic_load_n(&(deque->top), __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        gint64 b = __atomic_load_n(&(deque->bottom), __ATOMIC_ACQUIRE);
+
+        if(t >= b) {
+            /* empty */
+            return NULL;
+        }
+
+        WorkStealingBuffer* buffer = __atomic_load_n(&(deque->buffer), __ATOMIC_ACQUIRE);
+        gpointer data = _workstealingbuffer_get(buffer, t);
+
+        if(__atomic_compare_exchange_n(&(deque->top), &t, t + 1, FALSE,
+                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            return data;
+        }
+
+        /* we lost the race to the owner or another thief, but someone made progress
+         * so we try again as long as there are still items left to take */
+    }
+}
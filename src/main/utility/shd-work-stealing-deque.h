@@ -0,0 +1,23 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#ifndef SHD_WORK_STEALING_DEQUE_H_
+#define SHD_WORK_STEALING_DEQUE_H_
+
+/* A lock-free Chase-Lev work-stealing deque. Only the owning thread may call
+ * push and pop, which operate on the bottom of the deque. Any other thread may
+ * call steal, which takes from the top of the deque. */
+typedef struct _WorkStealingDeque WorkStealingDeque;
+
+WorkStealingDeque* workstealingdeque_new(gsize initialCapacity);
+void workstealingdeque_free(WorkStealingDeque* deque);
+
+gsize workstealingdeque_getLength(WorkStealingDeque* deque);
+gboolean workstealingdeque_isEmpty(WorkStealingDeque* deque);
+void workstealingdeque_push(WorkStealingDeque* deque, gpointer data);
+gpointer workstealingdeque_pop(WorkStealingDeque* deque);
+gpointer workstealingdeque_steal(WorkStealingDeque* deque);
+
+#endif /* SHD_WORK_STEALING_DEQUE_H_ */
@@ -0,0 +1,309 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "shadow.h"
+
+/* built into the test so it can check that the queue does not move its slots around */
+#include "host/descriptor/shd-tcp-retransmit-queue.c"
+
+/* the queue only stores packets and releases them, so these stand in for the real ones */
+struct _Packet {
+    guint sequence;
+    gint referenceCount;
+};
+
+void packet_unref(Packet* packet) {
+    packet->referenceCount--;
+}
+
+void utility_handleError(const gchar* file, gint line, const gchar* function, const gchar* message) {
+    fprintf(stdout, "########## assertion failed in %s at %s:%i: %s\n", function, file, line, message);
+    abort();
+}
+
+#define NUM_PACKETS 512
+
+static Packet packets[NUM_PACKETS];
+
+static Packet* _test_packet(guint sequence) {
+    Packet* packet = &packets[sequence];
+    packet->sequence = sequence;
+    packet->referenceCount = 1;
+    return packet;
+}
+
+/* checks that exactly the packets with sequences in [first, last] are queued */
+static int _test_check_range(RetransmitQueue* queue, guint first, guint last) {
+    for(guint sequence = 0; sequence < NUM_PACKETS; sequence++) {
+        Packet* packet = retransmitqueue_get(queue, sequence);
+        gboolean isExpected = sequence >= first && sequence <= last;
+        if(isExpected && packet != &packets[sequence]) {
+            fprintf(stdout, "error: packet %u is not queued\n", sequence);
+            return -1;
+        } else if(!isExpected && packet != NULL) {
+            fprintf(stdout, "error: packet %u is queued but should not be\n", sequence);
+            return -1;
+        }
+    }
+    if(retransmitqueue_getLength(queue) != last - first + 1) {
+        fprintf(stdout, "error: queue length is %u, expected %u\n",
+                retransmitqueue_getLength(queue), last - first + 1);
+        return -1;
+    }
+    return 0;
+}
+
+/* a retransmitted packet may be queued again before the current head */
+static int _test_add_before_head() {
+    RetransmitQueue* queue = retransmitqueue_new();
+
+    for(guint sequence = 10; sequence <= 20; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+    retransmitqueue_add(queue, 5, _test_packet(5));
+    retransmitqueue_add(queue, 1, _test_packet(1));
+
+    if(retransmitqueue_getLength(queue) != 13 || retransmitqueue_get(queue, 1) != &packets[1] ||
+            retransmitqueue_get(queue, 5) != &packets[5] || retransmitqueue_get(queue, 4) != NULL) {
+        fprintf(stdout, "error: packets added before the head are not queued\n");
+        return -1;
+    }
+    for(guint sequence = 10; sequence <= 20; sequence++) {
+        if(retransmitqueue_get(queue, sequence) != &packets[sequence]) {
+            fprintf(stdout, "error: packet %u moved when adding before the head\n", sequence);
+            return -1;
+        }
+    }
+
+    /* the new head is the first packet out */
+    Packet* packet = retransmitqueue_popBefore(queue, 10);
+    if(packet != &packets[1] || retransmitqueue_popBefore(queue, 10) != &packets[5] ||
+            retransmitqueue_popBefore(queue, 10) != NULL) {
+        fprintf(stdout, "error: packets added before the head were not popped first\n");
+        return -1;
+    }
+    if(_test_check_range(queue, 10, 20) < 0) {
+        return -1;
+    }
+
+    retransmitqueue_free(queue);
+    return 0;
+}
+
+/* the head moves around the ring, and the ring grows while it is wrapped */
+static int _test_wrap_and_grow() {
+    RetransmitQueue* queue = retransmitqueue_new();
+
+    for(guint sequence = 1; sequence <= 40; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+    for(guint sequence = 1; sequence <= 30; sequence++) {
+        if(retransmitqueue_popBefore(queue, 31) != &packets[sequence]) {
+            fprintf(stdout, "error: packet %u was not popped in order\n", sequence);
+            return -1;
+        }
+    }
+
+    /* these wrap around the initial 64 slots, and then need more of them */
+    for(guint sequence = 41; sequence <= 90; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+        if(_test_check_range(queue, 31, sequence) < 0) {
+            return -1;
+        }
+    }
+    for(guint sequence = 91; sequence <= 400; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+    if(_test_check_range(queue, 31, 400) < 0) {
+        return -1;
+    }
+
+    retransmitqueue_free(queue);
+
+    /* freeing the queue releases its references */
+    for(guint sequence = 31; sequence <= 400; sequence++) {
+        if(packets[sequence].referenceCount != 0) {
+            fprintf(stdout, "error: packet %u was not released\n", sequence);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* stealing from the middle leaves holes that are skipped once they reach an end */
+static int _test_steal_and_trim() {
+    RetransmitQueue* queue = retransmitqueue_new();
+
+    for(guint sequence = 1; sequence <= 10; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+
+    if(retransmitqueue_steal(queue, 5) != &packets[5] || retransmitqueue_steal(queue, 5) != NULL ||
+            retransmitqueue_get(queue, 5) != NULL || retransmitqueue_getLength(queue) != 9) {
+        fprintf(stdout, "error: unable to steal a packet from the middle\n");
+        return -1;
+    }
+    if(retransmitqueue_steal(queue, 11) != NULL || retransmitqueue_steal(queue, 0) != NULL) {
+        fprintf(stdout, "error: stole a packet that was not queued\n");
+        return -1;
+    }
+
+    /* the head and tail skip over the hole */
+    for(guint sequence = 1; sequence <= 4; sequence++) {
+        retransmitqueue_steal(queue, sequence);
+    }
+    retransmitqueue_steal(queue, 10);
+    if(_test_check_range(queue, 6, 9) < 0) {
+        return -1;
+    }
+    if(retransmitqueue_popBefore(queue, 7) != &packets[6] || retransmitqueue_popBefore(queue, 7) != NULL) {
+        fprintf(stdout, "error: popped the wrong packets after trimming\n");
+        return -1;
+    }
+
+    /* holes inside the queue are kept, and filled again by later adds */
+    retransmitqueue_steal(queue, 8);
+    retransmitqueue_add(queue, 12, _test_packet(12));
+    if(retransmitqueue_get(queue, 8) != NULL || retransmitqueue_get(queue, 11) != NULL ||
+            retransmitqueue_getLength(queue) != 3) {
+        fprintf(stdout, "error: holes inside the queue are not empty\n");
+        return -1;
+    }
+    retransmitqueue_add(queue, 8, _test_packet(8));
+    if(retransmitqueue_get(queue, 8) != &packets[8]) {
+        fprintf(stdout, "error: unable to fill a hole inside the queue\n");
+        return -1;
+    }
+
+    retransmitqueue_free(queue);
+    return 0;
+}
+
+/* retransmitting the first packet steals it and queues it again before the new head,
+ * which reuses the free slots in the ring instead of copying them */
+static int _test_retransmit_head() {
+    RetransmitQueue* queue = retransmitqueue_new();
+    Packet** slots = queue->slots;
+    guint capacity = queue->capacity;
+
+    for(guint sequence = 1; sequence <= 40; sequence++) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+
+    /* the head starts in the first slot, so moving it back wraps around the ring */
+    for(guint round = 0; round < 1000; round++) {
+        Packet* packet = retransmitqueue_steal(queue, 1);
+        if(packet != &packets[1] || retransmitqueue_get(queue, 1) != NULL) {
+            fprintf(stdout, "error: unable to steal the first packet in round %u\n", round);
+            return -1;
+        }
+        retransmitqueue_add(queue, 1, packet);
+        if(queue->slots != slots || queue->capacity != capacity) {
+            fprintf(stdout, "error: the slots were reallocated in round %u\n", round);
+            return -1;
+        }
+    }
+    if(_test_check_range(queue, 1, 40) < 0) {
+        return -1;
+    }
+
+    /* several packets at once, after the head has moved */
+    for(guint sequence = 1; sequence <= 10; sequence++) {
+        Packet* packet = retransmitqueue_popBefore(queue, 11);
+        if(packet != &packets[sequence]) {
+            fprintf(stdout, "error: packet %u was not popped in order\n", sequence);
+            return -1;
+        }
+        packet_unref(packet);
+    }
+    for(guint sequence = 10; sequence >= 3; sequence--) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+    if(queue->slots != slots || queue->capacity != capacity) {
+        fprintf(stdout, "error: the slots were reallocated when re-queueing several packets\n");
+        return -1;
+    }
+    if(_test_check_range(queue, 3, 40) < 0) {
+        return -1;
+    }
+
+    retransmitqueue_free(queue);
+    return 0;
+}
+
+/* a cumulative ACK past every sequence empties the queue */
+static int _test_pop_all() {
+    RetransmitQueue* queue = retransmitqueue_new();
+
+    for(guint sequence = 100; sequence < 200; sequence += 3) {
+        retransmitqueue_add(queue, sequence, _test_packet(sequence));
+    }
+
+    guint expected = 100;
+    Packet* packet = NULL;
+    while((packet = retransmitqueue_popBefore(queue, G_MAXUINT)) != NULL) {
+        if(packet->sequence != expected) {
+            fprintf(stdout, "error: popped packet %u, expected %u\n", packet->sequence, expected);
+            return -1;
+        }
+        expected += 3;
+    }
+    if(expected < 200 || retransmitqueue_getLength(queue) != 0 ||
+            retransmitqueue_get(queue, 100) != NULL) {
+        fprintf(stdout, "error: the queue is not empty after popping everything\n");
+        return -1;
+    }
+
+    /* an empty queue starts over at whatever sequence comes next */
+    retransmitqueue_add(queue, 7, _test_packet(7));
+    if(_test_check_range(queue, 7, 7) < 0) {
+        return -1;
+    }
+
+    /* adding a packet with the same sequence replaces and releases the old one */
+    Packet* old = &packets[7];
+    Packet replacement = {7, 1};
+    retransmitqueue_add(queue, 7, &replacement);
+    if(old->referenceCount != 0 || retransmitqueue_get(queue, 7) != &replacement ||
+            retransmitqueue_getLength(queue) != 1) {
+        fprintf(stdout, "error: the replaced packet was not released\n");
+        return -1;
+    }
+    retransmitqueue_steal(queue, 7);
+
+    retransmitqueue_free(queue);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## retransmit-queue test starting ##########\n");
+
+    if(_test_add_before_head() < 0) {
+        fprintf(stdout, "########## _test_add_before_head() failed\n");
+        return -1;
+    }
+    if(_test_wrap_and_grow() < 0) {
+        fprintf(stdout, "########## _test_wrap_and_grow() failed\n");
+        return -1;
+    }
+    if(_test_steal_and_trim() < 0) {
+        fprintf(stdout, "########## _test_steal_and_trim() failed\n");
+        return -1;
+    }
+    if(_test_retransmit_head() < 0) {
+        fprintf(stdout, "########## _test_retransmit_head() failed\n");
+        return -1;
+    }
+    if(_test_pop_all() < 0) {
+        fprintf(stdout, "########## _test_pop_all() failed\n");
+        return -1;
+    }
+
+    fprintf(stdout, "########## retransmit-queue test passed! ##########\n");
+    return 0;
+}
@@ -0,0 +1,456 @@
+/*
+ * The Shadow Simulator
+ * See LICENSE for licensing information
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shadow.h"
+
+/* the scoreboard only logs warnings, which we count to compare with the reference */
+static guint numWarnings = 0;
+
+Logger* logger_getDefault() {
+    return NULL;
+}
+
+void logger_log(Logger* logger, LogLevel level, const gchar* fileName, const gchar* functionName,
+        const gint lineNumber, const gchar *format, ...) {
+    if(level == LOGLEVEL_WARNING) {
+        numWarnings++;
+    }
+}
+
+void utility_handleError(const gchar* file, gint line, const gchar* function, const gchar* message) {
+    fprintf(stdout, "########## assertion failed in %s at %s:%i: %s\n", function, file, line, message);
+    abort();
+}
+
+/* all sequences in the random tests stay below this */
+#define MAX_SEQUENCE 300
+
+/* the scoreboard as it was before it tracked ranges of packets: one block per sequence,
+ * and every operation walks the sequences one at a time */
+typedef enum _TestStatus TestStatus;
+enum _TestStatus {
+    TEST_STATUS_INFLIGHT,
+    TEST_STATUS_SACKED,
+    TEST_STATUS_LOST,
+    TEST_STATUS_RETRANSMITTED,
+};
+
+typedef struct _TestBlock TestBlock;
+struct _TestBlock {
+    gboolean exists;
+    TestStatus status;
+    gint nextSend;
+    gint retransmissionId;
+};
+
+typedef struct _TestScoreBoard TestScoreBoard;
+struct _TestScoreBoard {
+    TestBlock blocks[MAX_SEQUENCE];
+    gint fack;
+    gint fackOut;
+    gint retransmissionId;
+    gint ackedRetransmissionId;
+    gint lastAcknowledgment;
+    gint duplicateACKCount;
+    guint numWarnings;
+};
+
+static void _test_addBlock(TestScoreBoard* reference, gint sequence, TestStatus status) {
+    TestBlock block = {TRUE, status, 0, 0};
+    reference->blocks[sequence] = block;
+}
+
+static TCPProcessFlags _test_update(TestScoreBoard* reference, const gboolean* isSACKed,
+        gint unacked, gint next) {
+    TCPProcessFlags flag = TCP_PF_NONE;
+
+    for(gint sequence = 0; sequence < unacked; sequence++) {
+        reference->blocks[sequence].exists = FALSE;
+    }
+
+    gint firstSACK = -1, lastSACK = -1;
+    for(gint sequence = 0; sequence < MAX_SEQUENCE; sequence++) {
+        if(isSACKed[sequence]) {
+            firstSACK = firstSACK < 0 ? sequence : firstSACK;
+            lastSACK = sequence;
+        }
+    }
+
+    if(firstSACK >= 0) {
+        gint firstSeq = MAX(unacked, firstSACK);
+        gint lastSeq = next > 0 ? MIN(next - 1, lastSACK) : 0;
+        reference->fack = MAX(reference->fack, lastSeq);
+
+        for(gint sequence = firstSeq; sequence <= lastSeq; sequence++) {
+            TestBlock* block = &reference->blocks[sequence];
+            if(!block->exists) {
+                _test_addBlock(reference, sequence, isSACKed[sequence] ? TEST_STATUS_SACKED : TEST_STATUS_INFLIGHT);
+                flag |= TCP_PF_DATA_SACKED;
+            } else if(isSACKed[sequence]) {
+                if(block->status == TEST_STATUS_RETRANSMITTED) {
+                    reference->ackedRetransmissionId = block->retransmissionId;
+                }
+                block->status = TEST_STATUS_SACKED;
+            }
+        }
+    }
+
+    if(reference->lastAcknowledgment == unacked) {
+        reference->duplicateACKCount++;
+    } else {
+        reference->duplicateACKCount = 0;
+    }
+    reference->lastAcknowledgment = unacked;
+
+    for(gint sequence = 0; sequence < MAX_SEQUENCE; sequence++) {
+        TestBlock* block = &reference->blocks[sequence];
+        if(!block->exists) {
+            continue;
+        }
+        gboolean isLost = FALSE;
+        if(block->status == TEST_STATUS_INFLIGHT) {
+            isLost = sequence <= reference->fack - 4 || (sequence == reference->lastAcknowledgment &&
+                    reference->duplicateACKCount == 3);
+        } else if(block->status == TEST_STATUS_RETRANSMITTED) {
+            isLost = block->nextSend <= reference->fack ||
+                    block->retransmissionId + 4 < reference->ackedRetransmissionId;
+        }
+        if(isLost) {
+            block->status = TEST_STATUS_LOST;
+            reference->fackOut++;
+            flag |= TCP_PF_DATA_LOST;
+        }
+    }
+
+    return flag;
+}
+
+static gint _test_getNextRetransmit(TestScoreBoard* reference) {
+    for(gint sequence = 0; sequence < MAX_SEQUENCE; sequence++) {
+        if(reference->blocks[sequence].exists && reference->blocks[sequence].status == TEST_STATUS_LOST) {
+            return sequence;
+        }
+    }
+    return -1;
+}
+
+static void _test_markRetransmitted(TestScoreBoard* reference, gint sequence, gint nextSend) {
+    TestBlock* block = &reference->blocks[sequence];
+    if(!block->exists) {
+        reference->numWarnings++;
+        return;
+    }
+    reference->fackOut--;
+    if(reference->fackOut < 0) {
+        reference->numWarnings++;
+    }
+    block->status = TEST_STATUS_RETRANSMITTED;
+    block->nextSend = nextSend;
+    block->retransmissionId = reference->retransmissionId++;
+}
+
+static void _test_packetDropped(TestScoreBoard* reference, gint sequence) {
+    TestBlock* block = &reference->blocks[sequence];
+    if(!block->exists) {
+        _test_addBlock(reference, sequence, TEST_STATUS_INFLIGHT);
+    }
+    if(block->status != TEST_STATUS_INFLIGHT) {
+        return;
+    }
+    block->status = TEST_STATUS_LOST;
+    reference->fackOut++;
+}
+
+static void _test_markLoss(TestScoreBoard* reference, gint unacked, gint nextSend) {
+    gint tail = -1;
+    for(gint sequence = 0; sequence < MAX_SEQUENCE; sequence++) {
+        TestBlock* block = &reference->blocks[sequence];
+        if(!block->exists) {
+            continue;
+        }
+        tail = sequence;
+        if(block->status != TEST_STATUS_SACKED) {
+            if(block->status != TEST_STATUS_LOST) {
+                reference->fackOut++;
+            }
+            block->status = TEST_STATUS_LOST;
+        }
+    }
+
+    gint start = tail >= 0 ? tail + 1 : unacked;
+    TestStatus status = tail >= 0 ? TEST_STATUS_INFLIGHT : TEST_STATUS_LOST;
+    for(gint sequence = start; sequence < nextSend; sequence++) {
+        _test_addBlock(reference, sequence, status);
+        if(status == TEST_STATUS_LOST) {
+            reference->fackOut++;
+        }
+    }
+
+    reference->retransmissionId = 0;
+    reference->ackedRetransmissionId = -1;
+}
+
+static void _test_clear(TestScoreBoard* reference) {
+    memset(reference->blocks, 0, sizeof(reference->blocks));
+    reference->retransmissionId = 0;
+    reference->ackedRetransmissionId = -1;
+    reference->fack = 0;
+    reference->fackOut = 0;
+}
+
+/* runs random ACKs, SACKs, drops, retransmits, and losses through both scoreboards and
+ * checks that they agree on everything a TCP connection can observe */
+static int _test_scoreboard_random() {
+    GRand* random = g_rand_new_with_seed(7);
+
+    for(guint trial = 0; trial < 2000; trial++) {
+        ScoreBoard* scoreboard = scoreboard_new();
+        TestScoreBoard* reference = g_new0(TestScoreBoard, 1);
+        numWarnings = 0;
+
+        gint unacked = 1, next = 1;
+
+        for(guint step = 0; step < 60; step++) {
+            gint op = g_rand_int_range(random, 0, 20);
+
+            if(op < 10) {
+                /* an ACK, usually with some SACKs. MIN evaluates its arguments twice,
+                 * so the random numbers are drawn first */
+                gint nSent = g_rand_int_range(random, 0, 8);
+                next = MIN(MAX_SEQUENCE - 10, next + nSent);
+                if(g_rand_int_range(random, 0, 3) == 0) {
+                    gint nACKed = g_rand_int_range(random, 0, 5);
+                    unacked = MIN(next, unacked + nACKed);
+                }
+
+                gboolean isSACKed[MAX_SEQUENCE] = {FALSE};
+                RangeSet* selectiveACKs = rangeset_new();
+                gint nSACKs = g_rand_int_range(random, 0, 6);
+                for(gint i = 0; i < nSACKs; i++) {
+                    /* sometimes past what we sent, like a confused or malicious peer */
+                    gint offset = g_rand_int_range(random, 0, next - unacked + 6);
+                    gint sequence = MIN(MAX_SEQUENCE - 1, unacked + offset);
+                    isSACKed[sequence] = TRUE;
+                    rangeset_add(selectiveACKs, (guint)sequence);
+                }
+
+                TCPProcessFlags expected = _test_update(reference, isSACKed, unacked, next);
+                TCPProcessFlags flags = scoreboard_update(scoreboard,
+                        rangeset_isEmpty(selectiveACKs) ? NULL : selectiveACKs, unacked, next);
+                rangeset_free(selectiveACKs);
+
+                if(flags != expected) {
+                    fprintf(stdout, "error: trial %u step %u: update returned %i, expected %i\n",
+                            trial, step, (gint)flags, (gint)expected);
+                    return -1;
+                }
+            } else if(op < 14) {
+                /* retransmit the next lost packet */
+                gint sequence = _test_getNextRetransmit(reference);
+                if(sequence >= 0) {
+                    _test_markRetransmitted(reference, sequence, next);
+                    scoreboard_markRetransmitted(scoreboard, sequence, next);
+                }
+            } else if(op < 16) {
+                gint sequence = unacked + g_rand_int_range(random, 0, next - unacked + 1);
+                _test_packetDropped(reference, sequence);
+                scoreboard_packetDropped(scoreboard, sequence);
+            } else if(op < 18) {
+                /* a retransmit of any packet, including ones the scoreboard does not have */
+                gint sequence = unacked + g_rand_int_range(random, 0, next - unacked + 1);
+                _test_markRetransmitted(reference, sequence, next);
+                scoreboard_markRetransmitted(scoreboard, sequence, next);
+            } else if(op < 19) {
+                _test_markLoss(reference, unacked, next);
+                scoreboard_markLoss(scoreboard, unacked, next);
+            } else {
+                _test_clear(reference);
+                scoreboard_clear(scoreboard);
+            }
+
+            gint expectedNext = _test_getNextRetransmit(reference);
+            gint nextRetransmit = scoreboard_getNextRetransmit(scoreboard);
+            if(nextRetransmit != expectedNext) {
+                fprintf(stdout, "error: trial %u step %u: next retransmit is %i, expected %i\n",
+                        trial, step, nextRetransmit, expectedNext);
+                return -1;
+            }
+            if(numWarnings != reference->numWarnings) {
+                fprintf(stdout, "error: trial %u step %u: %u warnings, expected %u\n",
+                        trial, step, numWarnings, reference->numWarnings);
+                return -1;
+            }
+        }
+
+        scoreboard_free(scoreboard);
+        g_free(reference);
+    }
+
+    g_rand_free(random);
+    return 0;
+}
+
+/* checks that the set holds exactly the values between first and last that are set in
+ * isMember, as sorted ranges that neither overlap nor touch */
+static int _test_rangeset_check(RangeSet* set, const gboolean* isMember, guint first, guint last) {
+    guint previousEnd = 0;
+    for(guint i = 0; i < rangeset_getNumRanges(set); i++) {
+        guint start = 0, end = 0;
+        rangeset_getRange(set, i, &start, &end);
+        if(start >= end || (i > 0 && start <= previousEnd)) {
+            fprintf(stdout, "error: range %u [%u, %u) is empty or touches the one before\n", i, start, end);
+            return -1;
+        }
+        previousEnd = end;
+    }
+
+    for(guint value = first; value <= last; value++) {
+        gboolean isInSet = rangeset_getRangeEnd(set, value) != value;
+        if(isInSet != isMember[value - first]) {
+            fprintf(stdout, "error: value %u is %s the set\n", value, isInSet ? "wrongly in" : "missing from");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int _test_rangeset_edges() {
+    RangeSet* set = rangeset_new();
+    guint start = 0, end = 0;
+
+    if(!rangeset_isEmpty(set) || rangeset_getRangeEnd(set, 0) != 0 || rangeset_find(set, 10) != 0) {
+        fprintf(stdout, "error: a new set is not empty\n");
+        return -1;
+    }
+
+    /* adding below, above, and between ranges extends and merges them */
+    rangeset_add(set, 10);
+    rangeset_add(set, 10);
+    rangeset_add(set, 9);
+    rangeset_add(set, 11);
+    rangeset_add(set, 14);
+    if(rangeset_getNumRanges(set) != 2 || rangeset_getRangeEnd(set, 9) != 12 || rangeset_getRangeEnd(set, 14) != 15) {
+        fprintf(stdout, "error: adjacent values were not merged\n");
+        return -1;
+    }
+    rangeset_add(set, 13);
+    rangeset_add(set, 12);
+    rangeset_getRange(set, 0, &start, &end);
+    if(rangeset_getNumRanges(set) != 1 || start != 9 || end != 15) {
+        fprintf(stdout, "error: filling the gap did not merge the ranges\n");
+        return -1;
+    }
+
+    /* the extremes of the values we can store */
+    rangeset_add(set, 0);
+    rangeset_add(set, G_MAXUINT - 1);
+    if(rangeset_getNumRanges(set) != 3 || rangeset_getRangeEnd(set, 0) != 1 ||
+            rangeset_getRangeEnd(set, G_MAXUINT - 1) != G_MAXUINT) {
+        fprintf(stdout, "error: unable to add the smallest and largest values\n");
+        return -1;
+    }
+
+    /* a copy does not change with the original */
+    RangeSet* copy = rangeset_copy(set);
+
+    /* removing below a range, inside one, at its end, and past everything */
+    rangeset_removeBelow(set, 0);
+    if(rangeset_getNumRanges(set) != 3) {
+        fprintf(stdout, "error: removing below 0 changed the set\n");
+        return -1;
+    }
+    rangeset_removeBelow(set, 5);
+    rangeset_getRange(set, 0, &start, &end);
+    if(rangeset_getNumRanges(set) != 2 || start != 9 || end != 15) {
+        fprintf(stdout, "error: removing between ranges left the wrong ranges\n");
+        return -1;
+    }
+    rangeset_removeBelow(set, 12);
+    rangeset_getRange(set, 0, &start, &end);
+    if(rangeset_getNumRanges(set) != 2 || start != 12 || end != 15 || rangeset_getRangeEnd(set, 11) != 11) {
+        fprintf(stdout, "error: removing inside a range did not trim it\n");
+        return -1;
+    }
+    rangeset_removeBelow(set, 15);
+    if(rangeset_getNumRanges(set) != 1 || rangeset_find(set, 15) != 0) {
+        fprintf(stdout, "error: removing at the end of a range did not drop it\n");
+        return -1;
+    }
+    rangeset_removeBelow(set, G_MAXUINT);
+    if(!rangeset_isEmpty(set)) {
+        fprintf(stdout, "error: removing everything left values in the set\n");
+        return -1;
+    }
+
+    if(rangeset_getNumRanges(copy) != 3 || rangeset_getRangeEnd(copy, 12) != 15) {
+        fprintf(stdout, "error: changing the set changed its copy\n");
+        return -1;
+    }
+
+    rangeset_free(copy);
+    rangeset_free(set);
+    return 0;
+}
+
+/* random adds and removes against a plain array of flags */
+static int _test_rangeset_random() {
+    GRand* random = g_rand_new_with_seed(11);
+    const guint first = 1000, numValues = 200;
+
+    for(guint trial = 0; trial < 500; trial++) {
+        RangeSet* set = rangeset_new();
+        gboolean isMember[200] = {FALSE};
+        guint removedBelow = first;
+
+        for(guint step = 0; step < 100; step++) {
+            if(g_rand_int_range(random, 0, 8) == 0) {
+                guint value = first + g_rand_int_range(random, 0, numValues);
+                rangeset_removeBelow(set, value);
+                for(guint i = 0; i < value - first; i++) {
+                    isMember[i] = FALSE;
+                }
+                removedBelow = MAX(removedBelow, value);
+            } else {
+                guint value = removedBelow + g_rand_int_range(random, 0, first + numValues - removedBelow);
+                rangeset_add(set, value);
+                isMember[value - first] = TRUE;
+            }
+
+            if(_test_rangeset_check(set, isMember, first, first + numValues - 1) < 0) {
+                fprintf(stdout, "error: trial %u step %u\n", trial, step);
+                return -1;
+            }
+        }
+
+        rangeset_free(set);
+    }
+
+    g_rand_free(random);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    fprintf(stdout, "########## scoreboard test starting ##########\n");
+
+    if(_test_rangeset_edges() < 0) {
+        fprintf(stdout, "########## _test_rangeset_edges() failed\n");
+        return -1;
+    }
+    if(_test_rangeset_random() < 0) {
+        fprintf(stdout, "########## _test_rangeset_random() failed\n");
+        return -1;
+    }
+    if(_test_scoreboard_random() < 0) {
+        fprintf(stdout, "########## _test_scoreboard_random() failed\n");
+        return -1;
+    }
+
+    fprintf(stdout, "########## scoreboard test passed! ##########\n");
+    return 0;
+}